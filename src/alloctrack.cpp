@@ -0,0 +1,260 @@
+#include "./alloctrack.h"
+#include "./stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#ifdef __GLIBC__
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::atomic<bool> tracking(false);
+    std::atomic<std::uint64_t> totalAllocations(0), totalBytes(0);
+    std::uint64_t frameAllocations = 0, frameBytes = 0;   // Totals at the last endFrame
+
+    // Per thread, for scopes
+    thread_local std::uint64_t threadAllocations = 0;
+    thread_local std::uint64_t threadBytes = 0;
+
+    // Fixed storage throughout, allocating here would count itself
+    const int MAX_SCOPES = 32;
+    const int MAX_NAME = 64;
+
+    struct ScopeEntry {
+        const char* name;
+        char bytesName[MAX_NAME];       // name with _kb appended, Stats keeps the pointer
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+    };
+
+    ScopeEntry scopes[MAX_SCOPES];
+    int scopeCount = 0;
+    std::mutex scopeMutex;
+
+    const int MAX_SAMPLES = 256;
+    const int MAX_DEPTH = 16;
+
+    struct Sample {
+        void* frames[MAX_DEPTH];
+        int depth;
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+    };
+
+    Sample samples[MAX_SAMPLES];
+    int sampleCount = 0;
+    std::uint64_t unrecorded = 0;   // Samples that didn't fit the table
+    std::atomic_flag sampleLock = ATOMIC_FLAG_INIT;
+    std::uint64_t sampleEvery = 0;
+    thread_local bool sampling = false;
+
+    void recordStack(std::size_t size) {
+#ifdef __GLIBC__
+        void* frames[MAX_DEPTH + 2];
+        sampling = true;
+        int depth = backtrace(frames, MAX_DEPTH + 2);
+        sampling = false;
+
+        // Leave out the hook and operator new
+        int skip = std::min(depth, 2);
+        depth -= skip;
+
+        while (sampleLock.test_and_set(std::memory_order_acquire)) {
+        }
+        Sample *sample = nullptr;
+        for (int i = 0; i < sampleCount && !sample; i++) {
+            if (samples[i].depth == depth && std::memcmp(samples[i].frames, frames + skip, depth * sizeof(void*)) == 0) {
+                sample = &samples[i];
+            }
+        }
+        if (!sample && sampleCount < MAX_SAMPLES) {
+            sample = &samples[sampleCount++];
+            std::memcpy(sample->frames, frames + skip, depth * sizeof(void*));
+            sample->depth = depth;
+            sample->allocations = 0;
+            sample->bytes = 0;
+        }
+        if (sample) {
+            sample->allocations++;
+            sample->bytes += size;
+        } else {
+            unrecorded++;
+        }
+        sampleLock.clear(std::memory_order_release);
+#endif
+    }
+
+    void count(std::size_t size) {
+        if (!tracking.load(std::memory_order_relaxed) || sampling) {
+            return;
+        }
+        std::uint64_t index = totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        totalBytes.fetch_add(size, std::memory_order_relaxed);
+        threadAllocations++;
+        threadBytes += size;
+        if (sampleEvery > 0 && index % sampleEvery == 0) {
+            recordStack(size);
+        }
+    }
+
+    void* allocate(std::size_t size) {
+        count(size);
+        void *pointer = std::malloc(size ? size : 1);
+        if (!pointer) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+        count(size);
+        void *pointer = nullptr;
+        std::size_t align = std::max((std::size_t)alignment, sizeof(void*));
+        if (posix_memalign(&pointer, align, size ? size : 1) != 0) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+
+// Both kinds come from malloc, so every delete is a free
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+void AllocTrack::enable(int every) {
+#ifdef __GLIBC__
+    // The first backtrace loads the unwinder, get that out of the way before counting
+    void* frames[1];
+    backtrace(frames, 1);
+#endif
+    sampleEvery = every > 0 ? (std::uint64_t)every : 0;
+    frameAllocations = totalAllocations.load();
+    frameBytes = totalBytes.load();
+    tracking.store(true);
+}
+
+bool AllocTrack::enabled() {
+    return tracking.load(std::memory_order_relaxed);
+}
+
+std::uint64_t AllocTrack::allocations() {
+    return totalAllocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t AllocTrack::bytes() {
+    return totalBytes.load(std::memory_order_relaxed);
+}
+
+void AllocTrack::endFrame() {
+    if (!enabled()) {
+        return;
+    }
+    std::uint64_t allocations = AllocTrack::allocations();
+    std::uint64_t bytes = AllocTrack::bytes();
+    Stats::set("alloc_count", (double)(allocations - frameAllocations));
+    Stats::set("alloc_kb", (bytes - frameBytes) / 1024.0);
+    frameAllocations = allocations;
+    frameBytes = bytes;
+
+    std::lock_guard<std::mutex> lock(scopeMutex);
+    for (int i = 0; i < scopeCount; i++) {
+        Stats::set(scopes[i].name, (double)scopes[i].allocations);
+        Stats::set(scopes[i].bytesName, scopes[i].bytes / 1024.0);
+        scopes[i].allocations = 0;
+        scopes[i].bytes = 0;
+    }
+}
+
+void AllocTrack::report() {
+    if (sampleEvery == 0) {
+        return;
+    }
+
+    while (sampleLock.test_and_set(std::memory_order_acquire)) {
+    }
+    int order[MAX_SAMPLES];
+    for (int i = 0; i < sampleCount; i++) {
+        order[i] = i;
+    }
+    std::sort(order, order + sampleCount, [](int a, int b) {
+        return samples[a].allocations > samples[b].allocations;
+    });
+
+    std::printf("ALLOCTRACK::REPORT allocations=%llu bytes=%llu sample_every=%llu unrecorded=%llu\n",
+        (unsigned long long)allocations(), (unsigned long long)bytes(), (unsigned long long)sampleEvery, (unsigned long long)unrecorded);
+    const int SHOWN = 10;
+    for (int i = 0; i < std::min(sampleCount, SHOWN); i++) {
+        const Sample &sample = samples[order[i]];
+        std::printf("ALLOCTRACK::STACK sampled=%llu bytes=%llu\n", (unsigned long long)sample.allocations, (unsigned long long)sample.bytes);
+        std::fflush(stdout);
+#ifdef __GLIBC__
+        // Writes straight to the descriptor, without allocating
+        backtrace_symbols_fd(sample.frames, sample.depth, STDOUT_FILENO);
+#endif
+    }
+    std::fflush(stdout);
+    sampleLock.clear(std::memory_order_release);
+}
+
+AllocTrack::Scope::Scope(const char* name) : name(name), startAllocations(threadAllocations), startBytes(threadBytes) {
+}
+
+AllocTrack::Scope::~Scope() {
+    if (!enabled()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(scopeMutex);
+    ScopeEntry *entry = nullptr;
+    for (int i = 0; i < scopeCount && !entry; i++) {
+        if (scopes[i].name == name || std::strcmp(scopes[i].name, name) == 0) {
+            entry = &scopes[i];
+        }
+    }
+    if (!entry && scopeCount < MAX_SCOPES) {
+        entry = &scopes[scopeCount++];
+        entry->name = name;
+        std::snprintf(entry->bytesName, MAX_NAME, "%s_kb", name);
+        entry->allocations = 0;
+        entry->bytes = 0;
+    }
+    if (entry) {
+        entry->allocations += threadAllocations - startAllocations;
+        entry->bytes += threadBytes - startBytes;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Heap allocation tracking. The global operator new and delete are replaced
+ * so every allocation can be counted once tracking is enabled; before that
+ * they go straight to malloc. Counts are kept over all threads for whole
+ * frames and per thread for scopes, and a sampled subset of allocations can
+ * have its call stack recorded to find out where they come from.
+ */
+
+namespace AllocTrack {
+    // Start counting. With sampleEvery > 0 the stack of every sampleEvery-th allocation is recorded too
+    extern void enable(int sampleEvery = 0);
+    extern bool enabled();
+
+    // Totals over every thread since enable
+    extern std::uint64_t allocations();
+    extern std::uint64_t bytes();
+
+    // Publish the allocations since the last call, and every scope's, to Stats
+    extern void endFrame();
+
+    // Print the sampled call stacks, most allocations first
+    extern void report();
+
+    // Counts what the constructing thread allocates while it lives, reported to Stats under name and
+    // the kilobytes under name_kb. Names must be string literals
+    class Scope
+    {
+        public:
+            explicit Scope(const char* name);
+            ~Scope();
+
+        private:
+            const char* name;
+            std::uint64_t startAllocations;
+            std::uint64_t startBytes;
+    };
+}
@@ -0,0 +1,801 @@
+#include "./bench.h"
+#include "./renderthread.h"
+#include "./renderer.h"
+#include "./simulation.h"
+#include "./scene.h"
+#include "./camera.h"
+#include "./window.h"
+#include "./config.h"
+#include "./nullgl.h"
+#include "./alloctrack.h"
+#include "./stats.h"
+#include "./voxels.h"
+#include "./streaming.h"
+#include "./occlusion.h"
+#include "./bvh.h"
+#include "./picking.h"
+#include "./jobs.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<std::uint8_t> pixels;   // RGB, top row first
+    };
+
+    struct BenchScene {
+        const char *name;
+        void (*populate)(glm::vec3 &lightPos);
+        CameraState (*path)(float t);   // Camera at t in [0, 1]
+        void (*animate)(float t);       // Moves instances for t in [0, 1], may be null
+    };
+
+    // Same sun as the interactive run
+    const glm::vec3 SUN_DIRECTION = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
+
+    // Camera at position looking at target
+    CameraState lookAt(const glm::vec3 &position, const glm::vec3 &target) {
+        glm::vec3 direction = glm::normalize(target - position);
+        CameraState state;
+        state.position = position;
+        state.yaw = glm::degrees(std::atan2(direction.z, direction.x));
+        state.pitch = glm::degrees(std::asin(direction.y));
+        state.zoom = ZOOM;
+        return state;
+    }
+
+    // The default scene: one lit cube and the lamp
+    void populateCube(glm::vec3 &lightPos) {
+        lightPos = glm::vec3(1.2f, 1.0f, 2.0f);
+        Scene::addStatic(glm::vec3(0.0f), glm::vec3(1.0f));
+        Scene::add(lightPos, glm::vec3(0.2f), Scene::LAMP);
+    }
+
+    CameraState orbitCube(float t) {
+        float angle = t * glm::two_pi<float>();
+        return lookAt(glm::vec3(3.0f * std::sin(angle), 0.5f, 3.0f * std::cos(angle)), glm::vec3(0.0f));
+    }
+
+    // A block of cubes spanning several partitions
+    void populateGrid(glm::vec3 &lightPos) {
+        const int SIZE = 16, LAYERS = 4;
+        const float SPACING = 2.0f;
+        lightPos = glm::vec3(0.0f, 12.0f, 0.0f);
+        for (int y = 0; y < LAYERS; y++) {
+            for (int z = 0; z < SIZE; z++) {
+                for (int x = 0; x < SIZE; x++) {
+                    glm::vec3 position((x - SIZE / 2) * SPACING, y * SPACING, (z - SIZE / 2) * SPACING);
+                    Scene::addStatic(position, glm::vec3(1.0f));
+                }
+            }
+        }
+        Scene::add(lightPos, glm::vec3(1.0f), Scene::LAMP);
+    }
+
+    // The grid lit by many small point lights, at a few counts to compare the forward and deferred paths
+    template<std::size_t COUNT>
+    void populateLights(glm::vec3 &lightPos) {
+        populateGrid(lightPos);
+        Scene::addRandomLights(COUNT, glm::vec3(-17.0f, -1.0f, -17.0f), glm::vec3(15.0f, 7.0f, 15.0f), 2.0f, 7);
+    }
+
+    // The grid with cubes circling above it, so only the shadow regions they pass through need redrawing
+    const std::size_t MOVERS = 8;
+    std::size_t firstMover = 0;
+
+    void populateMovers(glm::vec3 &lightPos) {
+        populateGrid(lightPos);
+        firstMover = Scene::instances.size();
+        for (std::size_t i = 0; i < MOVERS; i++) {
+            Scene::add(glm::vec3(0.0f, 9.0f, 0.0f), glm::vec3(1.0f), Scene::LIT);
+        }
+    }
+
+    void circleMovers(float t) {
+        for (std::size_t i = 0; i < MOVERS; i++) {
+            float angle = t * glm::two_pi<float>() + i * glm::two_pi<float>() / MOVERS;
+            Scene::instances[firstMover + i].position = glm::vec3(6.0f * std::sin(angle), 9.0f, 6.0f * std::cos(angle));
+        }
+    }
+
+    // Voxel terrain of 6 by 2 by 6 chunks
+    void populateTerrain(glm::vec3 &lightPos) {
+        lightPos = glm::vec3(0.0f, 20.0f, 0.0f);
+        Voxels::build(glm::ivec3(-3, -1, -3), glm::ivec3(3, 1, 3), 7);
+        Scene::add(lightPos, glm::vec3(1.0f), Scene::LAMP);
+    }
+
+    CameraState orbitTerrain(float t) {
+        float angle = t * glm::two_pi<float>();
+        return lookAt(glm::vec3(80.0f * std::sin(angle), 20.0f, 80.0f * std::cos(angle)), glm::vec3(0.0f, -16.0f, 0.0f));
+    }
+
+    // Terrain streamed in under a camera flying over it, far enough that the first chunks get evicted
+    void populateStreaming(glm::vec3 &lightPos) {
+        lightPos = glm::vec3(0.0f, 20.0f, -320.0f);
+        Scene::add(lightPos, glm::vec3(1.0f), Scene::LAMP);
+        Streaming::start(4, 24 * 1024 * 1024, 7);
+    }
+
+    CameraState flyTerrain(float t) {
+        glm::vec3 position(0.0f, 6.0f, glm::mix(0.0f, -320.0f, t));
+        return lookAt(position, position + glm::vec3(0.3f, -0.4f, -1.0f));
+    }
+
+    // Mesh every chunk again one at a time, with and without merging, for triangles and milliseconds per chunk
+    struct MeshingResult {
+        double triangles, milliseconds;
+    };
+
+    MeshingResult measureMeshing(bool greedy) {
+        // Neighbours by coordinate, outside the timing
+        std::size_t count = Voxels::chunks.size();
+        std::vector<std::array<const Voxels::Chunk*, 6>> neighbours(count);
+        for (std::size_t i = 0; i < count; i++) {
+            neighbours[i].fill(nullptr);
+            for (const Voxels::Chunk &other : Voxels::chunks) {
+                glm::ivec3 delta = other.coord - Voxels::chunks[i].coord;
+                for (int f = 0; f < 6; f++) {
+                    glm::ivec3 offset(0);
+                    offset[f / 2] = (f & 1) ? 1 : -1;
+                    if (delta == offset) {
+                        neighbours[i][f] = &other;
+                    }
+                }
+            }
+        }
+
+        std::size_t triangles = 0;
+        Voxels::Mesh mesh;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count; i++) {
+            Voxels::mesh(Voxels::chunks[i], neighbours[i].data(), greedy, mesh);
+            triangles += mesh.indices.size() / 3;
+        }
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        MeshingResult result;
+        result.triangles = count > 0 ? (double)triangles / count : 0.0;
+        result.milliseconds = count > 0 ? elapsed / count : 0.0;
+        return result;
+    }
+
+    // A wide field of cubes reaching to the far plane, most of it small on screen
+    void populateField(glm::vec3 &lightPos) {
+        const int SIZE = 64;
+        const float SPACING = 1.5f;
+        lightPos = glm::vec3(0.0f, 12.0f, 0.0f);
+        for (int z = 0; z < SIZE; z++) {
+            for (int x = 0; x < SIZE; x++) {
+                glm::vec3 position((x - SIZE / 2) * SPACING, 0.0f, (z - SIZE / 2) * SPACING);
+                Scene::addStatic(position, glm::vec3(1.0f));
+            }
+        }
+        Scene::add(lightPos, glm::vec3(1.0f), Scene::LAMP);
+    }
+
+    CameraState orbitField(float t) {
+        float angle = t * glm::two_pi<float>();
+        return lookAt(glm::vec3(50.0f * std::sin(angle), 8.0f, 50.0f * std::cos(angle)), glm::vec3(0.0f));
+    }
+
+    // A field of cubes behind a solid wall, only the wall and what shows over it can be seen
+    void populateOccluded(glm::vec3 &lightPos) {
+        const int SIZE = 40;
+        const float SPACING = 1.5f;
+        lightPos = glm::vec3(0.0f, 12.0f, 16.0f);
+        for (int y = 0; y < 8; y++) {
+            for (int x = -12; x <= 12; x++) {
+                Scene::addStatic(glm::vec3((float)x, (float)y, 10.0f), glm::vec3(1.0f));
+            }
+        }
+        for (int z = 0; z < SIZE; z++) {
+            for (int x = 0; x < SIZE; x++) {
+                glm::vec3 position((x - SIZE / 2) * SPACING, 0.0f, 8.0f - z * SPACING);
+                Scene::addStatic(position, glm::vec3(1.0f));
+            }
+        }
+        Scene::add(lightPos, glm::vec3(1.0f), Scene::LAMP);
+    }
+
+    // Along the wall at eye level
+    CameraState strafeWall(float t) {
+        glm::vec3 position(glm::mix(-4.0f, 4.0f, t), 3.0f, 22.0f);
+        return lookAt(position, position + glm::vec3(0.0f, 0.0f, -1.0f));
+    }
+
+    CameraState orbitGrid(float t) {
+        float angle = t * glm::two_pi<float>();
+        return lookAt(glm::vec3(28.0f * std::sin(angle), 10.0f, 28.0f * std::cos(angle)), glm::vec3(0.0f, 3.0f, 0.0f));
+    }
+
+    // Through the grid at eye level, most of it is behind or beside the camera
+    CameraState flyGrid(float t) {
+        glm::vec3 position(1.0f, 1.0f, glm::mix(-20.0f, 20.0f, t));
+        return lookAt(position, position + glm::vec3(0.2f, 0.0f, 1.0f));
+    }
+
+    const BenchScene SCENES[] = {
+        {"cube", populateCube, orbitCube, nullptr},
+        {"grid", populateGrid, orbitGrid, nullptr},
+        {"flythrough", populateGrid, flyGrid, nullptr},
+        {"lights_256", populateLights<256>, orbitGrid, nullptr},
+        {"lights", populateLights<2048>, orbitGrid, nullptr},
+        {"lights_8k", populateLights<8192>, orbitGrid, nullptr},
+        {"movers", populateMovers, flyGrid, circleMovers},
+        {"terrain", populateTerrain, orbitTerrain, nullptr},
+        {"field", populateField, orbitField, nullptr},
+        {"occluded", populateOccluded, strafeWall, nullptr},
+        {"streaming", populateStreaming, flyTerrain, nullptr}
+    };
+
+    // Yardstick for frame times, every other scene's are stored and checked as a multiple of its median
+    const char* const CALIBRATION = "grid";
+
+    bool readImage(const std::string &path, Image &image) {
+        std::ifstream file(path, std::ios::binary);
+        std::string magic;
+        int maxValue = 0;
+        if (!(file >> magic >> image.width >> image.height >> maxValue) || magic != "P6" || maxValue != 255) {
+            return false;
+        }
+        file.get();
+        image.pixels.resize((std::size_t)image.width * image.height * 3);
+        file.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size());
+        return (bool)file;
+    }
+
+    bool writeImage(const std::string &path, const Image &image) {
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n" << image.width << " " << image.height << "\n255\n";
+        file.write(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size());
+        return (bool)file;
+    }
+
+    // Copy of the back buffer, flipped so the top row comes first
+    Image readBackbuffer(int width, int height) {
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize((std::size_t)width * height * 3);
+
+        std::vector<std::uint8_t> rows(image.pixels.size());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+
+        std::size_t stride = (std::size_t)width * 3;
+        for (int y = 0; y < height; y++) {
+            std::copy(rows.begin() + (height - 1 - y) * stride, rows.begin() + (height - y) * stride, image.pixels.begin() + y * stride);
+        }
+        return image;
+    }
+
+    // Fraction of pixels with a channel further than tolerance from the golden one, the diff image marks them
+    float compare(const Image &actual, const Image &golden, int tolerance, Image &diff) {
+        diff.width = actual.width;
+        diff.height = actual.height;
+        diff.pixels.assign(actual.pixels.size(), 0);
+
+        std::size_t mismatched = 0;
+        std::size_t count = (std::size_t)actual.width * actual.height;
+        for (std::size_t i = 0; i < count; i++) {
+            int worst = 0;
+            for (int c = 0; c < 3; c++) {
+                worst = std::max(worst, std::abs((int)actual.pixels[i * 3 + c] - (int)golden.pixels[i * 3 + c]));
+            }
+            if (worst > tolerance) {
+                mismatched++;
+                diff.pixels[i * 3] = 255;
+            } else {
+                // Dimmed copy of the frame for orientation
+                diff.pixels[i * 3 + 1] = actual.pixels[i * 3 + 1] / 4;
+            }
+        }
+        return count > 0 ? (float)mismatched / count : 0.0f;
+    }
+
+    float percentile(std::vector<float> times, float p) {
+        if (times.empty()) {
+            return 0.0f;
+        }
+        std::size_t index = std::min(times.size() - 1, (std::size_t)(p * times.size()));
+        std::nth_element(times.begin(), times.begin() + index, times.end());
+        return times[index];
+    }
+
+    // What a scene's frames measured, over the frames after the warmup
+    struct Result {
+        std::vector<float> times;
+        Image image;                        // Last frame, empty under null GL
+        bool supported = true;              // False when the soft backend can't draw the scene, nothing was rendered
+        bool terrain = false;
+        MeshingResult merged = {0.0, 0.0}, unmerged = {0.0, 0.0};
+        std::uint64_t maxCalls = 0;
+        std::uint64_t maxAllocations = 0;
+        double shadowRegions = 0.0, shadowDraws = 0.0, shadowMs = 0.0;
+        double streamUpdateMs = 0.0, streamUploadKb = 0.0;
+        double triangles = 0.0, trianglesFull = 0.0;
+        double occluded = 0.0, occlusionMs = 0.0;
+    };
+
+    // Populate the scene and render it along its path
+    Result render(GLFWwindow* window, const BenchScene &scene) {
+        Result result;
+        glm::vec3 lightPos;
+        Scene::instances.clear();
+        Scene::resident.clear();
+        Scene::lights.clear();
+        Voxels::clear();
+        Streaming::stop();
+        scene.populate(lightPos);
+        if (Config::renderer == "soft" && (!Scene::lights.empty() || !Voxels::chunks.empty() || Streaming::active())) {
+            result.supported = false;
+            return result;
+        }
+        Simulation::init();
+
+        // Meshing cost of voxel scenes, merged against hidden face removal alone
+        result.terrain = !Voxels::chunks.empty();
+        if (result.terrain) {
+            result.unmerged = measureMeshing(false);
+            result.merged = measureMeshing(true);
+        }
+
+        int width = Window::framebufferWidth.load();
+        int height = Window::framebufferHeight.load();
+        int frames = std::max(Config::benchFrames, 1);
+
+        FramePacket packet;
+        packet.stepTime = 0.0;
+        packet.stepLength = 0.0f;     // No interpolation, every frame shows exactly its step
+        packet.inputTime = 0.0;
+        packet.lightPos = lightPos;
+        packet.lightColor = glm::vec3(1.0f);
+        packet.sunDirection = SUN_DIRECTION;
+        packet.sunColor = glm::vec3(Config::sun);
+        packet.lights = Scene::lights;
+        packet.commands.reserve(Scene::instances.size());
+
+        // Without a context there is nothing to read back, only calls to count
+        bool nullGL = NullGL::installed();
+        NullGL::reset();
+
+        result.times.reserve(frames);
+        for (int i = 0; i < frames; i++) {
+            CameraState state = scene.path(frames > 1 ? (float)i / (frames - 1) : 0.0f);
+            Camera view(state.position, glm::vec3(0.0f, 1.0f, 0.0f), state.yaw, state.pitch);
+
+            // Whatever is still loading would make the compared frame depend on thread timing
+            if (i == frames - 1) {
+                Streaming::settle(view.Position, view.Front);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            std::uint64_t callsBefore = NullGL::calls();
+            std::uint64_t allocationsBefore = AllocTrack::allocations();
+            glm::mat4 projection = glm::perspective(glm::radians(state.zoom), (float)width / (float)height, 0.1f, 100.0f);
+
+            Scene::saveState();
+            if (scene.animate) {
+                scene.animate(frames > 1 ? (float)i / (frames - 1) : 0.0f);
+            }
+            Streaming::update(view.Position, view.Front);
+            packet.sequence = i;
+            packet.streamFrame = Streaming::frame();
+            packet.previousCamera = state;
+            packet.camera = state;
+            packet.commands = Simulation::record(projection * view.GetViewMatrix());
+            packet.casters = DrawList::casters();
+            if (Config::gpuCulling && Config::occlusion) {
+                Occlusion::copyPyramid(packet.occlusionDepth, packet.occlusionViewProjection);
+            }
+            RenderThread::render(packet, 0.0, width, height);
+
+            if (i == frames - 1 && !nullGL) {
+                result.image = readBackbuffer(width, height);
+            }
+
+            // Count the GPU too, not just the submission
+            glFinish();
+            if (i >= Config::benchWarmup) {
+                result.times.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+                result.maxCalls = std::max(result.maxCalls, NullGL::calls() - callsBefore);
+                result.maxAllocations = std::max(result.maxAllocations, AllocTrack::allocations() - allocationsBefore);
+                result.shadowRegions += Stats::get("shadow_regions");
+                result.shadowDraws += Stats::get("shadow_draws");
+                result.shadowMs += Stats::get("shadow_cpu_ms");
+                result.streamUpdateMs = std::max(result.streamUpdateMs, Stats::get("stream_update_ms"));
+                result.streamUploadKb = std::max(result.streamUploadKb, Stats::get("stream_upload_kb"));
+                result.triangles += Stats::get("triangles");
+                result.trianglesFull += Stats::get("triangles_full");
+                result.occluded += Stats::get("occlusion_hidden");
+                result.occlusionMs += Stats::get("occlusion_ms");
+            }
+            AllocTrack::endFrame();
+            if (window) {
+                glfwSwapBuffers(window);
+            }
+        }
+        return result;
+    }
+
+    // Returns the number of failed checks. Frame times are kept relative to the calibration scene's
+    // median from the same run, so the baselines carry over between machines
+    int runScene(GLFWwindow* window, const BenchScene &scene, float calibration) {
+        Result result = render(window, scene);
+        if (!result.supported) {
+            std::cout << "ERROR::BENCH::SOFT_UNSUPPORTED " << scene.name << " has point lights or voxel chunks, which only GPU renderers draw" << std::endl;
+            return 1;
+        }
+        const std::vector<float> &times = result.times;
+        bool nullGL = NullGL::installed();
+        int frames = std::max(Config::benchFrames, 1);
+
+        float median = percentile(times, 0.5f);
+        float p95 = percentile(times, 0.95f);
+        if (calibration <= 0.0f) {
+            calibration = median;
+        }
+        float relative = calibration > 0.0f ? median / calibration : 0.0f;
+        float relativeP95 = calibration > 0.0f ? p95 / calibration : 0.0f;
+
+        // Each backend keeps its own references, their images aren't bit identical
+        std::string suffix = (Config::renderer == "gl" ? "" : "_" + Config::renderer) + (Config::overdraw ? "_overdraw" : "") + (Config::lod ? "_lod" : "") + (Config::shadows ? "_shadows" : "") + (Config::sun > 0.0f ? "_sun" : "") + (nullGL ? "_null" : "");
+        std::string base = Config::goldenDir + "/" + scene.name + suffix;
+        std::string output = Config::benchOutput + "/" + scene.name + suffix;
+        std::string imagePath = base + ".ppm";
+        std::string timePath = base + ".time";
+
+        if (Config::updateGolden) {
+            std::ofstream timeFile(timePath);
+            timeFile << relative << " " << relativeP95 << "\n";
+            if ((!nullGL && !writeImage(imagePath, result.image)) || !timeFile) {
+                std::cout << "ERROR::BENCH::WRITE_FAILED " << imagePath << std::endl;
+                return 1;
+            }
+            std::cout << "BENCH::" << scene.name << " updated median=" << median << "ms p95=" << p95 << "ms relative=" << relative << std::endl;
+            return 0;
+        }
+
+        int failures = 0;
+        std::ostringstream report;
+        report << "BENCH::" << scene.name << " renderer=" << Config::renderer << " frames=" << frames << " median=" << median << "ms p95=" << p95 << "ms";
+        if (Config::perfTolerance >= 0.0f) {
+            report << " relative=" << relative;
+        }
+
+        // Image check
+        Image golden;
+        if (nullGL) {
+            report << " image=SKIPPED";
+        } else if (!readImage(imagePath, golden)) {
+            report << " image=MISSING";
+            failures++;
+        } else if (golden.width != result.image.width || golden.height != result.image.height) {
+            report << " image=SIZE_MISMATCH";
+            failures++;
+        } else {
+            Image diff;
+            float mismatch = compare(result.image, golden, Config::goldenTolerance, diff);
+            bool pass = mismatch <= Config::goldenMaxMismatch;
+            report << " image=" << (pass ? "PASS" : "FAIL") << " mismatch=" << mismatch;
+            if (!pass) {
+                // Keep what we got for inspection, away from the references
+                writeImage(output + "_actual.ppm", result.image);
+                writeImage(output + "_diff.ppm", diff);
+                failures++;
+            }
+        }
+
+        // Average fragments per covered pixel in the last frame
+        if (Config::overdraw) {
+            report << " overdraw=" << Stats::get("overdraw");
+        }
+
+        if (result.terrain) {
+            report << " chunk_triangles=" << result.merged.triangles << " chunk_mesh=" << result.merged.milliseconds << "ms"
+                   << " unmerged_triangles=" << result.unmerged.triangles << " unmerged_mesh=" << result.unmerged.milliseconds << "ms";
+        }
+
+        // Streaming work done on the frame's own threads, at its worst
+        if (Streaming::active()) {
+            report << " stream_loads=" << Stats::get("stream_loads") << " stream_evictions=" << Stats::get("stream_evictions")
+                   << " stream_update_max=" << result.streamUpdateMs << "ms stream_upload_max=" << result.streamUploadKb << "KB";
+        }
+
+        // Triangles submitted per measured frame, against all at full detail
+        if (Config::lod && !times.empty()) {
+            report << " triangles=" << result.triangles / times.size() << " triangles_full=" << result.trianglesFull / times.size();
+        }
+
+        // Instances the occlusion culler dropped per measured frame, and what building its depth pyramid took
+        if (Config::occlusion && !times.empty()) {
+            report << " occluded=" << result.occluded / times.size() << " occlusion=" << result.occlusionMs / times.size() << "ms";
+        }
+
+        // Shadow work per measured frame, cached regions cost nothing
+        if (Config::shadows && !times.empty()) {
+            report << " shadow_regions=" << result.shadowRegions / times.size() << " shadow_draws=" << result.shadowDraws / times.size() << " shadow_cpu=" << result.shadowMs / times.size() << "ms";
+        }
+
+        // Frame time check against the stored ratio
+        std::ifstream timeFile(timePath);
+        float baseline = 0.0f;
+        if (Config::perfTolerance < 0.0f) {
+            report << " perf=SKIPPED";
+        } else if (!(timeFile >> baseline) || baseline <= 0.0f) {
+            report << " perf=MISSING";
+            failures++;
+        } else {
+            bool pass = relative <= baseline * (1.0f + Config::perfTolerance);
+            report << " perf=" << (pass ? "PASS" : "FAIL") << " baseline=" << baseline;
+            if (!pass) {
+                failures++;
+            }
+        }
+
+        // Per frame GL call budget
+        if (nullGL) {
+            std::size_t measured = std::max<std::size_t>(times.size(), 1);
+            report << " calls=" << result.maxCalls << " bytes=" << NullGL::bytes() / measured;
+            if (Config::glCallBudget > 0) {
+                bool pass = result.maxCalls <= (std::uint64_t)Config::glCallBudget;
+                report << " budget=" << (pass ? "PASS" : "FAIL");
+                if (!pass) {
+                    failures++;
+                }
+            }
+        }
+
+        // Steady-state frames shouldn't touch the heap
+        if (AllocTrack::enabled()) {
+            report << " allocs=" << result.maxAllocations;
+            if (Config::allocCheck) {
+                bool pass = result.maxAllocations == 0;
+                report << " alloc_check=" << (pass ? "PASS" : "FAIL");
+                if (!pass) {
+                    failures++;
+                }
+            }
+        }
+
+        // The same frames drawn by GL, last since it renders the scene again
+        if (Config::renderer == "soft") {
+            Config::renderer = "gl";
+            float glMedian = percentile(render(window, scene).times, 0.5f);
+            Config::renderer = "soft";
+            report << " soft_vs_gl=" << (glMedian > 0.0f ? median / glMedian : 0.0f);
+        }
+
+        std::cout << report.str() << std::endl;
+        if (nullGL) {
+            NullGL::report();
+        }
+        return failures;
+    }
+
+    // Median of the calibration scene, measured once per run. 0 for the calibration scene itself, which
+    // is then compared with its own median, and when frame times aren't checked
+    float calibration = 0.0f;
+
+    float calibrate(GLFWwindow* window, const BenchScene &scene) {
+        if (std::strcmp(scene.name, CALIBRATION) == 0 || (Config::perfTolerance < 0.0f && !Config::updateGolden)) {
+            return 0.0f;
+        }
+        if (calibration <= 0.0f) {
+            for (const BenchScene &yardstick : SCENES) {
+                if (std::strcmp(yardstick.name, CALIBRATION) == 0) {
+                    calibration = percentile(render(window, yardstick).times, 0.5f);
+                }
+            }
+        }
+        return calibration;
+    }
+
+    // Ray queries against a million boxes, not a rendered scene: build and refit times, nearest hits
+    // per second on this thread and on all of them, and a sample checked against testing every box
+    int runBvh() {
+        const std::size_t OBJECTS = 1000000;
+        const float EXTENT = 200.0f;        // Boxes are scattered over a cube twice this wide
+        const std::size_t QUERIES = 200000;
+        const std::size_t CHECKED = 100;
+        const float RANGE = 100.0f;         // Same as the far plane
+
+        // Small LCG so every run sees the same boxes and rays
+        unsigned int seed = 11;
+        auto next = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) / 16777216.0f;
+        };
+        auto point = [&]() {
+            return glm::vec3(next(), next(), next()) * (2.0f * EXTENT) - glm::vec3(EXTENT);
+        };
+
+        std::vector<Bvh::Box> boxes(OBJECTS);
+        for (Bvh::Box &box : boxes) {
+            glm::vec3 centre = point();
+            glm::vec3 half = glm::vec3(next(), next(), next()) * 0.75f + glm::vec3(0.25f);
+            box = Bvh::Box{centre - half, centre + half};
+        }
+        std::vector<glm::vec3> origins(QUERIES), directions(QUERIES);
+        for (std::size_t i = 0; i < QUERIES; i++) {
+            origins[i] = point();
+            glm::vec3 direction(next() - 0.5f, next() - 0.5f, next() - 0.5f);
+            directions[i] = glm::length(direction) > 1e-3f ? glm::normalize(direction) : glm::vec3(0.0f, 0.0f, -1.0f);
+        }
+
+        Bvh::Tree tree;
+        auto start = std::chrono::steady_clock::now();
+        tree.build(boxes);
+        double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Everything drifts a little, as moving objects would between frames
+        for (Bvh::Box &box : boxes) {
+            glm::vec3 offset = glm::vec3(next(), next(), next()) - glm::vec3(0.5f);
+            box.min += offset;
+            box.max += offset;
+        }
+        start = std::chrono::steady_clock::now();
+        tree.refit(boxes);
+        double refitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<Bvh::Hit> hits(QUERIES);
+        std::vector<std::uint8_t> found(QUERIES);
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < QUERIES; i++) {
+            found[i] = tree.raycast(origins[i], directions[i], RANGE, hits[i]);
+        }
+        double serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        Jobs::parallelFor(QUERIES, 1024, [&](std::size_t i) {
+            found[i] = tree.raycast(origins[i], directions[i], RANGE, hits[i]);
+        });
+        double parallelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::size_t hitCount = 0;
+        for (std::uint8_t f : found) {
+            hitCount += f;
+        }
+
+        // The nearest distance has to match a test of every box, the object may differ on a tie, and the
+        // segment over the same range has to be blocked exactly when there is a hit
+        int failures = 0;
+        for (std::size_t i = 0; i < CHECKED; i++) {
+            float nearest = RANGE;
+            bool any = false;
+            glm::vec3 inverse = glm::vec3(1.0f) / directions[i];
+            for (const Bvh::Box &box : boxes) {
+                glm::vec3 t1 = (box.min - origins[i]) * inverse, t2 = (box.max - origins[i]) * inverse;
+                glm::vec3 near = glm::min(t1, t2), far = glm::max(t1, t2);
+                float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+                float exit = std::min(std::min(far.x, far.y), far.z);
+                if (enter <= exit && enter <= nearest) {
+                    nearest = enter;
+                    any = true;
+                }
+            }
+            bool blocked = tree.intersects(origins[i], origins[i] + directions[i] * RANGE);
+            if (any != (bool)found[i] || any != blocked || (any && std::abs(nearest - hits[i].distance) > 1e-3f)) {
+                failures++;
+            }
+        }
+
+        // Picking over a scene of cubes, checked the same way before and after they move and it refits
+        const std::size_t CUBES = 4096;
+        const float SPREAD = 20.0f;
+        Scene::instances.clear();
+        Scene::resident.clear();
+        for (std::size_t i = 0; i < CUBES; i++) {
+            glm::vec3 scale = glm::vec3(next(), next(), next()) + glm::vec3(0.5f);
+            Scene::add(glm::vec3(next(), next(), next()) * (2.0f * SPREAD) - glm::vec3(SPREAD), scale, Scene::LIT);
+        }
+        int pickFailures = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (std::size_t p = 0; p < Scene::partitionCount(); p++) {
+                Scene::updateTransforms(p);
+            }
+            if (pass == 0) {
+                Picking::build();
+            } else {
+                Picking::refit();
+            }
+
+            for (std::size_t i = 0; i < CHECKED; i++) {
+                glm::vec3 from = glm::vec3(next(), next(), next()) * (2.0f * SPREAD) - glm::vec3(SPREAD);
+                glm::vec3 to = glm::vec3(next(), next(), next()) * (2.0f * SPREAD) - glm::vec3(SPREAD);
+                float length = glm::length(to - from);
+                glm::vec3 direction = (to - from) / length;
+                float nearest = length;
+                bool any = false;
+                glm::vec3 inverse = glm::vec3(1.0f) / direction;
+                for (const Scene::Instance &instance : Scene::instances) {
+                    glm::vec3 t1 = (instance.position - instance.scale * 0.5f - from) * inverse, t2 = (instance.position + instance.scale * 0.5f - from) * inverse;
+                    glm::vec3 near = glm::min(t1, t2), far = glm::max(t1, t2);
+                    float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+                    float exit = std::min(std::min(far.x, far.y), far.z);
+                    if (enter <= exit && enter <= nearest) {
+                        nearest = enter;
+                        any = true;
+                    }
+                }
+                Bvh::Hit hit;
+                bool picked = Picking::pick(from, direction, length, hit);
+                if (any != picked || any == Picking::lineOfSight(from, to) || (any && std::abs(nearest - hit.distance) > 1e-3f)) {
+                    pickFailures++;
+                }
+            }
+
+            for (Scene::Instance &instance : Scene::instances) {
+                instance.position += glm::vec3(next(), next(), next()) * 2.0f - glm::vec3(1.0f);
+            }
+        }
+        Scene::instances.clear();
+
+        std::cout << "BENCH::bvh objects=" << OBJECTS << " nodes=" << tree.nodeCount() << " build=" << buildMs << "ms refit=" << refitMs << "ms"
+                  << " queries_per_sec=" << QUERIES / serialSeconds << " queries_per_sec_parallel=" << QUERIES / parallelSeconds
+                  << " threads=" << Jobs::workerCount() + 1 << " hit_rate=" << (double)hitCount / QUERIES
+                  << " check=" << (failures == 0 ? "PASS" : "FAIL") << " picking=" << (pickFailures == 0 ? "PASS" : "FAIL") << std::endl;
+        return failures + pickFailures == 0 ? 0 : 1;
+    }
+}
+
+int Bench::run(GLFWwindow* window) {
+    // The controller reacts to timing and would make the images depend on the machine
+    Config::dynamicResolution = false;
+    if (window) {
+        glfwSwapInterval(0);
+    }
+    RenderThread::initContext();
+
+    // Soft runs also time each scene on GL to compare with
+    if (Config::renderer == "soft") {
+        Renderer::init();
+    }
+
+    int failures = 0;
+    int ran = 0;
+    std::stringstream names(Config::bench);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        bool found = false;
+        if (name == "bvh") {
+            failures += runBvh();
+            ran++;
+            found = true;
+        }
+        for (const BenchScene &scene : SCENES) {
+            if (name == "all" || name == scene.name) {
+                failures += runScene(window, scene, calibrate(window, scene));
+                ran++;
+                found = true;
+            }
+        }
+        if (!found) {
+            std::cout << "ERROR::BENCH::UNKNOWN_SCENE " << name << std::endl;
+            failures++;
+        }
+    }
+
+    Streaming::stop();
+    RenderThread::shutdownContext();
+    std::cout << "BENCH::SUMMARY scenes=" << ran << " failures=" << failures << std::endl;
+    return failures;
+}
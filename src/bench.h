@@ -0,0 +1,17 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+/**
+ * Headless regression runs. Each bench scene is populated the same way every
+ * time and rendered along a fixed camera path at a fixed step, so the final
+ * frame can be compared against a golden image and the frame times against a
+ * stored baseline. Meant to run under a software rasterizer such as llvmpipe
+ * so the images don't depend on the GPU.
+ */
+
+namespace Bench {
+    // Run the scenes named by --bench on the calling thread, which must own the context.
+    // window is null under the null GL backend. Returns the number of failed checks
+    extern int run(GLFWwindow* window);
+}
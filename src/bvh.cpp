@@ -0,0 +1,299 @@
+#include "./bvh.h"
+#include "./simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using Simd::Float4;
+
+namespace {
+    const int BINS = 16;                // Centroid bins per axis for the surface area heuristic
+    const int MAX_SAH_DEPTH = 48;       // Binary splits before falling back to halving, bounds the depth
+    const int STACK_SIZE = 256;         // Enough for the depth the fallback allows, four entries per level
+
+    const float INF = std::numeric_limits<float>::infinity();
+
+    Bvh::Box emptyBox() {
+        return Bvh::Box{glm::vec3(INF), glm::vec3(-INF)};
+    }
+
+    void grow(Bvh::Box &box, const Bvh::Box &other) {
+        box.min = glm::min(box.min, other.min);
+        box.max = glm::max(box.max, other.max);
+    }
+
+    float halfArea(const Bvh::Box &box) {
+        glm::vec3 size = box.max - box.min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+}
+
+void Bvh::Tree::build(const std::vector<Box> &boxes) {
+    nodes.clear();
+    if (boxes.empty()) {
+        return;
+    }
+
+    order.resize(boxes.size());
+    centroids.resize(boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+        order[i] = (std::uint32_t)i;
+        centroids[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+    }
+
+    // Around two objects per node on average, four per leaf level
+    nodes.reserve(boxes.size() / 2 + 1);
+    buildNode(boxes, 0, (std::uint32_t)boxes.size(), 0);
+}
+
+std::uint32_t Bvh::Tree::buildNode(const std::vector<Box> &boxes, std::uint32_t begin, std::uint32_t end, int depth) {
+    std::uint32_t index = (std::uint32_t)nodes.size();
+    nodes.push_back(Node());
+
+    // Up to four ranges of objects, two splits deep, each a lane
+    std::uint32_t first[4], last[4];
+    int count = 0;
+    if (end - begin <= 4) {
+        for (std::uint32_t i = begin; i < end; i++) {
+            first[count] = i;
+            last[count++] = i + 1;
+        }
+    } else {
+        std::uint32_t middle = split(boxes, begin, end, depth);
+        const std::uint32_t halves[2][2] = {{begin, middle}, {middle, end}};
+        for (const std::uint32_t *half : halves) {
+            if (half[1] - half[0] > 1) {
+                std::uint32_t quarter = split(boxes, half[0], half[1], depth + 1);
+                first[count] = half[0];
+                last[count++] = quarter;
+                first[count] = quarter;
+                last[count++] = half[1];
+            } else {
+                first[count] = half[0];
+                last[count++] = half[1];
+            }
+        }
+    }
+
+    // Children are built after their parent, so the node has to be looked up again after each
+    for (int lane = 0; lane < count; lane++) {
+        std::uint32_t child;
+        Box box;
+        if (last[lane] - first[lane] == 1) {
+            child = OBJECT | order[first[lane]];
+            box = boxes[order[first[lane]]];
+        } else {
+            box = emptyBox();
+            for (std::uint32_t i = first[lane]; i < last[lane]; i++) {
+                grow(box, boxes[order[i]]);
+            }
+            child = buildNode(boxes, first[lane], last[lane], depth + 2);
+        }
+        nodes[index].child[lane] = child;
+        setLane(nodes[index], lane, box);
+    }
+    nodes[index].count = (std::uint32_t)count;
+    return index;
+}
+
+// Reorders the range and returns where the second half starts, never at either end
+std::uint32_t Bvh::Tree::split(const std::vector<Box> &boxes, std::uint32_t begin, std::uint32_t end, int depth) {
+    glm::vec3 low(INF), high(-INF);
+    for (std::uint32_t i = begin; i < end; i++) {
+        low = glm::min(low, centroids[order[i]]);
+        high = glm::max(high, centroids[order[i]]);
+    }
+    glm::vec3 extent = high - low;
+
+    auto binOf = [&](std::uint32_t object, int axis) {
+        return std::min(BINS - 1, (int)((centroids[object][axis] - low[axis]) * (BINS / extent[axis])));
+    };
+
+    // Cheapest split between bins on any axis, by area times objects on either side
+    int bestAxis = -1, bestBin = 0;
+    float bestCost = INF;
+    for (int axis = 0; axis < 3 && depth <= MAX_SAH_DEPTH; axis++) {
+        if (!(extent[axis] > 0.0f)) {
+            continue;
+        }
+        Box binBox[BINS];
+        std::uint32_t binCount[BINS] = {};
+        std::fill(binBox, binBox + BINS, emptyBox());
+        for (std::uint32_t i = begin; i < end; i++) {
+            int bin = binOf(order[i], axis);
+            binCount[bin]++;
+            grow(binBox[bin], boxes[order[i]]);
+        }
+
+        float rightArea[BINS];
+        std::uint32_t rightCount[BINS];
+        Box side = emptyBox();
+        std::uint32_t objects = 0;
+        for (int bin = BINS - 1; bin > 0; bin--) {
+            grow(side, binBox[bin]);
+            objects += binCount[bin];
+            rightArea[bin] = halfArea(side);
+            rightCount[bin] = objects;
+        }
+
+        side = emptyBox();
+        objects = 0;
+        for (int bin = 0; bin < BINS - 1; bin++) {
+            grow(side, binBox[bin]);
+            objects += binCount[bin];
+            if (objects == 0 || rightCount[bin + 1] == 0) {
+                continue;
+            }
+            float cost = objects * halfArea(side) + rightCount[bin + 1] * rightArea[bin + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+            }
+        }
+    }
+
+    if (bestAxis >= 0) {
+        auto middle = std::partition(order.begin() + begin, order.begin() + end, [&](std::uint32_t object) {
+            return binOf(object, bestAxis) <= bestBin;
+        });
+        std::uint32_t split = (std::uint32_t)(middle - order.begin());
+        if (split > begin && split < end) {
+            return split;
+        }
+    }
+
+    // Halve along the widest axis where the heuristic has nothing to go on, or the tree got too deep
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    std::uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](std::uint32_t a, std::uint32_t b) {
+        return centroids[a][axis] < centroids[b][axis];
+    });
+    return middle;
+}
+
+void Bvh::Tree::setLane(Node &node, int lane, const Box &box) {
+    node.minX[lane] = box.min.x;
+    node.minY[lane] = box.min.y;
+    node.minZ[lane] = box.min.z;
+    node.maxX[lane] = box.max.x;
+    node.maxY[lane] = box.max.y;
+    node.maxZ[lane] = box.max.z;
+}
+
+void Bvh::Tree::refit(const std::vector<Box> &boxes) {
+    // Children come after their parents, so going backwards finds them refitted already
+    for (std::size_t n = nodes.size(); n-- > 0;) {
+        Node &node = nodes[n];
+        for (std::uint32_t lane = 0; lane < node.count; lane++) {
+            std::uint32_t child = node.child[lane];
+            if (child & OBJECT) {
+                setLane(node, lane, boxes[child & ~OBJECT]);
+                continue;
+            }
+            const Node &inner = nodes[child];
+            Box box = emptyBox();
+            for (std::uint32_t i = 0; i < inner.count; i++) {
+                grow(box, Box{glm::vec3(inner.minX[i], inner.minY[i], inner.minZ[i]), glm::vec3(inner.maxX[i], inner.maxY[i], inner.maxZ[i])});
+            }
+            setLane(node, lane, box);
+        }
+    }
+}
+
+bool Bvh::Tree::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Hit &hit) const {
+    return traverse(origin, direction, maxDistance, false, hit);
+}
+
+bool Bvh::Tree::intersects(const glm::vec3 &from, const glm::vec3 &to) const {
+    Hit hit;
+    return traverse(from, to - from, 1.0f, true, hit);
+}
+
+bool Bvh::Tree::traverse(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, bool any, Hit &hit) const {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    // Tiny components instead of zero keep the slab distances finite
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; axis++) {
+        float d = direction[axis];
+        if (std::abs(d) < 1e-20f) {
+            d = d < 0.0f ? -1e-20f : 1e-20f;
+        }
+        inverse[axis] = 1.0f / d;
+    }
+    const Float4 ox = Simd::splat(origin.x), oy = Simd::splat(origin.y), oz = Simd::splat(origin.z);
+    const Float4 ix = Simd::splat(inverse.x), iy = Simd::splat(inverse.y), iz = Simd::splat(inverse.z);
+    const Float4 zero = Simd::splat(0.0f);
+
+    struct Entry {
+        std::uint32_t node;
+        float distance;     // Where the ray enters the node's bounds
+    };
+    Entry stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = Entry{0, 0.0f};
+
+    float closest = maxDistance;
+    bool found = false;
+    while (top > 0) {
+        Entry entry = stack[--top];
+        if (entry.distance > closest) {
+            continue;
+        }
+
+        // Slab test of all four lanes
+        const Node &node = nodes[entry.node];
+        Float4 x1 = (Simd::load(node.minX) - ox) * ix, x2 = (Simd::load(node.maxX) - ox) * ix;
+        Float4 y1 = (Simd::load(node.minY) - oy) * iy, y2 = (Simd::load(node.maxY) - oy) * iy;
+        Float4 z1 = (Simd::load(node.minZ) - oz) * iz, z2 = (Simd::load(node.maxZ) - oz) * iz;
+        Float4 enter = Simd::max(Simd::max(Simd::min(x1, x2), Simd::min(y1, y2)), Simd::max(Simd::min(z1, z2), zero));
+        Float4 exit = Simd::min(Simd::min(Simd::max(x1, x2), Simd::max(y1, y2)), Simd::min(Simd::max(z1, z2), Simd::splat(closest)));
+        int lanes = Simd::mask(exit >= enter) & ((1 << node.count) - 1);
+        if (lanes == 0) {
+            continue;
+        }
+        float distances[4];
+        Simd::store(distances, enter);
+
+        // Objects right away, they can only bring closest in
+        Entry children[4];
+        int childCount = 0;
+        for (int lane = 0; lane < 4; lane++) {
+            if (!(lanes & (1 << lane))) {
+                continue;
+            }
+            std::uint32_t child = node.child[lane];
+            if (!(child & OBJECT)) {
+                children[childCount++] = Entry{child, distances[lane]};
+            } else if (distances[lane] <= closest) {
+                closest = distances[lane];
+                hit.object = child & ~OBJECT;
+                hit.distance = closest;
+                found = true;
+                if (any) {
+                    return true;
+                }
+            }
+        }
+
+        // Furthest pushed first, so the nearest is visited next
+        for (int i = 1; i < childCount; i++) {
+            Entry moved = children[i];
+            int j = i;
+            for (; j > 0 && children[j - 1].distance < moved.distance; j--) {
+                children[j] = children[j - 1];
+            }
+            children[j] = moved;
+        }
+        for (int i = 0; i < childCount; i++) {
+            if (children[i].distance <= closest) {
+                stack[top++] = children[i];
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Bounding volume hierarchy over axis aligned boxes for ray queries. Built
+ * top down with the surface area heuristic over binned centroids, then
+ * stored as a flat array of four wide nodes, each holding the bounds of its
+ * children side by side so a ray is tested against all four at once. A lane
+ * is either another node or an object, whose box is then tested exactly.
+ * Refitting keeps the topology and only recomputes bounds, for objects that
+ * moved a little since the build.
+ */
+
+namespace Bvh {
+    struct Box {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct Hit {
+        std::uint32_t object;       // Index of the box in what was built
+        float distance;             // In lengths of the ray's direction, 0 when it starts inside
+    };
+
+    class Tree
+    {
+        public:
+            // Object i is boxes[i]. Keeps its storage between builds
+            void build(const std::vector<Box> &boxes);
+
+            // New boxes for the same objects, the tree gets looser the further they moved
+            void refit(const std::vector<Box> &boxes);
+
+            // Nearest object the ray from origin along direction enters within maxDistance
+            bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Hit &hit) const;
+
+            // Whether any object touches the segment between the two points
+            bool intersects(const glm::vec3 &from, const glm::vec3 &to) const;
+
+            std::size_t nodeCount() const { return nodes.size(); }
+
+        private:
+            static const std::uint32_t OBJECT = 0x80000000u;   // Set in a lane's child for objects
+
+            // Lanes from count on are unused
+            struct alignas(16) Node {
+                float minX[4], minY[4], minZ[4];
+                float maxX[4], maxY[4], maxZ[4];
+                std::uint32_t child[4];
+                std::uint32_t count;
+            };
+
+            std::uint32_t buildNode(const std::vector<Box> &boxes, std::uint32_t begin, std::uint32_t end, int depth);
+            std::uint32_t split(const std::vector<Box> &boxes, std::uint32_t begin, std::uint32_t end, int depth);
+            static void setLane(Node &node, int lane, const Box &box);
+            bool traverse(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, bool any, Hit &hit) const;
+
+            std::vector<Node> nodes;            // Root first, every node before its children
+            std::vector<std::uint32_t> order;   // Objects, grouped by subtree during the build
+            std::vector<glm::vec3> centroids;   // Per object, during the build
+    };
+}
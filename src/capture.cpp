@@ -0,0 +1,373 @@
+#include "./capture.h"
+#include "./config.h"
+#include "./glstate.h"
+#include "./stats.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    const int MAX_PBOS = 8;
+
+    // A pixel buffer object the GPU writes a frame into
+    struct Readback {
+        GLuint pbo;
+        GLsync fence;
+        int width, height;
+        unsigned long frame;
+    };
+
+    // CPU copy of a frame waiting for the encoder
+    struct Image {
+        std::vector<unsigned char> rgba;    // Bottom up, as glReadPixels returns it
+        int width, height;
+        unsigned long frame;
+    };
+
+    bool active = false;
+    Readback readbacks[MAX_PBOS];
+    int ringSize = 0;
+    unsigned long frameCount = 0;
+    std::atomic<unsigned long> dropped(0);  // Counted by both threads
+
+    // Preallocated images cycle between the free list and the encode queue
+    std::vector<Image> images;
+    std::vector<Image*> freeImages;
+    std::vector<Image*> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread encoder;
+
+    // Output
+    bool png = false;
+    std::ofstream y4m;
+    int streamWidth = 0, streamHeight = 0;
+    std::vector<unsigned char> scratch;
+
+    // ------------------------------------------------------------------------
+    // Y4M, 4:2:0 full range BT.601
+
+    void writeY4M(const Image &image) {
+        int w = image.width, h = image.height;
+        if (streamWidth == 0) {
+            streamWidth = w;
+            streamHeight = h;
+            int fps = Config::targetFrameRate > 0.0f ? (int)Config::targetFrameRate : 60;
+            y4m << "YUV4MPEG2 W" << w << " H" << h << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+        }
+        if (w != streamWidth || h != streamHeight) {
+            // The stream has one size, frames after a resize can't go in it
+            dropped++;
+            return;
+        }
+
+        int cw = (w + 1) / 2, ch = (h + 1) / 2;
+        scratch.resize((std::size_t)w * h + (std::size_t)cw * ch * 2);
+        unsigned char *yPlane = &scratch[0];
+        unsigned char *uPlane = yPlane + (std::size_t)w * h;
+        unsigned char *vPlane = uPlane + (std::size_t)cw * ch;
+
+        for (int y = 0; y < h; y++) {
+            // Flip, GL rows start at the bottom
+            const unsigned char *row = &image.rgba[(std::size_t)(h - 1 - y) * w * 4];
+            for (int x = 0; x < w; x++) {
+                float r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+                yPlane[y * w + x] = (unsigned char)std::min(255.0f, 0.299f * r + 0.587f * g + 0.114f * b + 0.5f);
+            }
+        }
+        for (int y = 0; y < ch; y++) {
+            const unsigned char *row = &image.rgba[(std::size_t)(h - 1 - std::min(y * 2, h - 1)) * w * 4];
+            for (int x = 0; x < cw; x++) {
+                const unsigned char *p = row + std::min(x * 2, w - 1) * 4;
+                float r = p[0], g = p[1], b = p[2];
+                float u = 128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b;
+                float v = 128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b;
+                uPlane[y * cw + x] = (unsigned char)std::max(0.0f, std::min(255.0f, u + 0.5f));
+                vPlane[y * cw + x] = (unsigned char)std::max(0.0f, std::min(255.0f, v + 0.5f));
+            }
+        }
+
+        y4m << "FRAME\n";
+        y4m.write((const char*)&scratch[0], scratch.size());
+    }
+
+    // ------------------------------------------------------------------------
+    // PNG with stored (uncompressed) deflate blocks, cheap to write and needs no zlib
+
+    std::uint32_t crcTable[256];
+
+    void initCrc() {
+        for (std::uint32_t n = 0; n < 256; n++) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            crcTable[n] = c;
+        }
+    }
+
+    std::uint32_t crc(const unsigned char *data, std::size_t length, std::uint32_t c = 0xffffffffu) {
+        for (std::size_t i = 0; i < length; i++) {
+            c = crcTable[(c ^ data[i]) & 0xff] ^ (c >> 8);
+        }
+        return c;
+    }
+
+    void put32(std::vector<unsigned char> &out, std::uint32_t v) {
+        out.push_back(v >> 24);
+        out.push_back(v >> 16);
+        out.push_back(v >> 8);
+        out.push_back(v);
+    }
+
+    void chunk(std::ofstream &file, const char *type, const std::vector<unsigned char> &data) {
+        std::vector<unsigned char> header;
+        put32(header, (std::uint32_t)data.size());
+        header.insert(header.end(), type, type + 4);
+
+        std::uint32_t c = crc(&header[4], 4);
+        c = crc(data.data(), data.size(), c) ^ 0xffffffffu;
+
+        std::vector<unsigned char> footer;
+        put32(footer, c);
+        file.write((const char*)header.data(), header.size());
+        file.write((const char*)data.data(), data.size());
+        file.write((const char*)footer.data(), footer.size());
+    }
+
+    void writePNG(const Image &image) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "_%06lu.png", image.frame);
+        std::ofstream file(Config::capture + name, std::ios::binary);
+
+        int w = image.width, h = image.height;
+        std::vector<unsigned char> ihdr;
+        put32(ihdr, w);
+        put32(ihdr, h);
+        const unsigned char rest[] = {8, 2, 0, 0, 0};   // 8 bit RGB, no interlace
+        ihdr.insert(ihdr.end(), rest, rest + 5);
+
+        // Raw scanlines: filter byte 0 then RGB, flipped to top down
+        std::size_t stride = (std::size_t)w * 3 + 1;
+        std::vector<unsigned char> raw(stride * h);
+        for (int y = 0; y < h; y++) {
+            const unsigned char *row = &image.rgba[(std::size_t)(h - 1 - y) * w * 4];
+            unsigned char *out = &raw[y * stride];
+            out[0] = 0;
+            for (int x = 0; x < w; x++) {
+                out[1 + x * 3] = row[x * 4];
+                out[2 + x * 3] = row[x * 4 + 1];
+                out[3 + x * 3] = row[x * 4 + 2];
+            }
+        }
+
+        // zlib stream of stored blocks
+        scratch.clear();
+        scratch.push_back(0x78);
+        scratch.push_back(0x01);
+        std::uint32_t a = 1, b = 0;
+        for (std::size_t offset = 0; offset < raw.size() || offset == 0;) {
+            std::size_t length = std::min<std::size_t>(65535, raw.size() - offset);
+            bool last = offset + length == raw.size();
+            scratch.push_back(last ? 1 : 0);
+            scratch.push_back(length & 0xff);
+            scratch.push_back(length >> 8);
+            scratch.push_back(~length & 0xff);
+            scratch.push_back((~length >> 8) & 0xff);
+            scratch.insert(scratch.end(), raw.begin() + offset, raw.begin() + offset + length);
+            for (std::size_t i = offset; i < offset + length; i++) {
+                a = (a + raw[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+            offset += length;
+            if (last) {
+                break;
+            }
+        }
+        put32(scratch, (b << 16) | a);
+
+        const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        file.write((const char*)signature, 8);
+        chunk(file, "IHDR", ihdr);
+        chunk(file, "IDAT", scratch);
+        chunk(file, "IEND", std::vector<unsigned char>());
+    }
+
+    // ------------------------------------------------------------------------
+
+    void encodeLoop() {
+        for (;;) {
+            Image *image;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                image = queue.front();
+                queue.erase(queue.begin());
+            }
+
+            if (png) {
+                writePNG(*image);
+            } else {
+                writeY4M(*image);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            freeImages.push_back(image);
+        }
+    }
+
+    // Copy a finished readback out of its PBO and queue it, or drop it if the encoder is behind
+    void collect(Readback &readback) {
+        if (!readback.fence) {
+            return;
+        }
+        glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(readback.fence);
+        readback.fence = 0;
+
+        Image *image = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeImages.empty()) {
+                image = freeImages.back();
+                freeImages.pop_back();
+            }
+        }
+        if (!image) {
+            dropped++;
+            return;
+        }
+
+        std::size_t bytes = (std::size_t)readback.width * readback.height * 4;
+        GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (pixels) {
+            image->rgba.resize(bytes);
+            std::memcpy(&image->rgba[0], pixels, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        image->width = readback.width;
+        image->height = readback.height;
+        image->frame = readback.frame;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pixels) {
+            queue.push_back(image);
+            wake.notify_one();
+        } else {
+            freeImages.push_back(image);
+        }
+    }
+}
+
+void Capture::init() {
+    if (Config::capture.empty()) {
+        return;
+    }
+
+    std::string path = Config::capture;
+    png = path.size() < 4 || path.compare(path.size() - 4, 4, ".y4m") != 0;
+    if (png) {
+        initCrc();
+    } else {
+        y4m.open(path, std::ios::binary);
+        if (!y4m.is_open()) {
+            std::cout << "ERROR::CAPTURE::CANNOT_OPEN " << path << std::endl;
+            return;
+        }
+    }
+
+    ringSize = std::max(2, std::min(Config::captureLatency + 1, MAX_PBOS));
+    for (int i = 0; i < ringSize; i++) {
+        glGenBuffers(1, &readbacks[i].pbo);
+        readbacks[i].fence = 0;
+        readbacks[i].width = readbacks[i].height = 0;
+    }
+
+    int depth = std::max(1, Config::captureQueue);
+    images.resize(depth);
+    for (Image &image : images) {
+        freeImages.push_back(&image);
+    }
+    queue.reserve(depth);
+
+    stopping = false;
+    encoder = std::thread(encodeLoop);
+    active = true;
+}
+
+void Capture::shutdown() {
+    if (!active) {
+        return;
+    }
+
+    // Flush what is still in flight, oldest first
+    for (int i = 0; i < ringSize; i++) {
+        collect(readbacks[(frameCount + i) % ringSize]);
+    }
+    for (int i = 0; i < ringSize; i++) {
+        GLState::deleteBuffer(readbacks[i].pbo);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    encoder.join();
+    y4m.close();
+    active = false;
+
+    std::cout << "CAPTURE frames=" << frameCount << " dropped=" << dropped.load() << std::endl;
+}
+
+bool Capture::enabled() {
+    return active;
+}
+
+void Capture::frame(int width, int height) {
+    if (!active) {
+        return;
+    }
+
+    Readback &readback = readbacks[frameCount % ringSize];
+
+    // This slot was filled ringSize frames ago, the GPU is almost certainly done with it
+    collect(readback);
+
+    std::size_t bytes = (std::size_t)width * height * 4;
+    GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    if (readback.width != width || readback.height != height) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        readback.width = width;
+        readback.height = height;
+    }
+
+    // Into the bound pack buffer, returns without waiting for the GPU
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.frame = frameCount++;
+
+    Stats::set("capture_dropped", dropped.load());
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * Frame capture for QA recordings. The finished frame is read back into a
+ * ring of pixel buffer objects and only mapped a few frames later, when the
+ * GPU is long done with it. A worker thread encodes to a Y4M file or a PNG
+ * sequence; when it falls behind, frames are dropped instead of stalling.
+ */
+
+namespace Capture {
+    // Needs the context. Does nothing unless --capture is set
+    extern void init();
+    extern void shutdown();
+
+    extern bool enabled();
+
+    // Queue a readback of the bound read framebuffer and hand older finished ones to the encoder
+    extern void frame(int width, int height);
+}
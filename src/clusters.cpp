@@ -0,0 +1,280 @@
+#include "./clusters.h"
+#include "./framearena.h"
+#include "./glstate.h"
+#include "./jobs.h"
+#include "./simd.h"
+#include "./stats.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    const int TILES = Clusters::X * Clusters::Y;    // Clusters in one depth slice, a multiple of 4
+    const int GROUPS = TILES / 4;
+    const int CLUSTER_COUNT = TILES * Clusters::Z;
+
+    // View space bounds of the clusters of one slice, cluster i + X * j in lane order.
+    // Depths are distances in front of the camera
+    struct Slice {
+        alignas(16) float minX[TILES];
+        alignas(16) float maxX[TILES];
+        alignas(16) float minY[TILES];
+        alignas(16) float maxY[TILES];
+        float nearDepth, farDepth;
+    };
+
+    // What a slice job found: cluster << 24 | light, in light order
+    struct SliceLists {
+        explicit SliceLists(FrameArena &arena) : pairs(FrameArena::Allocator<std::uint32_t>(arena)), lastSize(0) {}
+
+        ArenaVector<std::uint32_t> pairs;
+        std::size_t lastSize;   // Pairs found last frame, reserved up front
+        std::uint32_t counts[TILES];
+    };
+
+    // Light in view space, with the slices its sphere spans
+    struct ViewLight {
+        glm::vec3 position;
+        float radius;
+        int firstSlice, lastSlice;
+    };
+
+    Slice slices[Clusters::Z];
+    glm::mat4 sliceProjection(0.0f);    // What the bounds were built for
+    float nearDepth = 0.1f, farDepth = 100.0f;
+
+    FrameArena arena(256 * 1024);
+    std::vector<SliceLists> lists;
+    std::vector<ViewLight> viewLights;
+
+    // CPU side of the buffers, kept between frames
+    std::vector<float> lightData;           // Position and radius, color and 0
+    std::vector<std::uint32_t> grid;        // Offset and count per cluster
+    std::vector<std::uint32_t> indices;
+
+    GLuint lightBuffer, gridBuffer, indexBuffer;
+    GLuint lightTexture, gridTexture, indexTexture;
+
+    int sliceOf(float depth) {
+        float slice = std::log(depth / nearDepth) / std::log(farDepth / nearDepth) * Clusters::Z;
+        return std::min(std::max((int)std::floor(slice), 0), Clusters::Z - 1);
+    }
+
+    // Screen tiles at the near and far depth of every slice, widened to the box holding both
+    void buildSlices(const glm::mat4 &projection) {
+        sliceProjection = projection;
+        nearDepth = projection[3][2] / (projection[2][2] - 1.0f);
+        farDepth = projection[3][2] / (projection[2][2] + 1.0f);
+
+        for (int k = 0; k < Clusters::Z; k++) {
+            Slice &slice = slices[k];
+            slice.nearDepth = nearDepth * std::pow(farDepth / nearDepth, (float)k / Clusters::Z);
+            slice.farDepth = nearDepth * std::pow(farDepth / nearDepth, (float)(k + 1) / Clusters::Z);
+
+            for (int j = 0; j < Clusters::Y; j++) {
+                for (int i = 0; i < Clusters::X; i++) {
+                    // NDC edges of the tile, scaled out to view space at both depths
+                    float x0 = (-1.0f + 2.0f * i / Clusters::X) / projection[0][0];
+                    float x1 = (-1.0f + 2.0f * (i + 1) / Clusters::X) / projection[0][0];
+                    float y0 = (-1.0f + 2.0f * j / Clusters::Y) / projection[1][1];
+                    float y1 = (-1.0f + 2.0f * (j + 1) / Clusters::Y) / projection[1][1];
+
+                    int c = i + Clusters::X * j;
+                    slice.minX[c] = std::min(x0 * slice.nearDepth, x0 * slice.farDepth);
+                    slice.maxX[c] = std::max(x1 * slice.nearDepth, x1 * slice.farDepth);
+                    slice.minY[c] = std::min(y0 * slice.nearDepth, y0 * slice.farDepth);
+                    slice.maxY[c] = std::max(y1 * slice.nearDepth, y1 * slice.farDepth);
+                }
+            }
+        }
+    }
+
+    // Sphere against box for every cluster of slice k, four clusters at a time
+    void assignSlice(const void *, std::size_t k) {
+        const Slice &slice = slices[k];
+        SliceLists &out = lists[k];
+        std::fill(out.counts, out.counts + TILES, 0u);
+
+        for (std::size_t l = 0; l < viewLights.size(); l++) {
+            const ViewLight &light = viewLights[l];
+            if ((int)k < light.firstSlice || (int)k > light.lastSlice) {
+                continue;
+            }
+
+            // Depth is shared by the whole slice
+            float depth = -light.position.z;
+            float dz = std::max(std::max(slice.nearDepth - depth, depth - slice.farDepth), 0.0f);
+            float radius2 = light.radius * light.radius;
+            if (dz * dz > radius2) {
+                continue;
+            }
+
+            Simd::Float4 cx = Simd::splat(light.position.x);
+            Simd::Float4 cy = Simd::splat(light.position.y);
+            Simd::Float4 dz2 = Simd::splat(dz * dz);
+            Simd::Float4 r2 = Simd::splat(radius2);
+            Simd::Float4 zero = Simd::splat(0.0f);
+
+            for (int g = 0; g < GROUPS; g++) {
+                Simd::Float4 dx = Simd::max(Simd::max(Simd::load(slice.minX + g * 4) - cx, cx - Simd::load(slice.maxX + g * 4)), zero);
+                Simd::Float4 dy = Simd::max(Simd::max(Simd::load(slice.minY + g * 4) - cy, cy - Simd::load(slice.maxY + g * 4)), zero);
+                int hits = Simd::mask(r2 >= dx * dx + dy * dy + dz2);
+
+                for (int lane = 0; hits && lane < 4; lane++) {
+                    if (!(hits & (1 << lane))) {
+                        continue;
+                    }
+                    std::uint32_t cluster = (std::uint32_t)(g * 4 + lane);
+                    out.pairs.push_back(cluster << 24 | (std::uint32_t)l);
+                    out.counts[cluster]++;
+                }
+            }
+        }
+    }
+
+    // Copy each slice's pairs to the index list at the offsets from the prefix sum
+    void scatterSlice(const void *, std::size_t k) {
+        const SliceLists &in = lists[k];
+        std::uint32_t cursor[TILES];
+        for (int c = 0; c < TILES; c++) {
+            cursor[c] = 0;
+        }
+
+        for (std::uint32_t pair : in.pairs) {
+            std::uint32_t c = pair >> 24;
+            std::uint32_t *cell = &grid[(k * TILES + c) * 2];
+            if (cursor[c] < cell[1]) {
+                indices[cell[0] + cursor[c]++] = pair & 0xffffff;
+            }
+        }
+    }
+
+    template<typename T>
+    void upload(GLuint buffer, const std::vector<T> &data, std::size_t minimum) {
+        // Orphan the old storage, the GPU may still be reading it
+        GLState::bindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, std::max(data.size(), minimum) * sizeof(T), data.empty() ? nullptr : data.data(), GL_STREAM_DRAW);
+    }
+
+    void createBuffer(GLuint &buffer, GLuint &texture, GLenum format, std::size_t bytes) {
+        glGenBuffers(1, &buffer);
+        GLState::bindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    }
+}
+
+void Clusters::init() {
+    createBuffer(lightBuffer, lightTexture, GL_RGBA32F, 8 * sizeof(float));
+    createBuffer(gridBuffer, gridTexture, GL_RG32UI, CLUSTER_COUNT * 2 * sizeof(std::uint32_t));
+    createBuffer(indexBuffer, indexTexture, GL_R32UI, sizeof(std::uint32_t));
+
+    lists.reserve(Z);
+    for (int k = 0; k < Z; k++) {
+        lists.emplace_back(arena);
+    }
+    grid.resize(CLUSTER_COUNT * 2);
+}
+
+void Clusters::build(const std::vector<Scene::Light> &lights, const glm::mat4 &view, const glm::mat4 &projection) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (projection != sliceProjection) {
+        buildSlices(projection);
+    }
+
+    // Lights in view space, dropping those entirely in front of or behind the frustum
+    viewLights.clear();
+    lightData.clear();
+    for (const Scene::Light &light : lights) {
+        if (viewLights.size() > 0xffffff) {
+            break;      // Light indices get 24 bits in the pairs
+        }
+
+        ViewLight viewLight;
+        viewLight.position = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        viewLight.radius = light.radius;
+
+        float depth = -viewLight.position.z;
+        if (depth + light.radius < nearDepth || depth - light.radius > farDepth) {
+            continue;
+        }
+        viewLight.firstSlice = sliceOf(std::max(depth - light.radius, nearDepth));
+        viewLight.lastSlice = sliceOf(depth + light.radius);
+        viewLights.push_back(viewLight);
+
+        lightData.insert(lightData.end(), {
+            light.position.x, light.position.y, light.position.z, light.radius,
+            light.color.r, light.color.g, light.color.b, 0.0f
+        });
+    }
+
+    // Arena storage from the last frame is gone, start the lists over on the fresh block
+    for (SliceLists &list : lists) {
+        list.lastSize = list.pairs.size();
+        ArenaVector<std::uint32_t>(FrameArena::Allocator<std::uint32_t>(arena)).swap(list.pairs);
+    }
+    arena.reset();
+    for (SliceLists &list : lists) {
+        list.pairs.reserve(list.lastSize);
+    }
+
+    if (!viewLights.empty()) {
+        Jobs::parallelFor(Z, 1, assignSlice, nullptr);
+    } else {
+        for (SliceLists &list : lists) {
+            std::fill(list.counts, list.counts + TILES, 0u);
+        }
+    }
+
+    // Offsets for every cluster, capping the crowded ones
+    std::uint32_t offset = 0, largest = 0;
+    for (int k = 0; k < Z; k++) {
+        for (int c = 0; c < TILES; c++) {
+            std::uint32_t count = std::min<std::uint32_t>(lists[k].counts[c], MAX_LIGHTS_PER_CLUSTER);
+            grid[(k * TILES + c) * 2] = offset;
+            grid[(k * TILES + c) * 2 + 1] = count;
+            offset += count;
+            largest = std::max(largest, count);
+        }
+    }
+
+    indices.resize(offset);
+    if (offset > 0) {
+        Jobs::parallelFor(Z, 1, scatterSlice, nullptr);
+    }
+
+    upload(lightBuffer, lightData, 8);
+    upload(gridBuffer, grid, 2);
+    upload(indexBuffer, indices, 1);
+
+    Stats::set("cluster_lights", (double)viewLights.size());
+    Stats::set("cluster_indices", (double)offset);
+    Stats::set("cluster_max_lights", (double)largest);
+    Stats::set("cluster_build_ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void Clusters::bind(Shader &shader, int firstUnit) {
+    GLState::activeTexture(GL_TEXTURE0 + firstUnit);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, lightTexture);
+    GLState::activeTexture(GL_TEXTURE0 + firstUnit + 1);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, gridTexture);
+    GLState::activeTexture(GL_TEXTURE0 + firstUnit + 2);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, indexTexture);
+
+    shader.setInt("clusterLights", firstUnit);
+    shader.setInt("clusterGrid", firstUnit + 1);
+    shader.setInt("clusterIndices", firstUnit + 2);
+
+    // The fragment shader finds its slice as log(depth) * scale + bias
+    float scale = Z / std::log(farDepth / nearDepth);
+    shader.setVec3("clusterDims", (float)X, (float)Y, (float)Z);
+    shader.setVec2("clusterDepth", glm::vec2(scale, -std::log(nearDepth) * scale));
+}
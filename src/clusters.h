@@ -0,0 +1,34 @@
+#pragma once
+
+#include "./scene.h"
+#include "./shader.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/**
+ * Clustered forward lighting. The view frustum is cut into a grid of
+ * clusters, screen tiles across and exponentially spaced slices in depth.
+ * Every frame the point lights are assigned to the clusters their spheres
+ * touch, one depth slice per job, and the per-cluster light lists go to the
+ * GPU in buffer textures. A fragment then only loops over the lights of its
+ * own cluster, so its cost follows the local light density rather than the
+ * total number of lights. Render thread only.
+ */
+
+namespace Clusters {
+    const int X = 16;
+    const int Y = 9;
+    const int Z = 24;
+    const int MAX_LIGHTS_PER_CLUSTER = 256;     // Further lights in a crowded cluster are dropped
+
+    // Create the buffers
+    extern void init();
+
+    // Assign the lights to the clusters of this view and upload the lists
+    extern void build(const std::vector<Scene::Light> &lights, const glm::mat4 &view, const glm::mat4 &projection);
+
+    // Bind the lists to three texture units from firstUnit on and set the shader's cluster uniforms
+    extern void bind(Shader &shader, int firstUnit);
+}
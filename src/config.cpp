@@ -0,0 +1,192 @@
+#include "./config.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+float Config::simulationRate = 60.0f;
+int Config::maxSimulationSteps = 5;
+
+std::string Config::renderer = "gl";
+int Config::pointLights = 0;
+bool Config::depthPrepass = false;
+bool Config::overdraw = false;
+bool Config::shadows = false;
+float Config::sun = 0.0f;
+int Config::voxelWorld = 0;
+bool Config::occlusion = false;
+bool Config::gpuCulling = false;
+
+bool Config::lod = false;
+float Config::lodError = 0.01f;
+float Config::lodImpostor = 0.04f;
+
+int Config::streamRadius = 0;
+int Config::streamBudget = 64;
+int Config::streamUpload = 512;
+int Config::streamThreads = 2;
+
+int Config::swapInterval = 1;
+float Config::targetFrameRate = 0.0f;
+int Config::maxFramesInFlight = 2;
+bool Config::lowLatency = false;
+std::string Config::latencyLog;
+
+bool Config::dynamicResolution = false;
+float Config::targetFrameTime = 16.0f;
+float Config::minRenderScale = 0.5f;
+std::string Config::upscaleFilter = "bilinear";
+float Config::sharpness = 0.5f;
+
+int Config::renderTargetEvictFrames = 120;
+
+std::string Config::capture;
+int Config::captureLatency = 3;
+int Config::captureQueue = 8;
+
+std::string Config::bench;
+int Config::benchFrames = 120;
+int Config::benchWarmup = 10;
+std::string Config::goldenDir = "../golden";
+std::string Config::benchOutput = ".";
+bool Config::updateGolden = false;
+int Config::goldenTolerance = 2;
+float Config::goldenMaxMismatch = 0.001f;
+float Config::perfTolerance = 0.25f;
+bool Config::nullGL = false;
+int Config::glCallBudget = 0;
+std::string Config::glTrace;
+int Config::glTraceFrames = 60;
+
+bool Config::stats = false;
+bool Config::allocTrack = false;
+int Config::allocSample = 0;
+bool Config::allocCheck = false;
+
+namespace {
+    enum OptionType {
+        FLOAT,
+        INT,
+        BOOL,
+        STRING
+    };
+
+    struct Option {
+        const char *name;
+        OptionType type;
+        void *value;
+    };
+
+    const Option OPTIONS[] = {
+        {"sim-rate", FLOAT, &Config::simulationRate},
+        {"sim-max-steps", INT, &Config::maxSimulationSteps},
+        {"renderer", STRING, &Config::renderer},
+        {"point-lights", INT, &Config::pointLights},
+        {"depth-prepass", BOOL, &Config::depthPrepass},
+        {"overdraw", BOOL, &Config::overdraw},
+        {"shadows", BOOL, &Config::shadows},
+        {"sun", FLOAT, &Config::sun},
+        {"voxel-world", INT, &Config::voxelWorld},
+        {"occlusion", BOOL, &Config::occlusion},
+        {"gpu-culling", BOOL, &Config::gpuCulling},
+        {"lod", BOOL, &Config::lod},
+        {"lod-error", FLOAT, &Config::lodError},
+        {"lod-impostor", FLOAT, &Config::lodImpostor},
+        {"stream-radius", INT, &Config::streamRadius},
+        {"stream-budget", INT, &Config::streamBudget},
+        {"stream-upload", INT, &Config::streamUpload},
+        {"stream-threads", INT, &Config::streamThreads},
+        {"swap-interval", INT, &Config::swapInterval},
+        {"fps", FLOAT, &Config::targetFrameRate},
+        {"frames-in-flight", INT, &Config::maxFramesInFlight},
+        {"low-latency", BOOL, &Config::lowLatency},
+        {"latency-log", STRING, &Config::latencyLog},
+        {"dynamic-resolution", BOOL, &Config::dynamicResolution},
+        {"target-frame-time", FLOAT, &Config::targetFrameTime},
+        {"min-render-scale", FLOAT, &Config::minRenderScale},
+        {"upscale-filter", STRING, &Config::upscaleFilter},
+        {"sharpness", FLOAT, &Config::sharpness},
+        {"rt-evict-frames", INT, &Config::renderTargetEvictFrames},
+        {"capture", STRING, &Config::capture},
+        {"capture-latency", INT, &Config::captureLatency},
+        {"capture-queue", INT, &Config::captureQueue},
+        {"bench", STRING, &Config::bench},
+        {"bench-frames", INT, &Config::benchFrames},
+        {"bench-warmup", INT, &Config::benchWarmup},
+        {"golden-dir", STRING, &Config::goldenDir},
+        {"bench-output", STRING, &Config::benchOutput},
+        {"update-golden", BOOL, &Config::updateGolden},
+        {"golden-tolerance", INT, &Config::goldenTolerance},
+        {"golden-max-mismatch", FLOAT, &Config::goldenMaxMismatch},
+        {"perf-tolerance", FLOAT, &Config::perfTolerance},
+        {"null-gl", BOOL, &Config::nullGL},
+        {"gl-call-budget", INT, &Config::glCallBudget},
+        {"gl-trace", STRING, &Config::glTrace},
+        {"gl-trace-frames", INT, &Config::glTraceFrames},
+        {"stats", BOOL, &Config::stats},
+        {"alloc-track", BOOL, &Config::allocTrack},
+        {"alloc-sample", INT, &Config::allocSample},
+        {"alloc-check", BOOL, &Config::allocCheck}
+    };
+
+    bool assign(const Option &option, const std::string &value) {
+        switch (option.type) {
+            case FLOAT:
+                *static_cast<float*>(option.value) = std::strtof(value.c_str(), nullptr);
+                return true;
+            case INT:
+                *static_cast<int*>(option.value) = std::atoi(value.c_str());
+                return true;
+            case BOOL:
+                *static_cast<bool*>(option.value) = value.empty() || value == "1" || value == "true" || value == "on";
+                return true;
+            case STRING:
+                *static_cast<std::string*>(option.value) = value;
+                return true;
+        }
+        return false;
+    }
+}
+
+void Config::parse(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            std::cout << "WARNING::CONFIG::IGNORED_ARGUMENT " << arg << std::endl;
+            continue;
+        }
+
+        // --name=value, a bare --name sets booleans
+        std::size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+        bool found = false;
+        for (const Option &option : OPTIONS) {
+            if (name == option.name) {
+                found = assign(option, value);
+                break;
+            }
+        }
+        if (!found) {
+            std::cout << "WARNING::CONFIG::UNKNOWN_OPTION " << name << std::endl;
+        }
+    }
+
+    // A step of no length would never be reached, and no steps would never show anything
+    if (!(Config::simulationRate > 0.0f)) {
+        std::cout << "ERROR::CONFIG::INVALID_VALUE sim-rate must be above 0, using 60" << std::endl;
+        Config::simulationRate = 60.0f;
+    }
+    if (Config::maxSimulationSteps < 1) {
+        std::cout << "ERROR::CONFIG::INVALID_VALUE sim-max-steps must be at least 1, using 1" << std::endl;
+        Config::maxSimulationSteps = 1;
+    }
+
+    // GL 4.3 entry points are loaded outside glad, so the trace would miss them and replay without them
+    if (!Config::glTrace.empty() && Config::gpuCulling) {
+        std::cout << "ERROR::CONFIG::INVALID_VALUE gl-trace can't record gpu-culling, turning gpu-culling off" << std::endl;
+        Config::gpuCulling = false;
+    }
+}
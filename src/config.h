@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Runtime options, set from the command line as --name=value
+ */
+
+namespace Config {
+    // Simulation
+    extern float simulationRate;        // Fixed simulation steps per second
+    extern int maxSimulationSteps;      // Catch up steps per loop iteration before time is dropped
+
+    // Rendering
+    extern std::string renderer;        // "gl" forward shaded, "deferred" through a G-buffer, or "soft" for the CPU rasterizer
+    extern int pointLights;             // Random point lights scattered around the scene
+    extern bool depthPrepass;           // Lay down depth first so the lit shader runs once per pixel
+    extern bool overdraw;               // Show fragments shaded per pixel instead of the scene
+    extern bool shadows;                // Cached shadow maps for the main light and the sun
+    extern float sun;                   // Brightness of the directional light, 0 for none
+    extern int voxelWorld;              // Voxel chunks per side of the terrain around the origin, 0 for none
+    extern bool occlusion;              // Skip instances hidden behind the largest cubes, tested on the CPU
+    extern bool gpuCulling;             // Cull and draw the static lit cubes with compute and indirect draws, GL 4.3
+
+    // Level of detail
+    extern bool lod;                    // Coarser meshes and impostors for distant objects, off by default
+    extern float lodError;              // Error a level may show, as a fraction of half the screen height
+    extern float lodImpostor;           // Size below which lit cubes become billboards, radius over half the screen height
+
+    // World streaming
+    extern int streamRadius;            // Chunks around the camera kept loaded, 0 disables
+    extern int streamBudget;            // Megabytes of GPU memory for streamed chunk meshes
+    extern int streamUpload;            // Kilobytes of chunk meshes uploaded per frame at most
+    extern int streamThreads;           // Background threads generating and meshing chunks
+
+    // Frame pacing
+    extern int swapInterval;            // Passed to glfwSwapInterval, 0 disables vsync
+    extern float targetFrameRate;       // Frames per second cap, 0 for none
+    extern int maxFramesInFlight;       // Frames the CPU may run ahead of the GPU
+    extern bool lowLatency;             // Sleep before picking up the newest frame instead of after
+    extern std::string latencyLog;      // CSV file receiving per frame latency, empty for none
+
+    // Dynamic resolution
+    extern bool dynamicResolution;      // Render offscreen at a scale driven by GPU frame time
+    extern float targetFrameTime;       // GPU milliseconds the controller aims for
+    extern float minRenderScale;        // Lowest scale per axis
+    extern std::string upscaleFilter;   // "bilinear" or "sharpen"
+    extern float sharpness;             // Strength of the sharpening filter
+
+    // Render target pool
+    extern int renderTargetEvictFrames; // Frames a pooled texture may sit unused before it is freed
+
+    // Frame capture
+    extern std::string capture;         // Output .y4m file, or a path prefix for a PNG sequence. Empty disables
+    extern int captureLatency;          // Frames between reading back and mapping a pixel buffer
+    extern int captureQueue;            // Frames waiting for the encoder before new ones get dropped
+
+    // Regression runs
+    extern std::string bench;           // Comma separated bench scenes or "all", runs headless and exits. Empty disables
+    extern int benchFrames;             // Frames rendered per scene, the last one is compared to the golden image
+    extern int benchWarmup;             // Leading frames left out of the timings
+    extern std::string goldenDir;       // Directory holding <scene>.ppm and <scene>.time, the latter relative to the calibration scene
+    extern std::string benchOutput;     // Directory the frames and diffs of failed image checks go to
+    extern bool updateGolden;           // Write the results as the new reference instead of comparing
+    extern int goldenTolerance;         // Per channel difference a pixel may have and still match
+    extern float goldenMaxMismatch;     // Fraction of pixels allowed to differ beyond the tolerance
+    extern float perfTolerance;         // Fraction the median frame time may exceed the baseline by, negative skips the check
+    extern bool nullGL;                 // Bench without a window, GL calls only get counted
+    extern int glCallBudget;            // GL calls a bench frame may make under null GL, 0 for no limit
+    extern std::string glTrace;         // File to record the context's GL calls to for glreplay. Empty disables
+    extern int glTraceFrames;           // Frames to record before the trace is closed
+
+    // Reporting
+    extern bool stats;                  // Print Stats once a second
+    extern bool allocTrack;             // Count heap allocations per frame and per scope into Stats
+    extern int allocSample;             // Record the call stack of every Nth allocation and print the top ones at exit, 0 disables
+    extern bool allocCheck;             // Bench scenes fail when a frame after the warmup allocates
+
+    // Parse the arguments main received, unknown options are reported and ignored
+    extern void parse(int argc, char** argv);
+}
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "./glstate.h"
+
 std::size_t Cube::vertSize = 8 * sizeof(float);
 
 std::vector<float> Cube::vertices = {
@@ -49,8 +51,8 @@ std::vector<float> Cube::vertices = {
     -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,   0.0f, 1.0f, 0.0f
 };
 
-std::size_t Cube::vertCount = Cube::vertices.size();
-std::size_t Cube::cubeSize = Cube::vertCount * sizeof(float);
+std::size_t Cube::cubeSize = Cube::vertices.size() * sizeof(float);
+std::size_t Cube::vertCount = Cube::cubeSize / Cube::vertSize;
 
 void Cube::createCube(unsigned int &VAO, unsigned int &VBO, const unsigned int &posAttribPointer) {
     // Generate the objects
@@ -58,8 +60,8 @@ void Cube::createCube(unsigned int &VAO, unsigned int &VBO, const unsigned int &
     glGenBuffers(1, &VBO);
     
     //Bind the objects
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     //Load the vertex data
     glBufferData(GL_ARRAY_BUFFER, Cube::cubeSize, &Cube::vertices[0], GL_STATIC_DRAW);
@@ -69,31 +71,31 @@ void Cube::createCube(unsigned int &VAO, unsigned int &VBO, const unsigned int &
     glEnableVertexAttribArray(posAttribPointer);
 
     //Unbind the VAO
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void Cube::bindNormals(unsigned int &VAO, unsigned int &VBO, const unsigned int &normAttribPointer) {
     //Bind the objects
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     //Set the attribute pointer for the normal data and enable it
     glVertexAttribPointer(normAttribPointer, 3, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)(5 * sizeof(float)));
     glEnableVertexAttribArray(normAttribPointer);
 
     //unbind the VAO
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void Cube::bindTexture(unsigned int &VAO, unsigned int &VBO, const unsigned int &texAttribPointer) {
     //Bind the objects
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     //Set the attribute pointer for the texture data and enable it
     glVertexAttribPointer(texAttribPointer, 2, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(texAttribPointer);
 
     //unbind the VAO
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
@@ -0,0 +1,164 @@
+#include "./drawlist.h"
+#include "./jobs.h"
+#include "./framearena.h"
+#include "./occlusion.h"
+
+#include <algorithm>
+
+namespace {
+    // Culling output only lives until the merge
+    FrameArena arena(256 * 1024);
+
+    // Padded so threads appending to neighbouring lists don't share a cache line
+    struct alignas(64) ThreadList {
+        ThreadList() : commands(FrameArena::Allocator<DrawCommand>(arena)), casters(FrameArena::Allocator<DrawCommand>(arena)), lastSize(0), lastCasters(0) {}
+
+        ArenaVector<DrawCommand> commands;
+        ArenaVector<DrawCommand> casters;
+        std::size_t lastSize;   // Commands recorded last frame, reserved up front
+        std::size_t lastCasters;
+    };
+
+    std::vector<ThreadList> threadLists;
+    std::vector<DrawCommand> merged;
+    std::vector<DrawCommand> mergedCasters;
+    std::vector<DrawCommand> residentCasters;  // Recorded once, the resident cubes never move
+
+    // Concatenate and sort one kind of list of every thread, then hand their memory back
+    void mergeLists(ArenaVector<DrawCommand> ThreadList::*member, std::size_t ThreadList::*last, std::vector<DrawCommand> &out) {
+        out.clear();
+        for (const ThreadList &list : threadLists) {
+            out.insert(out.end(), (list.*member).begin(), (list.*member).end());
+        }
+
+        // Which thread recorded what varies per frame, the key makes the order deterministic
+        std::sort(out.begin(), out.end(), [](const DrawCommand &a, const DrawCommand &b) {
+            return a.key < b.key;
+        });
+
+        for (ThreadList &list : threadLists) {
+            list.*last = (list.*member).size();
+            ArenaVector<DrawCommand>((list.*member).get_allocator()).swap(list.*member);
+        }
+    }
+
+    // Distance gets 24 bits at 1/1024 units, plenty to order roughly front to back
+    std::uint64_t makeKey(Scene::Material material, float distance, std::uint32_t instance) {
+        std::uint64_t depth = (std::uint64_t)std::min(std::max(distance * 1024.0f, 0.0f), 16777215.0f);
+        return ((std::uint64_t)material << 56) | (depth << 32) | instance;
+    }
+}
+
+void DrawList::reset() {
+    if (threadLists.size() != Jobs::maxThreads()) {
+        threadLists = std::vector<ThreadList>(Jobs::maxThreads());
+    }
+    for (ThreadList &list : threadLists) {
+        list.commands.reserve(list.lastSize);
+        list.casters.reserve(list.lastCasters);
+    }
+
+    // Room for everything up front, so more coming into view doesn't grow it mid-run
+    merged.reserve(Scene::instances.size());
+}
+
+void DrawList::record(std::size_t partition, const Frustum &frustum, float lodScale, bool occlusion) {
+    ArenaVector<DrawCommand> &out = threadLists[Jobs::threadIndex()].commands;
+
+    std::size_t begin = partition * Scene::PARTITION_SIZE;
+    std::size_t end = std::min(begin + Scene::PARTITION_SIZE, Scene::instances.size());
+    std::size_t hidden = 0;
+
+    for (std::size_t i = begin; i < end; i++) {
+        Scene::Instance &instance = Scene::instances[i];
+        // Zero scale instances are parked, like unused streaming slots
+        if (instance.radius <= 0.0f || !frustum.SphereVisible(instance.position, instance.radius)) {
+            continue;
+        }
+
+        // Everything is a unit cube scaled, chunks included
+        if (occlusion && !Occlusion::visible(instance.position - instance.scale * 0.5f, instance.position + instance.scale * 0.5f)) {
+            hidden++;
+            continue;
+        }
+
+        // Only lit cubes have billboards in the impostor atlas
+        float distance = frustum.NearDistance(instance.position);
+        instance.lod = Lod::select(instance.radius, distance, lodScale, instance.lodError, instance.material == Scene::LIT, instance.lod);
+
+        DrawCommand command;
+        command.key = makeKey(instance.material, distance, (std::uint32_t)i);
+        command.material = instance.material;
+        command.instance = (std::uint32_t)i;
+        command.mesh = instance.mesh;
+        command.lod = instance.lod;
+        command.model = instance.model;
+        command.previousModel = instance.previousModel;
+        out.push_back(command);
+    }
+
+    if (occlusion) {
+        Occlusion::countHidden(hidden);
+    }
+}
+
+void DrawList::recordCasters(std::size_t partition) {
+    ArenaVector<DrawCommand> &out = threadLists[Jobs::threadIndex()].casters;
+
+    std::size_t begin = partition * Scene::PARTITION_SIZE;
+    std::size_t end = std::min(begin + Scene::PARTITION_SIZE, Scene::instances.size());
+
+    for (std::size_t i = begin; i < end; i++) {
+        const Scene::Instance &instance = Scene::instances[i];
+        if (instance.material != Scene::LIT) {
+            continue;
+        }
+
+        DrawCommand command;
+        command.key = makeKey(instance.material, 0.0f, (std::uint32_t)i);
+        command.material = instance.material;
+        command.instance = (std::uint32_t)i;
+        command.mesh = instance.mesh;
+        command.lod = 0;
+        command.model = instance.model;
+        command.previousModel = instance.previousModel;
+        out.push_back(command);
+    }
+}
+
+const std::vector<DrawCommand>& DrawList::merge() {
+    // The per-thread lists are done with after this, their memory goes back for the next frame
+    mergeLists(&ThreadList::commands, &ThreadList::lastSize, merged);
+    mergeLists(&ThreadList::casters, &ThreadList::lastCasters, mergedCasters);
+
+    // Resident indices have the top bit set, so their keys already sort after every other caster
+    mergedCasters.insert(mergedCasters.end(), residentCasters.begin(), residentCasters.end());
+
+    // Which thread records how much changes every frame. A list outgrowing its reservation
+    // leaves that behind and doubles, so allow three times the commands before spilling to the heap
+    arena.reserve(3 * (Scene::instances.size() + mergedCasters.size() - residentCasters.size()) * sizeof(DrawCommand));
+    arena.reset();
+    return merged;
+}
+
+void DrawList::recordResidentCasters() {
+    residentCasters.clear();
+    for (std::size_t i = 0; i < Scene::resident.size(); i++) {
+        const Scene::Instance &instance = Scene::resident[i];
+        std::uint32_t index = Scene::RESIDENT | (std::uint32_t)i;
+
+        DrawCommand command;
+        command.key = makeKey(instance.material, 0.0f, index);
+        command.material = instance.material;
+        command.instance = index;
+        command.mesh = instance.mesh;
+        command.lod = 0;
+        command.model = instance.model;
+        command.previousModel = instance.previousModel;
+        residentCasters.push_back(command);
+    }
+}
+
+const std::vector<DrawCommand>& DrawList::casters() {
+    return mergedCasters;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "./frustum.h"
+#include "./scene.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Draw commands recorded by jobs into per-thread lists, then merged and
+ * sorted so the GL thread only has to replay them
+ */
+
+struct DrawCommand {
+    std::uint64_t key;          // Sort key: material, then distance front to back, then instance
+    Scene::Material material;
+    std::uint32_t instance;
+    std::uint32_t mesh;         // Voxels mesh or Streaming slot of CHUNK commands
+    std::uint8_t lod;           // Mesh level to draw, or Lod::IMPOSTOR
+    glm::mat4 model;
+    glm::mat4 previousModel;    // Transform one simulation step earlier
+};
+
+namespace DrawList {
+    // Empty every thread's list, call before recording a frame
+    extern void reset();
+
+    // Cull one scene partition and append the survivors to the calling thread's list, choosing each
+    // one's level of detail. lodScale is the projection's y scale, 0 for full detail throughout.
+    // With occlusion the boxes are also tested against Occlusion, which has to be built for the frame
+    extern void record(std::size_t partition, const Frustum &frustum, float lodScale, bool occlusion);
+
+    // Append every lit instance of the partition to the calling thread's shadow caster list, visible or not
+    extern void recordCasters(std::size_t partition);
+
+    // Casters for Scene::resident, which merge() appends every frame. Call once the scene is built
+    extern void recordResidentCasters();
+
+    // Concatenate the per-thread lists and sort them by key
+    extern const std::vector<DrawCommand>& merge();
+
+    // Casters recorded this frame, merged by merge() in instance order
+    extern const std::vector<DrawCommand>& casters();
+}
@@ -0,0 +1,82 @@
+#include "./dynres.h"
+#include "./config.h"
+#include "./glstate.h"
+#include "./gputimer.h"
+#include "./shader.h"
+#include "./stats.h"
+#include "./texture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace {
+    // Controller gains on the normalised error (target - measured) / target
+    const float KP = 0.25f;
+    const float KI = 0.05f;
+
+    std::unique_ptr<Shader> upscaleShader;
+    GLuint emptyVAO;
+    GpuTimer timer;
+
+    float area = 1.0f;          // Controlled value, scale squared since cost follows pixel count
+    float previousError = 0.0f;
+
+    // Velocity form PI step, clamping the output can't wind the integral up
+    void control(double measured) {
+        float target = Config::targetFrameTime;
+        float error = (float)((target - measured) / target);
+        area += KP * (error - previousError) + KI * error;
+        previousError = error;
+
+        float minScale = glm::clamp(Config::minRenderScale, 0.1f, 1.0f);
+        area = glm::clamp(area, minScale * minScale, 1.0f);
+        DynamicResolution::scale = std::sqrt(area);
+    }
+
+    int scaled(int size) {
+        return std::max(1, (int)std::lround(size * DynamicResolution::scale));
+    }
+}
+
+float DynamicResolution::scale = 1.0f;
+double DynamicResolution::frameTime = 0.0;
+
+void DynamicResolution::init() {
+    upscaleShader.reset(new Shader("../src/shaders/upscale.vs", "../src/shaders/upscale.fs"));
+    glGenVertexArrays(1, &emptyVAO);
+}
+
+void DynamicResolution::begin(int targetWidth, int targetHeight) {
+    timer.Begin();
+    GLState::viewport(0, 0, scaled(targetWidth), scaled(targetHeight));
+}
+
+void DynamicResolution::upscale(GLuint source, int targetWidth, int targetHeight, int width, int height) {
+    int renderWidth = scaled(targetWidth);
+    int renderHeight = scaled(targetHeight);
+
+    // Upscale into the window
+    GLState::viewport(0, 0, width, height);
+    GLState::disable(GL_DEPTH_TEST);
+
+    upscaleShader->use();
+    Texture::activate(source, GL_TEXTURE0);
+    upscaleShader->setInt("source", 0);
+    upscaleShader->setVec2("uvScale", glm::vec2((float)renderWidth / targetWidth, (float)renderHeight / targetHeight));
+    upscaleShader->setInt("sharpen", Config::upscaleFilter == "sharpen" ? 1 : 0);
+    upscaleShader->setFloat("sharpness", Config::sharpness);
+
+    GLState::bindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    GLState::enable(GL_DEPTH_TEST);
+
+    // Measurements arrive a few frames late, which the controller tolerates
+    if (timer.End()) {
+        frameTime = timer.Milliseconds;
+        control(frameTime);
+    }
+
+    Stats::set("render_scale", scale);
+    Stats::set("gpu_frame_ms", frameTime);
+}
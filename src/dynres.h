@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+ * Dynamic resolution: the scene renders into an offscreen target at a scale
+ * a PI controller adjusts from measured GPU frame time, then gets upscaled to
+ * the window. Render thread only.
+ */
+
+namespace DynamicResolution {
+    extern float scale;             // Current scale per axis
+    extern double frameTime;        // Last measured GPU frame time in milliseconds
+
+    extern void init();
+
+    // Start timing the frame and set the viewport to the scaled part of a target this size
+    extern void begin(int targetWidth, int targetHeight);
+
+    // Upscale the scaled part of source into the bound framebuffer and feed the controller
+    extern void upscale(GLuint source, int targetWidth, int targetHeight, int width, int height);
+}
@@ -0,0 +1,64 @@
+#include "./framearena.h"
+
+#include <algorithm>
+#include <new>
+
+FrameArena::FrameArena(std::size_t capacity) : size(capacity), offset(0), requested(0), overflow(nullptr) {
+    block = static_cast<char*>(::operator new(size, std::align_val_t(alignof(std::max_align_t))));
+}
+
+FrameArena::~FrameArena() {
+    reset();
+    ::operator delete(block, std::align_val_t(alignof(std::max_align_t)));
+}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment) {
+    requested.fetch_add(bytes + alignment - 1, std::memory_order_relaxed);
+
+    std::size_t current = offset.load(std::memory_order_relaxed);
+    for (;;) {
+        std::size_t start = (current + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > size) {
+            break;
+        }
+        if (offset.compare_exchange_weak(current, start + bytes, std::memory_order_relaxed)) {
+            return block + start;
+        }
+    }
+
+    // Out of space this frame: heap memory, aligned past the link back to the other overflow blocks
+    std::size_t header = (sizeof(Overflow) + alignment - 1) & ~(alignment - 1);
+    std::size_t blockAlignment = std::max(alignment, alignof(Overflow));
+    char *memory = static_cast<char*>(::operator new(header + bytes, std::align_val_t(blockAlignment)));
+    Overflow *node = reinterpret_cast<Overflow*>(memory);
+    node->alignment = blockAlignment;
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    node->next = overflow;
+    overflow = node;
+    return memory + header;
+}
+
+void FrameArena::reserve(std::size_t bytes) {
+    std::size_t current = requested.load(std::memory_order_relaxed);
+    while (current < bytes && !requested.compare_exchange_weak(current, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+void FrameArena::reset() {
+    while (overflow) {
+        Overflow *next = overflow->next;
+        ::operator delete(overflow, std::align_val_t(overflow->alignment));
+        overflow = next;
+    }
+
+    // Grow to what the last frame wanted, with room to spare
+    std::size_t wanted = requested.load(std::memory_order_relaxed);
+    if (wanted > size) {
+        ::operator delete(block, std::align_val_t(alignof(std::max_align_t)));
+        size = wanted + wanted / 2;
+        block = static_cast<char*>(::operator new(size, std::align_val_t(alignof(std::max_align_t))));
+    }
+
+    offset.store(0, std::memory_order_relaxed);
+    requested.store(0, std::memory_order_relaxed);
+}
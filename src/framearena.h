@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * Linear allocator for data that only lives for one frame. Allocation bumps
+ * an offset into one block and may happen from several threads at once;
+ * nothing is freed individually, reset drops everything together. When a
+ * frame needs more than the block holds the excess goes to the heap and the
+ * block grows to fit at the next reset, so steady-state frames stay off the
+ * heap entirely.
+ */
+
+class FrameArena
+{
+    public:
+        explicit FrameArena(std::size_t capacity = 64 * 1024);
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+        // Invalidate everything allocated since the last reset. Not thread safe
+        void reset();
+
+        // Have the next reset leave at least this much room, for frames that can outgrow the last one
+        void reserve(std::size_t bytes);
+
+        std::size_t used() const { return offset.load(std::memory_order_relaxed); }
+        std::size_t capacity() const { return size; }
+
+        // For standard containers. Deallocation is a no-op, memory comes back on reset
+        template<typename T>
+        class Allocator
+        {
+            public:
+                typedef T value_type;
+
+                explicit Allocator(FrameArena &arena) : arena(&arena) {}
+                template<typename U>
+                Allocator(const Allocator<U> &other) : arena(other.arena) {}
+
+                T* allocate(std::size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+                void deallocate(T*, std::size_t) {}
+
+                template<typename U>
+                bool operator==(const Allocator<U> &other) const { return arena == other.arena; }
+                template<typename U>
+                bool operator!=(const Allocator<U> &other) const { return arena != other.arena; }
+
+            private:
+                template<typename U> friend class Allocator;
+                FrameArena *arena;
+        };
+
+    private:
+        // Heap blocks taken when the arena ran out, freed on reset
+        struct Overflow {
+            Overflow *next;
+            std::size_t alignment;
+        };
+
+        char *block;
+        std::size_t size;
+        std::atomic<std::size_t> offset;
+        std::atomic<std::size_t> requested;    // Bytes asked for since the last reset, including padding
+        Overflow *overflow;
+        std::mutex overflowMutex;
+};
+
+// A vector whose storage comes from a FrameArena, empty it before the arena is reset
+template<typename T>
+using ArenaVector = std::vector<T, FrameArena::Allocator<T>>;
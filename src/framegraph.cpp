@@ -0,0 +1,219 @@
+#include "./framegraph.h"
+#include "./stats.h"
+
+#include <algorithm>
+
+GLuint FrameGraph::Context::texture(Resource resource) const {
+    return graph.resources[resource].texture;
+}
+
+void FrameGraph::Context::bindFramebuffer(const Resource *colors, int colorCount, Resource depth) const {
+    GLuint textures[4];
+    int count = std::min(colorCount, 4);
+    bool backbuffer = false;
+    for (int i = 0; i < count; i++) {
+        const ResourceNode &node = graph.resources[colors[i]];
+        textures[i] = node.texture;
+        backbuffer = backbuffer || (node.imported && node.texture == 0);
+    }
+
+    if (backbuffer || (count == 0 && depth < 0)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    GLuint depthTexture = depth >= 0 ? graph.resources[depth].texture : 0;
+    glBindFramebuffer(GL_FRAMEBUFFER, RenderTargets::framebuffer(textures, count, depthTexture));
+}
+
+void FrameGraph::reset() {
+    for (PassNode &pass : passes) {
+        pass.destroy(pass.state);
+    }
+    resources.clear();
+    passes.clear();
+    order.clear();
+    arena.reset();
+}
+
+FrameGraph::Resource FrameGraph::create(const char* name, const RenderTargetDesc &desc) {
+    ResourceNode node = {name, desc, false, 0, 0, -1, -1, ArenaVector<Pass>(FrameArena::Allocator<Pass>(arena))};
+    resources.push_back(std::move(node));
+    return (Resource)resources.size() - 1;
+}
+
+FrameGraph::Resource FrameGraph::import(const char* name, GLuint texture) {
+    Resource resource = create(name, RenderTargets::fixed(1, 1, GL_RGBA8));
+    resources[resource].imported = true;
+    resources[resource].texture = texture;
+    return resource;
+}
+
+FrameGraph::Pass FrameGraph::addPass(const char* name, void *state, Invoke invoke, Destroy destroy) {
+    FrameArena::Allocator<Resource> allocator(arena);
+    PassNode node = {name, state, invoke, destroy, ArenaVector<Resource>(allocator), ArenaVector<Resource>(allocator), false, false, 0};
+    passes.push_back(std::move(node));
+    return (Pass)passes.size() - 1;
+}
+
+void FrameGraph::read(Pass pass, Resource resource) {
+    passes[pass].reads.push_back(resource);
+}
+
+void FrameGraph::write(Pass pass, Resource resource) {
+    passes[pass].writes.push_back(resource);
+    resources[resource].writers.push_back(pass);
+}
+
+void FrameGraph::sideEffect(Pass pass) {
+    passes[pass].sideEffect = true;
+}
+
+void FrameGraph::compile() {
+    for (ResourceNode &resource : resources) {
+        resource.refCount = 0;
+        resource.firstUse = resource.lastUse = -1;
+    }
+
+    // 1. Reference counts: passes by what they write, resources by who reads them
+    for (PassNode &pass : passes) {
+        pass.refCount = (int)pass.writes.size();
+        pass.culled = false;
+        for (Resource r : pass.reads) {
+            resources[r].refCount++;
+        }
+    }
+    for (ResourceNode &resource : resources) {
+        if (resource.imported) {
+            resource.refCount++;
+        }
+    }
+
+    // 2. Cull: flood from unreferenced resources back through their writers
+    FrameArena::Allocator<Pass> allocator(arena);
+    ArenaVector<Resource> unused(allocator);
+    for (std::size_t r = 0; r < resources.size(); r++) {
+        if (resources[r].refCount == 0) {
+            unused.push_back((Resource)r);
+        }
+    }
+    while (!unused.empty()) {
+        Resource r = unused.back();
+        unused.pop_back();
+        for (Pass p : resources[r].writers) {
+            PassNode &pass = passes[p];
+            if (--pass.refCount > 0 || pass.sideEffect || pass.culled) {
+                continue;
+            }
+            pass.culled = true;
+            for (Resource read : pass.reads) {
+                if (--resources[read].refCount == 0) {
+                    unused.push_back(read);
+                }
+            }
+        }
+    }
+
+    // 3. Order: readers of a transient run after its writers. Imported resources have contents
+    // from before the frame, so there a reader only follows the writers declared before it.
+    // Several writers of one resource keep their declaration order. Kahn's algorithm, lowest index first
+    std::size_t count = passes.size();
+    ArenaVector<int> indegree(count, 0, allocator);
+    ArenaVector<ArenaVector<Pass>> successors(count, ArenaVector<Pass>(allocator), allocator);
+    auto edge = [&](Pass from, Pass to) {
+        if (from != to && !passes[from].culled && !passes[to].culled) {
+            successors[from].push_back(to);
+            indegree[to]++;
+        }
+    };
+    for (std::size_t p = 0; p < count; p++) {
+        for (Resource r : passes[p].reads) {
+            for (Pass writer : resources[r].writers) {
+                if (writer < (Pass)p || !resources[r].imported) {
+                    edge(writer, (Pass)p);
+                } else {
+                    edge((Pass)p, writer);
+                }
+            }
+        }
+    }
+    for (ResourceNode &resource : resources) {
+        for (std::size_t i = 1; i < resource.writers.size(); i++) {
+            edge(resource.writers[i - 1], resource.writers[i]);
+        }
+    }
+
+    order.clear();
+    ArenaVector<Pass> ready(allocator);
+    for (std::size_t p = 0; p < count; p++) {
+        if (!passes[p].culled && indegree[p] == 0) {
+            ready.push_back((Pass)p);
+        }
+    }
+    while (!ready.empty()) {
+        auto lowest = std::min_element(ready.begin(), ready.end());
+        Pass p = *lowest;
+        ready.erase(lowest);
+        order.push_back(p);
+        for (Pass next : successors[p]) {
+            if (--indegree[next] == 0) {
+                ready.push_back(next);
+            }
+        }
+    }
+
+    // 4. Lifetimes of transient resources over the execution order
+    culled = 0;
+    for (const PassNode &pass : passes) {
+        culled += pass.culled ? 1 : 0;
+    }
+    for (std::size_t i = 0; i < order.size(); i++) {
+        const PassNode &pass = passes[order[i]];
+        auto use = [&](Resource r) {
+            ResourceNode &resource = resources[r];
+            if (resource.firstUse < 0) {
+                resource.firstUse = (int)i;
+            }
+            resource.lastUse = (int)i;
+        };
+        std::for_each(pass.reads.begin(), pass.reads.end(), use);
+        std::for_each(pass.writes.begin(), pass.writes.end(), use);
+    }
+}
+
+void FrameGraph::execute() {
+    FrameArena::Allocator<GLuint> allocator(arena);
+    ArenaVector<GLuint> physical(allocator);
+    peak = 0;
+    unaliased = 0;
+
+    for (std::size_t i = 0; i < order.size(); i++) {
+        // Transients start their life right before their first pass
+        for (ResourceNode &resource : resources) {
+            if (!resource.imported && resource.firstUse == (int)i) {
+                resource.texture = RenderTargets::acquire(resource.desc);
+                std::size_t size = RenderTargets::bytes(resource.desc);
+                unaliased += size;
+                if (std::find(physical.begin(), physical.end(), resource.texture) == physical.end()) {
+                    physical.push_back(resource.texture);
+                    peak += size;
+                }
+            }
+        }
+
+        const PassNode &pass = passes[order[i]];
+        pass.invoke(pass.state, Context(*this));
+
+        // and go back to the pool after their last one, free for the next resource of the same shape
+        for (ResourceNode &resource : resources) {
+            if (!resource.imported && resource.lastUse == (int)i) {
+                RenderTargets::release(resource.texture);
+            }
+        }
+    }
+
+    Stats::set("framegraph_passes", (double)order.size());
+    Stats::set("framegraph_culled", culled);
+    Stats::set("framegraph_transient_mb", peak / (1024.0 * 1024.0));
+    Stats::set("framegraph_unaliased_mb", unaliased / (1024.0 * 1024.0));
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "./rtpool.h"
+#include "./framearena.h"
+
+#include <glad/glad.h>
+
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * Frame graph: passes declare which resources they read and write, then the
+ * graph is compiled every frame. Passes whose output nobody consumes are
+ * culled, the rest are ordered by their dependencies, and transient render
+ * targets are taken from the pool at first use and returned after last use
+ * so resources whose lifetimes don't overlap share the same texture. The
+ * per-frame bookkeeping, pass callbacks included, lives in an arena that is
+ * dropped on reset, so rebuilding the graph doesn't touch the heap.
+ */
+
+class FrameGraph
+{
+    public:
+        typedef int Resource;
+        typedef int Pass;
+
+        // Handed to a pass while it executes
+        class Context
+        {
+            public:
+                explicit Context(FrameGraph &graph) : graph(graph) {}
+
+                // Texture backing a resource, 0 for the backbuffer
+                GLuint texture(Resource resource) const;
+
+                // Bind a framebuffer with these attachments, backbuffer resources bind the default one
+                void bindFramebuffer(const Resource *colors, int colorCount, Resource depth) const;
+
+            private:
+                FrameGraph &graph;
+        };
+
+        FrameGraph() = default;
+        FrameGraph(const FrameGraph&) = delete;
+        FrameGraph& operator=(const FrameGraph&) = delete;
+        ~FrameGraph() { reset(); }
+
+        // Drop all passes and resources, keeping storage for the next frame
+        void reset();
+
+        // A render target that only lives within this frame
+        Resource create(const char* name, const RenderTargetDesc &desc);
+
+        // An existing texture, or 0 for the default framebuffer. Imported resources count as outputs
+        Resource import(const char* name, GLuint texture);
+
+        // execute is called with a const Context& when the pass runs
+        template<typename F>
+        Pass addPass(const char* name, F execute) {
+            void *state = new (arena.allocate(sizeof(F), alignof(F))) F(std::move(execute));
+            return addPass(name, state, [](void *state, const Context &ctx) {
+                (*static_cast<F*>(state))(ctx);
+            }, [](void *state) {
+                static_cast<F*>(state)->~F();
+            });
+        }
+
+        void read(Pass pass, Resource resource);
+        void write(Pass pass, Resource resource);
+
+        // Keep the pass even if nothing reads what it writes
+        void sideEffect(Pass pass);
+
+        // Cull, order and compute resource lifetimes
+        void compile();
+
+        // Run the surviving passes in order, allocating and releasing transients around them
+        void execute();
+
+        // Results of the last compile/execute
+        int culledPasses() const { return culled; }
+        std::size_t peakBytes() const { return peak; }          // Transient memory actually used
+        std::size_t unaliasedBytes() const { return unaliased; } // What it would be without sharing
+
+    private:
+        typedef void (*Invoke)(void *state, const Context &ctx);
+        typedef void (*Destroy)(void *state);
+
+        Pass addPass(const char* name, void *state, Invoke invoke, Destroy destroy);
+
+        struct ResourceNode {
+            const char* name;
+            RenderTargetDesc desc;
+            bool imported;
+            GLuint texture;
+            int refCount;
+            int firstUse, lastUse;  // Positions in the execution order
+            ArenaVector<Pass> writers;
+        };
+
+        struct PassNode {
+            const char* name;
+            void *state;            // The callback, stored in the arena
+            Invoke invoke;
+            Destroy destroy;
+            ArenaVector<Resource> reads;
+            ArenaVector<Resource> writes;
+            bool sideEffect;
+            bool culled;
+            int refCount;
+        };
+
+        FrameArena arena;
+        std::vector<ResourceNode> resources;
+        std::vector<PassNode> passes;
+        std::vector<Pass> order;
+
+        int culled = 0;
+        std::size_t peak = 0;
+        std::size_t unaliased = 0;
+};
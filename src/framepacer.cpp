@@ -0,0 +1,151 @@
+#include "./framepacer.h"
+#include "./config.h"
+#include "./stats.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace {
+    const int MAX_IN_FLIGHT = 8;
+    const int RECALIBRATE_FRAMES = 300;   // Re-sync the GPU and CPU clocks this often
+    const double SLEEP_MARGIN = 0.0005;    // Wake this early for a low latency frame
+
+    // One slot per frame that may be in flight
+    struct Slot {
+        GLsync fence;
+        GLuint timestamp;       // GL_TIMESTAMP query written when the GPU got to the end of the frame
+        double submitTime;      // CPU time the frame was handed over
+        double inputTime;
+        unsigned long frame;
+    };
+
+    Slot slots[MAX_IN_FLIGHT];
+    int inFlight = 2;
+    unsigned long frame = 0;
+
+    double frameStart = 0.0;
+    double workEstimate = 0.0;  // Smoothed time from beginFrame returning to endFrame
+    double period = 0.0;        // Smoothed time between frames
+
+    // GPU timestamp (ns) to glfwGetTime() (s) offset
+    double clockOffset = 0.0;
+
+    std::ofstream log;
+
+    void calibrate() {
+        GLint64 gpu;
+        glGetInteger64v(GL_TIMESTAMP, &gpu);
+        clockOffset = glfwGetTime() - gpu * 1e-9;
+    }
+
+    // Sleep most of the way then spin, sleep_for alone overshoots by a millisecond or more
+    void sleepUntil(double target) {
+        double remaining = target - glfwGetTime();
+        if (remaining > 0.002) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.0015));
+        }
+        while (glfwGetTime() < target) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Wait for a frame's fence and record its latency
+    void retire(Slot &slot) {
+        if (!slot.fence) {
+            return;
+        }
+
+        while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+
+        GLuint64 gpuDone;
+        glGetQueryObjectui64v(slot.timestamp, GL_QUERY_RESULT, &gpuDone);
+        double done = gpuDone * 1e-9 + clockOffset;
+
+        double latency = done - slot.submitTime;
+        double input = slot.inputTime > 0.0 ? done - slot.inputTime : 0.0;
+        FramePacer::gpuLatency.store(latency);
+        if (input > 0.0) {
+            FramePacer::inputLatency.store(input);
+            Stats::set("input_latency_ms", input * 1000.0);
+        }
+        Stats::set("gpu_latency_ms", latency * 1000.0);
+
+        if (log.is_open()) {
+            log << slot.frame << "," << slot.submitTime << "," << done << ","
+                << latency * 1000.0 << "," << input * 1000.0 << "," << period * 1000.0 << "\n";
+        }
+    }
+}
+
+std::atomic<double> FramePacer::gpuLatency(0.0);
+std::atomic<double> FramePacer::inputLatency(0.0);
+
+void FramePacer::init() {
+    glfwSwapInterval(Config::swapInterval);
+
+    inFlight = std::max(1, std::min(Config::maxFramesInFlight, MAX_IN_FLIGHT));
+    for (Slot &slot : slots) {
+        slot.fence = 0;
+        glGenQueries(1, &slot.timestamp);
+    }
+    calibrate();
+
+    if (!Config::latencyLog.empty()) {
+        log.open(Config::latencyLog);
+        log << "frame,submit_s,gpu_done_s,gpu_latency_ms,input_latency_ms,frame_period_ms\n";
+    }
+    frameStart = glfwGetTime();
+}
+
+void FramePacer::shutdown() {
+    for (Slot &slot : slots) {
+        retire(slot);
+        glDeleteQueries(1, &slot.timestamp);
+    }
+    log.close();
+}
+
+void FramePacer::beginFrame() {
+    // Never let the CPU get more than inFlight frames ahead of the GPU
+    retire(slots[frame % inFlight]);
+
+    if (frame % RECALIBRATE_FRAMES == 0) {
+        calibrate();
+    }
+
+    // Frame rate cap, or the expected vsync period in low latency mode
+    double target = Config::targetFrameRate > 0.0f ? 1.0 / Config::targetFrameRate : 0.0;
+    double next = frameStart + target;
+    if (Config::lowLatency) {
+        // Start as late as possible so the packet we pick up is as fresh as possible
+        double length = target > 0.0 ? target : period;
+        next = frameStart + length - workEstimate - SLEEP_MARGIN;
+    }
+    sleepUntil(next);
+
+    double now = glfwGetTime();
+    period = period == 0.0 ? now - frameStart : period * 0.9 + (now - frameStart) * 0.1;
+    frameStart = now;
+}
+
+void FramePacer::endFrame(double inputTime) {
+    double now = glfwGetTime();
+    workEstimate = workEstimate * 0.9 + (now - frameStart) * 0.1;
+
+    Slot &slot = slots[frame % inFlight];
+    glQueryCounter(slot.timestamp, GL_TIMESTAMP);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.submitTime = now;
+    slot.inputTime = inputTime;
+    slot.frame = frame;
+
+    frame++;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * Paces the render thread: caps frames in flight with fences, applies the
+ * swap interval and an optional frame rate cap, and measures how long each
+ * frame takes from CPU submission to GPU completion. Render thread only.
+ */
+
+namespace FramePacer {
+    // Apply the swap interval and create the queries, needs the context
+    extern void init();
+    extern void shutdown();
+
+    // Call before picking up the frame's data: waits for old frames and sleeps as configured
+    extern void beginFrame();
+
+    // Call right before the swap. inputTime is the oldest input event shown this frame, 0 if none
+    extern void endFrame(double inputTime);
+
+    // Results of the most recently retired frame, in seconds
+    extern std::atomic<double> gpuLatency;      // Submission to GPU completion
+    extern std::atomic<double> inputLatency;    // Oldest input event to GPU completion
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "./drawlist.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Camera values the render thread interpolates between simulation steps
+struct CameraState {
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+    float zoom;
+};
+
+// Everything the render thread needs to draw one frame, produced by the simulation thread
+struct FramePacket {
+    std::uint64_t sequence;             // Incremented for every published packet
+    std::uint64_t streamFrame;          // Streaming::frame() when recorded, later chunk uploads wait for a later packet
+    CameraState previousCamera;         // Camera after the step before the last one
+    CameraState camera;                 // Camera after the last step
+    double stepTime;                    // glfwGetTime() at which the last step's state is current
+    float stepLength;                   // Seconds per simulation step
+    double inputTime;                   // Timestamp of the oldest input event applied, 0 if none
+    glm::vec3 lightPos;
+    glm::vec3 lightColor;
+    glm::vec3 sunDirection;             // Direction the sunlight travels
+    glm::vec3 sunColor;                 // Black for no sun
+    std::vector<DrawCommand> commands;  // Visible instances, merged and sorted
+    std::vector<Scene::Light> lights;   // Point lights on top of the main one
+    std::vector<DrawCommand> casters;   // Every lit instance, seen or not, when shadows are on
+    std::vector<float> occlusionDepth;  // Occlusion's pyramid for GPU culling, empty unless both are on
+    glm::mat4 occlusionViewProjection;  // View the pyramid was built for
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum planes extracted from a combined projection * view matrix, used for culling
+class Frustum
+{
+    public:
+        // Plane equations (normal.xyz, distance), normals point inwards
+        glm::vec4 Planes[6];
+
+        Frustum() {}
+
+        // Gribb/Hartmann extraction: each plane is the fourth row plus or minus one of the others
+        explicit Frustum(const glm::mat4 &m)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                glm::vec4 row   = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+                glm::vec4 wrow  = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+                Planes[i * 2]     = normalizePlane(wrow + row);
+                Planes[i * 2 + 1] = normalizePlane(wrow - row);
+            }
+        }
+
+        // Returns false only when the sphere is completely outside
+        bool SphereVisible(const glm::vec3 &center, float radius) const
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                if (glm::dot(glm::vec3(Planes[i]), center) + Planes[i].w < -radius)
+                    return false;
+            }
+            return true;
+        }
+
+        // Returns false only when the axis aligned box is completely outside
+        bool BoxVisible(const glm::vec3 &min, const glm::vec3 &max) const
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                // Test the corner furthest along the plane normal
+                glm::vec3 p = glm::vec3(Planes[i].x > 0 ? max.x : min.x,
+                                        Planes[i].y > 0 ? max.y : min.y,
+                                        Planes[i].z > 0 ? max.z : min.z);
+                if (glm::dot(glm::vec3(Planes[i]), p) + Planes[i].w < 0.0f)
+                    return false;
+            }
+            return true;
+        }
+
+        // Signed distance of a point in front of the near plane
+        float NearDistance(const glm::vec3 &point) const
+        {
+            return glm::dot(glm::vec3(Planes[4]), point) + Planes[4].w;
+        }
+
+    private:
+        static glm::vec4 normalizePlane(const glm::vec4 &plane)
+        {
+            return plane / glm::length(glm::vec3(plane));
+        }
+};
@@ -0,0 +1,29 @@
+#include "./gl43.h"
+
+namespace {
+    bool available = false;
+}
+
+GL43::DispatchComputeProc GL43::dispatchCompute = nullptr;
+GL43::MemoryBarrierProc GL43::memoryBarrier = nullptr;
+GL43::MultiDrawElementsIndirectProc GL43::multiDrawElementsIndirect = nullptr;
+
+bool GL43::load(LoadProc getProcAddress) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 3)) {
+        available = false;
+        return false;
+    }
+
+    dispatchCompute = (DispatchComputeProc)getProcAddress("glDispatchCompute");
+    memoryBarrier = (MemoryBarrierProc)getProcAddress("glMemoryBarrier");
+    multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)getProcAddress("glMultiDrawElementsIndirect");
+    available = dispatchCompute && memoryBarrier && multiDrawElementsIndirect;
+    return available;
+}
+
+bool GL43::loaded() {
+    return available;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+/**
+ * The GL 4.3 entry points GPU culling needs on top of the 3.3 core glad
+ * loads: compute dispatch, memory barriers and indirect multi-draw. They are
+ * loaded through the same proc address function as glad, and only when the
+ * context is 4.3 or later. GL43Function numbers them in this order, after
+ * the entry points of glfunctions.h, for layers that count calls.
+ */
+
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+
+namespace GL43 {
+    typedef void (APIENTRYP DispatchComputeProc)(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+    typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+    typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount, GLsizei stride);
+    typedef void* (*LoadProc)(const char *name);
+
+    // Layout glMultiDrawElementsIndirect reads from the indirect buffer
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+}
+
+#define GL43_FUNCTIONS(X) \
+    X(glDispatchCompute, GL43::DispatchComputeProc) \
+    X(glMemoryBarrier, GL43::MemoryBarrierProc) \
+    X(glMultiDrawElementsIndirect, GL43::MultiDrawElementsIndirectProc)
+
+#define GL43_FUNCTION_ID(name, type) GL43_ID_##name,
+enum GL43Function {
+    GL43_FUNCTIONS(GL43_FUNCTION_ID)
+    GL43_FUNCTION_COUNT
+};
+#undef GL43_FUNCTION_ID
+
+#define GL43_FUNCTION_NAME(name, type) #name,
+const char* const GL43_FUNCTION_NAMES[] = {
+    GL43_FUNCTIONS(GL43_FUNCTION_NAME)
+};
+#undef GL43_FUNCTION_NAME
+
+namespace GL43 {
+    extern DispatchComputeProc dispatchCompute;
+    extern MemoryBarrierProc memoryBarrier;
+    extern MultiDrawElementsIndirectProc multiDrawElementsIndirect;
+
+    // Load with the current context, false when it is older than 4.3 or an entry point is missing
+    extern bool load(LoadProc getProcAddress);
+    extern bool loaded();
+}
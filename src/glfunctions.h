@@ -0,0 +1,424 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+/**
+ * Every entry point glad.cpp loads, as X(name, pointer type). Layers that
+ * replace the glad function pointers (null backend, trace capture) expand
+ * this instead of spelling out the table themselves. GLFunction numbers the
+ * entry points in this order.
+ */
+
+#define GL_FUNCTIONS(X) \
+    X(glActiveTexture, PFNGLACTIVETEXTUREPROC) \
+    X(glAttachShader, PFNGLATTACHSHADERPROC) \
+    X(glBeginConditionalRender, PFNGLBEGINCONDITIONALRENDERPROC) \
+    X(glBeginQuery, PFNGLBEGINQUERYPROC) \
+    X(glBeginTransformFeedback, PFNGLBEGINTRANSFORMFEEDBACKPROC) \
+    X(glBindAttribLocation, PFNGLBINDATTRIBLOCATIONPROC) \
+    X(glBindBuffer, PFNGLBINDBUFFERPROC) \
+    X(glBindBufferBase, PFNGLBINDBUFFERBASEPROC) \
+    X(glBindBufferRange, PFNGLBINDBUFFERRANGEPROC) \
+    X(glBindFragDataLocation, PFNGLBINDFRAGDATALOCATIONPROC) \
+    X(glBindFragDataLocationIndexed, PFNGLBINDFRAGDATALOCATIONINDEXEDPROC) \
+    X(glBindFramebuffer, PFNGLBINDFRAMEBUFFERPROC) \
+    X(glBindRenderbuffer, PFNGLBINDRENDERBUFFERPROC) \
+    X(glBindSampler, PFNGLBINDSAMPLERPROC) \
+    X(glBindTexture, PFNGLBINDTEXTUREPROC) \
+    X(glBindVertexArray, PFNGLBINDVERTEXARRAYPROC) \
+    X(glBlendColor, PFNGLBLENDCOLORPROC) \
+    X(glBlendEquation, PFNGLBLENDEQUATIONPROC) \
+    X(glBlendEquationSeparate, PFNGLBLENDEQUATIONSEPARATEPROC) \
+    X(glBlendFunc, PFNGLBLENDFUNCPROC) \
+    X(glBlendFuncSeparate, PFNGLBLENDFUNCSEPARATEPROC) \
+    X(glBlitFramebuffer, PFNGLBLITFRAMEBUFFERPROC) \
+    X(glBufferData, PFNGLBUFFERDATAPROC) \
+    X(glBufferSubData, PFNGLBUFFERSUBDATAPROC) \
+    X(glCheckFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC) \
+    X(glClampColor, PFNGLCLAMPCOLORPROC) \
+    X(glClear, PFNGLCLEARPROC) \
+    X(glClearBufferfi, PFNGLCLEARBUFFERFIPROC) \
+    X(glClearBufferfv, PFNGLCLEARBUFFERFVPROC) \
+    X(glClearBufferiv, PFNGLCLEARBUFFERIVPROC) \
+    X(glClearBufferuiv, PFNGLCLEARBUFFERUIVPROC) \
+    X(glClearColor, PFNGLCLEARCOLORPROC) \
+    X(glClearDepth, PFNGLCLEARDEPTHPROC) \
+    X(glClearStencil, PFNGLCLEARSTENCILPROC) \
+    X(glClientWaitSync, PFNGLCLIENTWAITSYNCPROC) \
+    X(glColorMask, PFNGLCOLORMASKPROC) \
+    X(glColorMaski, PFNGLCOLORMASKIPROC) \
+    X(glColorP3ui, PFNGLCOLORP3UIPROC) \
+    X(glColorP3uiv, PFNGLCOLORP3UIVPROC) \
+    X(glColorP4ui, PFNGLCOLORP4UIPROC) \
+    X(glColorP4uiv, PFNGLCOLORP4UIVPROC) \
+    X(glCompileShader, PFNGLCOMPILESHADERPROC) \
+    X(glCompressedTexImage1D, PFNGLCOMPRESSEDTEXIMAGE1DPROC) \
+    X(glCompressedTexImage2D, PFNGLCOMPRESSEDTEXIMAGE2DPROC) \
+    X(glCompressedTexImage3D, PFNGLCOMPRESSEDTEXIMAGE3DPROC) \
+    X(glCompressedTexSubImage1D, PFNGLCOMPRESSEDTEXSUBIMAGE1DPROC) \
+    X(glCompressedTexSubImage2D, PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC) \
+    X(glCompressedTexSubImage3D, PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC) \
+    X(glCopyBufferSubData, PFNGLCOPYBUFFERSUBDATAPROC) \
+    X(glCopyTexImage1D, PFNGLCOPYTEXIMAGE1DPROC) \
+    X(glCopyTexImage2D, PFNGLCOPYTEXIMAGE2DPROC) \
+    X(glCopyTexSubImage1D, PFNGLCOPYTEXSUBIMAGE1DPROC) \
+    X(glCopyTexSubImage2D, PFNGLCOPYTEXSUBIMAGE2DPROC) \
+    X(glCopyTexSubImage3D, PFNGLCOPYTEXSUBIMAGE3DPROC) \
+    X(glCreateProgram, PFNGLCREATEPROGRAMPROC) \
+    X(glCreateShader, PFNGLCREATESHADERPROC) \
+    X(glCullFace, PFNGLCULLFACEPROC) \
+    X(glDeleteBuffers, PFNGLDELETEBUFFERSPROC) \
+    X(glDeleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC) \
+    X(glDeleteProgram, PFNGLDELETEPROGRAMPROC) \
+    X(glDeleteQueries, PFNGLDELETEQUERIESPROC) \
+    X(glDeleteRenderbuffers, PFNGLDELETERENDERBUFFERSPROC) \
+    X(glDeleteSamplers, PFNGLDELETESAMPLERSPROC) \
+    X(glDeleteShader, PFNGLDELETESHADERPROC) \
+    X(glDeleteSync, PFNGLDELETESYNCPROC) \
+    X(glDeleteTextures, PFNGLDELETETEXTURESPROC) \
+    X(glDeleteVertexArrays, PFNGLDELETEVERTEXARRAYSPROC) \
+    X(glDepthFunc, PFNGLDEPTHFUNCPROC) \
+    X(glDepthMask, PFNGLDEPTHMASKPROC) \
+    X(glDepthRange, PFNGLDEPTHRANGEPROC) \
+    X(glDetachShader, PFNGLDETACHSHADERPROC) \
+    X(glDisable, PFNGLDISABLEPROC) \
+    X(glDisableVertexAttribArray, PFNGLDISABLEVERTEXATTRIBARRAYPROC) \
+    X(glDisablei, PFNGLDISABLEIPROC) \
+    X(glDrawArrays, PFNGLDRAWARRAYSPROC) \
+    X(glDrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC) \
+    X(glDrawBuffer, PFNGLDRAWBUFFERPROC) \
+    X(glDrawBuffers, PFNGLDRAWBUFFERSPROC) \
+    X(glDrawElements, PFNGLDRAWELEMENTSPROC) \
+    X(glDrawElementsBaseVertex, PFNGLDRAWELEMENTSBASEVERTEXPROC) \
+    X(glDrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC) \
+    X(glDrawElementsInstancedBaseVertex, PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC) \
+    X(glDrawRangeElements, PFNGLDRAWRANGEELEMENTSPROC) \
+    X(glDrawRangeElementsBaseVertex, PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC) \
+    X(glEnable, PFNGLENABLEPROC) \
+    X(glEnableVertexAttribArray, PFNGLENABLEVERTEXATTRIBARRAYPROC) \
+    X(glEnablei, PFNGLENABLEIPROC) \
+    X(glEndConditionalRender, PFNGLENDCONDITIONALRENDERPROC) \
+    X(glEndQuery, PFNGLENDQUERYPROC) \
+    X(glEndTransformFeedback, PFNGLENDTRANSFORMFEEDBACKPROC) \
+    X(glFenceSync, PFNGLFENCESYNCPROC) \
+    X(glFinish, PFNGLFINISHPROC) \
+    X(glFlush, PFNGLFLUSHPROC) \
+    X(glFlushMappedBufferRange, PFNGLFLUSHMAPPEDBUFFERRANGEPROC) \
+    X(glFramebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFERPROC) \
+    X(glFramebufferTexture, PFNGLFRAMEBUFFERTEXTUREPROC) \
+    X(glFramebufferTexture1D, PFNGLFRAMEBUFFERTEXTURE1DPROC) \
+    X(glFramebufferTexture2D, PFNGLFRAMEBUFFERTEXTURE2DPROC) \
+    X(glFramebufferTexture3D, PFNGLFRAMEBUFFERTEXTURE3DPROC) \
+    X(glFramebufferTextureLayer, PFNGLFRAMEBUFFERTEXTURELAYERPROC) \
+    X(glFrontFace, PFNGLFRONTFACEPROC) \
+    X(glGenBuffers, PFNGLGENBUFFERSPROC) \
+    X(glGenFramebuffers, PFNGLGENFRAMEBUFFERSPROC) \
+    X(glGenQueries, PFNGLGENQUERIESPROC) \
+    X(glGenRenderbuffers, PFNGLGENRENDERBUFFERSPROC) \
+    X(glGenSamplers, PFNGLGENSAMPLERSPROC) \
+    X(glGenTextures, PFNGLGENTEXTURESPROC) \
+    X(glGenVertexArrays, PFNGLGENVERTEXARRAYSPROC) \
+    X(glGenerateMipmap, PFNGLGENERATEMIPMAPPROC) \
+    X(glGetActiveAttrib, PFNGLGETACTIVEATTRIBPROC) \
+    X(glGetActiveUniform, PFNGLGETACTIVEUNIFORMPROC) \
+    X(glGetActiveUniformBlockName, PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC) \
+    X(glGetActiveUniformBlockiv, PFNGLGETACTIVEUNIFORMBLOCKIVPROC) \
+    X(glGetActiveUniformName, PFNGLGETACTIVEUNIFORMNAMEPROC) \
+    X(glGetActiveUniformsiv, PFNGLGETACTIVEUNIFORMSIVPROC) \
+    X(glGetAttachedShaders, PFNGLGETATTACHEDSHADERSPROC) \
+    X(glGetAttribLocation, PFNGLGETATTRIBLOCATIONPROC) \
+    X(glGetBooleani_v, PFNGLGETBOOLEANI_VPROC) \
+    X(glGetBooleanv, PFNGLGETBOOLEANVPROC) \
+    X(glGetBufferParameteri64v, PFNGLGETBUFFERPARAMETERI64VPROC) \
+    X(glGetBufferParameteriv, PFNGLGETBUFFERPARAMETERIVPROC) \
+    X(glGetBufferPointerv, PFNGLGETBUFFERPOINTERVPROC) \
+    X(glGetBufferSubData, PFNGLGETBUFFERSUBDATAPROC) \
+    X(glGetCompressedTexImage, PFNGLGETCOMPRESSEDTEXIMAGEPROC) \
+    X(glGetDoublev, PFNGLGETDOUBLEVPROC) \
+    X(glGetError, PFNGLGETERRORPROC) \
+    X(glGetFloatv, PFNGLGETFLOATVPROC) \
+    X(glGetFragDataIndex, PFNGLGETFRAGDATAINDEXPROC) \
+    X(glGetFragDataLocation, PFNGLGETFRAGDATALOCATIONPROC) \
+    X(glGetFramebufferAttachmentParameteriv, PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC) \
+    X(glGetInteger64i_v, PFNGLGETINTEGER64I_VPROC) \
+    X(glGetInteger64v, PFNGLGETINTEGER64VPROC) \
+    X(glGetIntegeri_v, PFNGLGETINTEGERI_VPROC) \
+    X(glGetIntegerv, PFNGLGETINTEGERVPROC) \
+    X(glGetMultisamplefv, PFNGLGETMULTISAMPLEFVPROC) \
+    X(glGetProgramInfoLog, PFNGLGETPROGRAMINFOLOGPROC) \
+    X(glGetProgramiv, PFNGLGETPROGRAMIVPROC) \
+    X(glGetQueryObjecti64v, PFNGLGETQUERYOBJECTI64VPROC) \
+    X(glGetQueryObjectiv, PFNGLGETQUERYOBJECTIVPROC) \
+    X(glGetQueryObjectui64v, PFNGLGETQUERYOBJECTUI64VPROC) \
+    X(glGetQueryObjectuiv, PFNGLGETQUERYOBJECTUIVPROC) \
+    X(glGetQueryiv, PFNGLGETQUERYIVPROC) \
+    X(glGetRenderbufferParameteriv, PFNGLGETRENDERBUFFERPARAMETERIVPROC) \
+    X(glGetSamplerParameterIiv, PFNGLGETSAMPLERPARAMETERIIVPROC) \
+    X(glGetSamplerParameterIuiv, PFNGLGETSAMPLERPARAMETERIUIVPROC) \
+    X(glGetSamplerParameterfv, PFNGLGETSAMPLERPARAMETERFVPROC) \
+    X(glGetSamplerParameteriv, PFNGLGETSAMPLERPARAMETERIVPROC) \
+    X(glGetShaderInfoLog, PFNGLGETSHADERINFOLOGPROC) \
+    X(glGetShaderSource, PFNGLGETSHADERSOURCEPROC) \
+    X(glGetShaderiv, PFNGLGETSHADERIVPROC) \
+    X(glGetString, PFNGLGETSTRINGPROC) \
+    X(glGetStringi, PFNGLGETSTRINGIPROC) \
+    X(glGetSynciv, PFNGLGETSYNCIVPROC) \
+    X(glGetTexImage, PFNGLGETTEXIMAGEPROC) \
+    X(glGetTexLevelParameterfv, PFNGLGETTEXLEVELPARAMETERFVPROC) \
+    X(glGetTexLevelParameteriv, PFNGLGETTEXLEVELPARAMETERIVPROC) \
+    X(glGetTexParameterIiv, PFNGLGETTEXPARAMETERIIVPROC) \
+    X(glGetTexParameterIuiv, PFNGLGETTEXPARAMETERIUIVPROC) \
+    X(glGetTexParameterfv, PFNGLGETTEXPARAMETERFVPROC) \
+    X(glGetTexParameteriv, PFNGLGETTEXPARAMETERIVPROC) \
+    X(glGetTransformFeedbackVarying, PFNGLGETTRANSFORMFEEDBACKVARYINGPROC) \
+    X(glGetUniformBlockIndex, PFNGLGETUNIFORMBLOCKINDEXPROC) \
+    X(glGetUniformIndices, PFNGLGETUNIFORMINDICESPROC) \
+    X(glGetUniformLocation, PFNGLGETUNIFORMLOCATIONPROC) \
+    X(glGetUniformfv, PFNGLGETUNIFORMFVPROC) \
+    X(glGetUniformiv, PFNGLGETUNIFORMIVPROC) \
+    X(glGetUniformuiv, PFNGLGETUNIFORMUIVPROC) \
+    X(glGetVertexAttribIiv, PFNGLGETVERTEXATTRIBIIVPROC) \
+    X(glGetVertexAttribIuiv, PFNGLGETVERTEXATTRIBIUIVPROC) \
+    X(glGetVertexAttribPointerv, PFNGLGETVERTEXATTRIBPOINTERVPROC) \
+    X(glGetVertexAttribdv, PFNGLGETVERTEXATTRIBDVPROC) \
+    X(glGetVertexAttribfv, PFNGLGETVERTEXATTRIBFVPROC) \
+    X(glGetVertexAttribiv, PFNGLGETVERTEXATTRIBIVPROC) \
+    X(glHint, PFNGLHINTPROC) \
+    X(glIsBuffer, PFNGLISBUFFERPROC) \
+    X(glIsEnabled, PFNGLISENABLEDPROC) \
+    X(glIsEnabledi, PFNGLISENABLEDIPROC) \
+    X(glIsFramebuffer, PFNGLISFRAMEBUFFERPROC) \
+    X(glIsProgram, PFNGLISPROGRAMPROC) \
+    X(glIsQuery, PFNGLISQUERYPROC) \
+    X(glIsRenderbuffer, PFNGLISRENDERBUFFERPROC) \
+    X(glIsSampler, PFNGLISSAMPLERPROC) \
+    X(glIsShader, PFNGLISSHADERPROC) \
+    X(glIsSync, PFNGLISSYNCPROC) \
+    X(glIsTexture, PFNGLISTEXTUREPROC) \
+    X(glIsVertexArray, PFNGLISVERTEXARRAYPROC) \
+    X(glLineWidth, PFNGLLINEWIDTHPROC) \
+    X(glLinkProgram, PFNGLLINKPROGRAMPROC) \
+    X(glLogicOp, PFNGLLOGICOPPROC) \
+    X(glMapBuffer, PFNGLMAPBUFFERPROC) \
+    X(glMapBufferRange, PFNGLMAPBUFFERRANGEPROC) \
+    X(glMultiDrawArrays, PFNGLMULTIDRAWARRAYSPROC) \
+    X(glMultiDrawElements, PFNGLMULTIDRAWELEMENTSPROC) \
+    X(glMultiDrawElementsBaseVertex, PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC) \
+    X(glMultiTexCoordP1ui, PFNGLMULTITEXCOORDP1UIPROC) \
+    X(glMultiTexCoordP1uiv, PFNGLMULTITEXCOORDP1UIVPROC) \
+    X(glMultiTexCoordP2ui, PFNGLMULTITEXCOORDP2UIPROC) \
+    X(glMultiTexCoordP2uiv, PFNGLMULTITEXCOORDP2UIVPROC) \
+    X(glMultiTexCoordP3ui, PFNGLMULTITEXCOORDP3UIPROC) \
+    X(glMultiTexCoordP3uiv, PFNGLMULTITEXCOORDP3UIVPROC) \
+    X(glMultiTexCoordP4ui, PFNGLMULTITEXCOORDP4UIPROC) \
+    X(glMultiTexCoordP4uiv, PFNGLMULTITEXCOORDP4UIVPROC) \
+    X(glNormalP3ui, PFNGLNORMALP3UIPROC) \
+    X(glNormalP3uiv, PFNGLNORMALP3UIVPROC) \
+    X(glPixelStoref, PFNGLPIXELSTOREFPROC) \
+    X(glPixelStorei, PFNGLPIXELSTOREIPROC) \
+    X(glPointParameterf, PFNGLPOINTPARAMETERFPROC) \
+    X(glPointParameterfv, PFNGLPOINTPARAMETERFVPROC) \
+    X(glPointParameteri, PFNGLPOINTPARAMETERIPROC) \
+    X(glPointParameteriv, PFNGLPOINTPARAMETERIVPROC) \
+    X(glPointSize, PFNGLPOINTSIZEPROC) \
+    X(glPolygonMode, PFNGLPOLYGONMODEPROC) \
+    X(glPolygonOffset, PFNGLPOLYGONOFFSETPROC) \
+    X(glPrimitiveRestartIndex, PFNGLPRIMITIVERESTARTINDEXPROC) \
+    X(glProvokingVertex, PFNGLPROVOKINGVERTEXPROC) \
+    X(glQueryCounter, PFNGLQUERYCOUNTERPROC) \
+    X(glReadBuffer, PFNGLREADBUFFERPROC) \
+    X(glReadPixels, PFNGLREADPIXELSPROC) \
+    X(glRenderbufferStorage, PFNGLRENDERBUFFERSTORAGEPROC) \
+    X(glRenderbufferStorageMultisample, PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC) \
+    X(glSampleCoverage, PFNGLSAMPLECOVERAGEPROC) \
+    X(glSampleMaski, PFNGLSAMPLEMASKIPROC) \
+    X(glSamplerParameterIiv, PFNGLSAMPLERPARAMETERIIVPROC) \
+    X(glSamplerParameterIuiv, PFNGLSAMPLERPARAMETERIUIVPROC) \
+    X(glSamplerParameterf, PFNGLSAMPLERPARAMETERFPROC) \
+    X(glSamplerParameterfv, PFNGLSAMPLERPARAMETERFVPROC) \
+    X(glSamplerParameteri, PFNGLSAMPLERPARAMETERIPROC) \
+    X(glSamplerParameteriv, PFNGLSAMPLERPARAMETERIVPROC) \
+    X(glScissor, PFNGLSCISSORPROC) \
+    X(glSecondaryColorP3ui, PFNGLSECONDARYCOLORP3UIPROC) \
+    X(glSecondaryColorP3uiv, PFNGLSECONDARYCOLORP3UIVPROC) \
+    X(glShaderSource, PFNGLSHADERSOURCEPROC) \
+    X(glStencilFunc, PFNGLSTENCILFUNCPROC) \
+    X(glStencilFuncSeparate, PFNGLSTENCILFUNCSEPARATEPROC) \
+    X(glStencilMask, PFNGLSTENCILMASKPROC) \
+    X(glStencilMaskSeparate, PFNGLSTENCILMASKSEPARATEPROC) \
+    X(glStencilOp, PFNGLSTENCILOPPROC) \
+    X(glStencilOpSeparate, PFNGLSTENCILOPSEPARATEPROC) \
+    X(glTexBuffer, PFNGLTEXBUFFERPROC) \
+    X(glTexCoordP1ui, PFNGLTEXCOORDP1UIPROC) \
+    X(glTexCoordP1uiv, PFNGLTEXCOORDP1UIVPROC) \
+    X(glTexCoordP2ui, PFNGLTEXCOORDP2UIPROC) \
+    X(glTexCoordP2uiv, PFNGLTEXCOORDP2UIVPROC) \
+    X(glTexCoordP3ui, PFNGLTEXCOORDP3UIPROC) \
+    X(glTexCoordP3uiv, PFNGLTEXCOORDP3UIVPROC) \
+    X(glTexCoordP4ui, PFNGLTEXCOORDP4UIPROC) \
+    X(glTexCoordP4uiv, PFNGLTEXCOORDP4UIVPROC) \
+    X(glTexImage1D, PFNGLTEXIMAGE1DPROC) \
+    X(glTexImage2D, PFNGLTEXIMAGE2DPROC) \
+    X(glTexImage2DMultisample, PFNGLTEXIMAGE2DMULTISAMPLEPROC) \
+    X(glTexImage3D, PFNGLTEXIMAGE3DPROC) \
+    X(glTexImage3DMultisample, PFNGLTEXIMAGE3DMULTISAMPLEPROC) \
+    X(glTexParameterIiv, PFNGLTEXPARAMETERIIVPROC) \
+    X(glTexParameterIuiv, PFNGLTEXPARAMETERIUIVPROC) \
+    X(glTexParameterf, PFNGLTEXPARAMETERFPROC) \
+    X(glTexParameterfv, PFNGLTEXPARAMETERFVPROC) \
+    X(glTexParameteri, PFNGLTEXPARAMETERIPROC) \
+    X(glTexParameteriv, PFNGLTEXPARAMETERIVPROC) \
+    X(glTexSubImage1D, PFNGLTEXSUBIMAGE1DPROC) \
+    X(glTexSubImage2D, PFNGLTEXSUBIMAGE2DPROC) \
+    X(glTexSubImage3D, PFNGLTEXSUBIMAGE3DPROC) \
+    X(glTransformFeedbackVaryings, PFNGLTRANSFORMFEEDBACKVARYINGSPROC) \
+    X(glUniform1f, PFNGLUNIFORM1FPROC) \
+    X(glUniform1fv, PFNGLUNIFORM1FVPROC) \
+    X(glUniform1i, PFNGLUNIFORM1IPROC) \
+    X(glUniform1iv, PFNGLUNIFORM1IVPROC) \
+    X(glUniform1ui, PFNGLUNIFORM1UIPROC) \
+    X(glUniform1uiv, PFNGLUNIFORM1UIVPROC) \
+    X(glUniform2f, PFNGLUNIFORM2FPROC) \
+    X(glUniform2fv, PFNGLUNIFORM2FVPROC) \
+    X(glUniform2i, PFNGLUNIFORM2IPROC) \
+    X(glUniform2iv, PFNGLUNIFORM2IVPROC) \
+    X(glUniform2ui, PFNGLUNIFORM2UIPROC) \
+    X(glUniform2uiv, PFNGLUNIFORM2UIVPROC) \
+    X(glUniform3f, PFNGLUNIFORM3FPROC) \
+    X(glUniform3fv, PFNGLUNIFORM3FVPROC) \
+    X(glUniform3i, PFNGLUNIFORM3IPROC) \
+    X(glUniform3iv, PFNGLUNIFORM3IVPROC) \
+    X(glUniform3ui, PFNGLUNIFORM3UIPROC) \
+    X(glUniform3uiv, PFNGLUNIFORM3UIVPROC) \
+    X(glUniform4f, PFNGLUNIFORM4FPROC) \
+    X(glUniform4fv, PFNGLUNIFORM4FVPROC) \
+    X(glUniform4i, PFNGLUNIFORM4IPROC) \
+    X(glUniform4iv, PFNGLUNIFORM4IVPROC) \
+    X(glUniform4ui, PFNGLUNIFORM4UIPROC) \
+    X(glUniform4uiv, PFNGLUNIFORM4UIVPROC) \
+    X(glUniformBlockBinding, PFNGLUNIFORMBLOCKBINDINGPROC) \
+    X(glUniformMatrix2fv, PFNGLUNIFORMMATRIX2FVPROC) \
+    X(glUniformMatrix2x3fv, PFNGLUNIFORMMATRIX2X3FVPROC) \
+    X(glUniformMatrix2x4fv, PFNGLUNIFORMMATRIX2X4FVPROC) \
+    X(glUniformMatrix3fv, PFNGLUNIFORMMATRIX3FVPROC) \
+    X(glUniformMatrix3x2fv, PFNGLUNIFORMMATRIX3X2FVPROC) \
+    X(glUniformMatrix3x4fv, PFNGLUNIFORMMATRIX3X4FVPROC) \
+    X(glUniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC) \
+    X(glUniformMatrix4x2fv, PFNGLUNIFORMMATRIX4X2FVPROC) \
+    X(glUniformMatrix4x3fv, PFNGLUNIFORMMATRIX4X3FVPROC) \
+    X(glUnmapBuffer, PFNGLUNMAPBUFFERPROC) \
+    X(glUseProgram, PFNGLUSEPROGRAMPROC) \
+    X(glValidateProgram, PFNGLVALIDATEPROGRAMPROC) \
+    X(glVertexAttrib1d, PFNGLVERTEXATTRIB1DPROC) \
+    X(glVertexAttrib1dv, PFNGLVERTEXATTRIB1DVPROC) \
+    X(glVertexAttrib1f, PFNGLVERTEXATTRIB1FPROC) \
+    X(glVertexAttrib1fv, PFNGLVERTEXATTRIB1FVPROC) \
+    X(glVertexAttrib1s, PFNGLVERTEXATTRIB1SPROC) \
+    X(glVertexAttrib1sv, PFNGLVERTEXATTRIB1SVPROC) \
+    X(glVertexAttrib2d, PFNGLVERTEXATTRIB2DPROC) \
+    X(glVertexAttrib2dv, PFNGLVERTEXATTRIB2DVPROC) \
+    X(glVertexAttrib2f, PFNGLVERTEXATTRIB2FPROC) \
+    X(glVertexAttrib2fv, PFNGLVERTEXATTRIB2FVPROC) \
+    X(glVertexAttrib2s, PFNGLVERTEXATTRIB2SPROC) \
+    X(glVertexAttrib2sv, PFNGLVERTEXATTRIB2SVPROC) \
+    X(glVertexAttrib3d, PFNGLVERTEXATTRIB3DPROC) \
+    X(glVertexAttrib3dv, PFNGLVERTEXATTRIB3DVPROC) \
+    X(glVertexAttrib3f, PFNGLVERTEXATTRIB3FPROC) \
+    X(glVertexAttrib3fv, PFNGLVERTEXATTRIB3FVPROC) \
+    X(glVertexAttrib3s, PFNGLVERTEXATTRIB3SPROC) \
+    X(glVertexAttrib3sv, PFNGLVERTEXATTRIB3SVPROC) \
+    X(glVertexAttrib4Nbv, PFNGLVERTEXATTRIB4NBVPROC) \
+    X(glVertexAttrib4Niv, PFNGLVERTEXATTRIB4NIVPROC) \
+    X(glVertexAttrib4Nsv, PFNGLVERTEXATTRIB4NSVPROC) \
+    X(glVertexAttrib4Nub, PFNGLVERTEXATTRIB4NUBPROC) \
+    X(glVertexAttrib4Nubv, PFNGLVERTEXATTRIB4NUBVPROC) \
+    X(glVertexAttrib4Nuiv, PFNGLVERTEXATTRIB4NUIVPROC) \
+    X(glVertexAttrib4Nusv, PFNGLVERTEXATTRIB4NUSVPROC) \
+    X(glVertexAttrib4bv, PFNGLVERTEXATTRIB4BVPROC) \
+    X(glVertexAttrib4d, PFNGLVERTEXATTRIB4DPROC) \
+    X(glVertexAttrib4dv, PFNGLVERTEXATTRIB4DVPROC) \
+    X(glVertexAttrib4f, PFNGLVERTEXATTRIB4FPROC) \
+    X(glVertexAttrib4fv, PFNGLVERTEXATTRIB4FVPROC) \
+    X(glVertexAttrib4iv, PFNGLVERTEXATTRIB4IVPROC) \
+    X(glVertexAttrib4s, PFNGLVERTEXATTRIB4SPROC) \
+    X(glVertexAttrib4sv, PFNGLVERTEXATTRIB4SVPROC) \
+    X(glVertexAttrib4ubv, PFNGLVERTEXATTRIB4UBVPROC) \
+    X(glVertexAttrib4uiv, PFNGLVERTEXATTRIB4UIVPROC) \
+    X(glVertexAttrib4usv, PFNGLVERTEXATTRIB4USVPROC) \
+    X(glVertexAttribDivisor, PFNGLVERTEXATTRIBDIVISORPROC) \
+    X(glVertexAttribI1i, PFNGLVERTEXATTRIBI1IPROC) \
+    X(glVertexAttribI1iv, PFNGLVERTEXATTRIBI1IVPROC) \
+    X(glVertexAttribI1ui, PFNGLVERTEXATTRIBI1UIPROC) \
+    X(glVertexAttribI1uiv, PFNGLVERTEXATTRIBI1UIVPROC) \
+    X(glVertexAttribI2i, PFNGLVERTEXATTRIBI2IPROC) \
+    X(glVertexAttribI2iv, PFNGLVERTEXATTRIBI2IVPROC) \
+    X(glVertexAttribI2ui, PFNGLVERTEXATTRIBI2UIPROC) \
+    X(glVertexAttribI2uiv, PFNGLVERTEXATTRIBI2UIVPROC) \
+    X(glVertexAttribI3i, PFNGLVERTEXATTRIBI3IPROC) \
+    X(glVertexAttribI3iv, PFNGLVERTEXATTRIBI3IVPROC) \
+    X(glVertexAttribI3ui, PFNGLVERTEXATTRIBI3UIPROC) \
+    X(glVertexAttribI3uiv, PFNGLVERTEXATTRIBI3UIVPROC) \
+    X(glVertexAttribI4bv, PFNGLVERTEXATTRIBI4BVPROC) \
+    X(glVertexAttribI4i, PFNGLVERTEXATTRIBI4IPROC) \
+    X(glVertexAttribI4iv, PFNGLVERTEXATTRIBI4IVPROC) \
+    X(glVertexAttribI4sv, PFNGLVERTEXATTRIBI4SVPROC) \
+    X(glVertexAttribI4ubv, PFNGLVERTEXATTRIBI4UBVPROC) \
+    X(glVertexAttribI4ui, PFNGLVERTEXATTRIBI4UIPROC) \
+    X(glVertexAttribI4uiv, PFNGLVERTEXATTRIBI4UIVPROC) \
+    X(glVertexAttribI4usv, PFNGLVERTEXATTRIBI4USVPROC) \
+    X(glVertexAttribIPointer, PFNGLVERTEXATTRIBIPOINTERPROC) \
+    X(glVertexAttribP1ui, PFNGLVERTEXATTRIBP1UIPROC) \
+    X(glVertexAttribP1uiv, PFNGLVERTEXATTRIBP1UIVPROC) \
+    X(glVertexAttribP2ui, PFNGLVERTEXATTRIBP2UIPROC) \
+    X(glVertexAttribP2uiv, PFNGLVERTEXATTRIBP2UIVPROC) \
+    X(glVertexAttribP3ui, PFNGLVERTEXATTRIBP3UIPROC) \
+    X(glVertexAttribP3uiv, PFNGLVERTEXATTRIBP3UIVPROC) \
+    X(glVertexAttribP4ui, PFNGLVERTEXATTRIBP4UIPROC) \
+    X(glVertexAttribP4uiv, PFNGLVERTEXATTRIBP4UIVPROC) \
+    X(glVertexAttribPointer, PFNGLVERTEXATTRIBPOINTERPROC) \
+    X(glVertexP2ui, PFNGLVERTEXP2UIPROC) \
+    X(glVertexP2uiv, PFNGLVERTEXP2UIVPROC) \
+    X(glVertexP3ui, PFNGLVERTEXP3UIPROC) \
+    X(glVertexP3uiv, PFNGLVERTEXP3UIVPROC) \
+    X(glVertexP4ui, PFNGLVERTEXP4UIPROC) \
+    X(glVertexP4uiv, PFNGLVERTEXP4UIVPROC) \
+    X(glViewport, PFNGLVIEWPORTPROC) \
+    X(glWaitSync, PFNGLWAITSYNCPROC)
+
+#define GL_FUNCTION_ID(name, type) GL_ID_##name,
+enum GLFunction {
+    GL_FUNCTIONS(GL_FUNCTION_ID)
+    GL_FUNCTION_COUNT
+};
+#undef GL_FUNCTION_ID
+
+#define GL_FUNCTION_NAME(name, type) #name,
+const char* const GL_FUNCTION_NAMES[] = {
+    GL_FUNCTIONS(GL_FUNCTION_NAME)
+};
+#undef GL_FUNCTION_NAME
+
+// Bytes per pixel of client pixel data in format and type
+inline std::uint64_t glPixelSize(GLenum format, GLenum type) {
+    std::uint64_t components = 4;
+    switch (format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX:
+            components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL:
+            components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER:
+            components = 3; break;
+    }
+    switch (type) {
+        case GL_UNSIGNED_BYTE: case GL_BYTE:
+            return components;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT:
+            return components * 2;
+        case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_2_10_10_10_REV: case GL_UNSIGNED_INT_10F_11F_11F_REV:
+            return 4;
+        default:
+            return components * 4;
+    }
+}
@@ -0,0 +1,298 @@
+#include "./glstate.h"
+
+#include <unordered_map>
+
+namespace {
+    // Marks a shadow value we know nothing about
+    const GLuint UNKNOWN = ~0u;
+
+    const int MAX_UNITS = 32;
+
+    // Texture targets we shadow per unit
+    const GLenum TEXTURE_TARGETS[] = {
+        GL_TEXTURE_2D,
+        GL_TEXTURE_3D,
+        GL_TEXTURE_CUBE_MAP,
+        GL_TEXTURE_2D_ARRAY,
+        GL_TEXTURE_2D_MULTISAMPLE,
+        GL_TEXTURE_BUFFER
+    };
+    const int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+    // Buffer targets we shadow. The element array binding is VAO state so it is forgotten on VAO changes
+    const GLenum BUFFER_TARGETS[] = {
+        GL_ARRAY_BUFFER,
+        GL_ELEMENT_ARRAY_BUFFER,
+        GL_UNIFORM_BUFFER,
+        GL_TEXTURE_BUFFER,
+        GL_PIXEL_PACK_BUFFER,
+        GL_PIXEL_UNPACK_BUFFER,
+        GL_COPY_READ_BUFFER,
+        GL_COPY_WRITE_BUFFER
+    };
+    const int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+
+    // Capabilities we shadow for glEnable/glDisable
+    const GLenum CAPS[] = {
+        GL_DEPTH_TEST,
+        GL_BLEND,
+        GL_CULL_FACE,
+        GL_STENCIL_TEST,
+        GL_SCISSOR_TEST,
+        GL_POLYGON_OFFSET_FILL,
+        GL_DEPTH_CLAMP,
+        GL_FRAMEBUFFER_SRGB,
+        GL_MULTISAMPLE
+    };
+    const int CAP_COUNT = sizeof(CAPS) / sizeof(CAPS[0]);
+
+    struct State {
+        GLuint program;
+        GLuint vao;
+        GLuint buffers[BUFFER_TARGET_COUNT];
+        GLenum activeUnit;
+        GLuint textures[MAX_UNITS][TEXTURE_TARGET_COUNT];
+        int caps[CAP_COUNT];     // -1 unknown, 0 disabled, 1 enabled
+        GLenum depthFunc;
+        int depthMask;           // -1 unknown
+        GLenum blendSrc, blendDst;
+        GLint viewport[4];
+        bool viewportKnown;
+        // Per texture object parameters: texture -> (pname -> value)
+        std::unordered_map<GLuint, std::unordered_map<GLenum, GLint>> texParams;
+    };
+
+    State state;
+    bool initialised = false;
+
+    int textureTargetIndex(GLenum target) {
+        for (int i = 0; i < TEXTURE_TARGET_COUNT; i++) {
+            if (TEXTURE_TARGETS[i] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int bufferTargetIndex(GLenum target) {
+        for (int i = 0; i < BUFFER_TARGET_COUNT; i++) {
+            if (BUFFER_TARGETS[i] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int capIndex(GLenum cap) {
+        for (int i = 0; i < CAP_COUNT; i++) {
+            if (CAPS[i] == cap) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void reset() {
+        state.program = UNKNOWN;
+        state.vao = UNKNOWN;
+        for (int i = 0; i < BUFFER_TARGET_COUNT; i++) {
+            state.buffers[i] = UNKNOWN;
+        }
+        state.activeUnit = UNKNOWN;
+        for (int u = 0; u < MAX_UNITS; u++) {
+            for (int t = 0; t < TEXTURE_TARGET_COUNT; t++) {
+                state.textures[u][t] = UNKNOWN;
+            }
+        }
+        for (int i = 0; i < CAP_COUNT; i++) {
+            state.caps[i] = -1;
+        }
+        state.depthFunc = UNKNOWN;
+        state.depthMask = -1;
+        state.blendSrc = state.blendDst = UNKNOWN;
+        state.viewportKnown = false;
+        state.texParams.clear();
+        initialised = true;
+    }
+
+    // Returns true when the call has to go to GL, and counts it either way
+    bool changed(bool differs) {
+        if (!initialised) {
+            reset();
+            differs = true;
+        }
+        if (differs) {
+            GLState::issuedCalls++;
+        } else {
+            GLState::skippedCalls++;
+        }
+        return differs;
+    }
+
+    // Texture currently bound to target on the active unit, UNKNOWN if we can't tell
+    GLuint boundTexture(GLenum target) {
+        int t = textureTargetIndex(target);
+        unsigned int unit = state.activeUnit - GL_TEXTURE0;
+        if (t < 0 || state.activeUnit == UNKNOWN || unit >= MAX_UNITS) {
+            return UNKNOWN;
+        }
+        return state.textures[unit][t];
+    }
+}
+
+unsigned long GLState::issuedCalls = 0;
+unsigned long GLState::skippedCalls = 0;
+
+void GLState::useProgram(GLuint program) {
+    if (changed(state.program != program)) {
+        glUseProgram(program);
+        state.program = program;
+    }
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (changed(state.vao != vao)) {
+        glBindVertexArray(vao);
+        state.vao = vao;
+        // The element array binding belongs to the VAO we just switched to
+        state.buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    int i = bufferTargetIndex(target);
+    if (changed(i < 0 || state.buffers[i] != buffer)) {
+        glBindBuffer(target, buffer);
+        if (i >= 0) {
+            state.buffers[i] = buffer;
+        }
+    }
+}
+
+void GLState::activeTexture(GLenum unit) {
+    if (changed(state.activeUnit != unit)) {
+        glActiveTexture(unit);
+        state.activeUnit = unit;
+    }
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    GLuint bound = boundTexture(target);
+    if (changed(bound == UNKNOWN || bound != texture)) {
+        glBindTexture(target, texture);
+        int t = textureTargetIndex(target);
+        unsigned int unit = state.activeUnit - GL_TEXTURE0;
+        if (t >= 0 && state.activeUnit != UNKNOWN && unit < MAX_UNITS) {
+            state.textures[unit][t] = texture;
+        }
+    }
+}
+
+void GLState::texParameteri(GLenum target, GLenum pname, GLint value) {
+    GLuint texture = boundTexture(target);
+    if (texture == UNKNOWN) {
+        changed(true);
+        glTexParameteri(target, pname, value);
+        return;
+    }
+
+    auto &params = state.texParams[texture];
+    auto it = params.find(pname);
+    if (changed(it == params.end() || it->second != value)) {
+        glTexParameteri(target, pname, value);
+        params[pname] = value;
+    }
+}
+
+void GLState::enable(GLenum cap) {
+    int i = capIndex(cap);
+    if (changed(i < 0 || state.caps[i] != 1)) {
+        glEnable(cap);
+        if (i >= 0) {
+            state.caps[i] = 1;
+        }
+    }
+}
+
+void GLState::disable(GLenum cap) {
+    int i = capIndex(cap);
+    if (changed(i < 0 || state.caps[i] != 0)) {
+        glDisable(cap);
+        if (i >= 0) {
+            state.caps[i] = 0;
+        }
+    }
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (changed(state.depthFunc != func)) {
+        glDepthFunc(func);
+        state.depthFunc = func;
+    }
+}
+
+void GLState::depthMask(GLboolean flag) {
+    if (changed(state.depthMask != (int)flag)) {
+        glDepthMask(flag);
+        state.depthMask = flag;
+    }
+}
+
+void GLState::blendFunc(GLenum sfactor, GLenum dfactor) {
+    if (changed(state.blendSrc != sfactor || state.blendDst != dfactor)) {
+        glBlendFunc(sfactor, dfactor);
+        state.blendSrc = sfactor;
+        state.blendDst = dfactor;
+    }
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const GLint *v = state.viewport;
+    if (changed(!state.viewportKnown || v[0] != x || v[1] != y || v[2] != width || v[3] != height)) {
+        glViewport(x, y, width, height);
+        state.viewport[0] = x;
+        state.viewport[1] = y;
+        state.viewport[2] = width;
+        state.viewport[3] = height;
+        state.viewportKnown = true;
+    }
+}
+
+void GLState::deleteProgram(GLuint program) {
+    glDeleteProgram(program);
+    if (state.program == program) {
+        state.program = UNKNOWN;
+    }
+}
+
+void GLState::deleteVertexArray(GLuint vao) {
+    glDeleteVertexArrays(1, &vao);
+    if (state.vao == vao) {
+        state.vao = 0;
+    }
+}
+
+void GLState::deleteBuffer(GLuint buffer) {
+    glDeleteBuffers(1, &buffer);
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++) {
+        if (state.buffers[i] == buffer) {
+            state.buffers[i] = 0;
+        }
+    }
+}
+
+void GLState::deleteTexture(GLuint texture) {
+    glDeleteTextures(1, &texture);
+    for (int u = 0; u < MAX_UNITS; u++) {
+        for (int t = 0; t < TEXTURE_TARGET_COUNT; t++) {
+            if (state.textures[u][t] == texture) {
+                state.textures[u][t] = 0;
+            }
+        }
+    }
+    state.texParams.erase(texture);
+}
+
+void GLState::invalidate() {
+    reset();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+ * Shadow copy of the GL state we touch, so calls that would not change
+ * anything never reach the driver. All binds in the engine should go
+ * through here, otherwise the shadow goes stale (call invalidate() if
+ * something else touched the context).
+ */
+
+namespace GLState {
+    // Programs, vertex arrays and buffers
+    extern void useProgram(GLuint program);
+    extern void bindVertexArray(GLuint vao);
+    extern void bindBuffer(GLenum target, GLuint buffer);
+
+    // Textures: bindTexture binds to the currently active unit like glBindTexture does
+    extern void activeTexture(GLenum unit);
+    extern void bindTexture(GLenum target, GLuint texture);
+    extern void texParameteri(GLenum target, GLenum pname, GLint value);
+
+    // Fixed function state
+    extern void enable(GLenum cap);
+    extern void disable(GLenum cap);
+    extern void depthFunc(GLenum func);
+    extern void depthMask(GLboolean flag);
+    extern void blendFunc(GLenum sfactor, GLenum dfactor);
+    extern void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Object deletion, so a recycled name is not mistaken for a bound one
+    extern void deleteProgram(GLuint program);
+    extern void deleteVertexArray(GLuint vao);
+    extern void deleteBuffer(GLuint buffer);
+    extern void deleteTexture(GLuint texture);
+
+    // Forget everything we know, the next call of every kind goes to GL
+    extern void invalidate();
+
+    // Call counters, useful when profiling
+    extern unsigned long issuedCalls;   // Calls forwarded to GL
+    extern unsigned long skippedCalls;  // Calls dropped because nothing changed
+}
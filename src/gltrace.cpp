@@ -0,0 +1,1084 @@
+#include "./gltrace.h"
+#include "./glfunctions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+    const char MAGIC[8] = {'G', 'L', 'T', 'R', 'A', 'C', 'E', '1'};
+
+    // Records that aren't calls use tags above the function ids
+    const std::uint16_t TAG_BLOB = 0xFFFF;          // u32 index, u64 size, bytes
+    const std::uint16_t TAG_FRAME = 0xFFFE;
+    const std::uint16_t TAG_MAPPED_WRITE = 0xFFFD;  // u32 target, u32 blob: what was written to a mapping before unmap
+
+    // How a pointer argument is stored
+    enum PointerKind : std::uint8_t {
+        RAW,            // u64 value, null or an offset into a bound buffer
+        BLOB,           // u32 blob index
+        OUTPUT,         // u32 size, GL writes there
+        STRINGS,        // u32 count, count blob indices
+        GEN_NAMES,      // u32 count, count names GL returned
+        NAME_ARRAY      // u32 count, count names passed in
+    };
+
+    // Object name spaces that get remapped on replay
+    enum Namespace {
+        NONE = -1,
+        BUFFER,
+        TEXTURE,
+        VERTEX_ARRAY,
+        FRAMEBUFFER,
+        RENDERBUFFER,
+        QUERY,
+        SAMPLER,
+        PROGRAM,        // Shaders and programs share names
+        NAMESPACE_COUNT
+    };
+
+    struct NameArgument {
+        GLFunction function;
+        int index;
+        Namespace space;
+    };
+
+    // Arguments that hold object names
+    const NameArgument NAME_ARGUMENTS[] = {
+        {GL_ID_glBindBuffer, 1, BUFFER},
+        {GL_ID_glBindBufferBase, 2, BUFFER},
+        {GL_ID_glBindBufferRange, 2, BUFFER},
+        {GL_ID_glIsBuffer, 0, BUFFER},
+        {GL_ID_glBindTexture, 1, TEXTURE},
+        {GL_ID_glFramebufferTexture, 2, TEXTURE},
+        {GL_ID_glFramebufferTexture1D, 3, TEXTURE},
+        {GL_ID_glFramebufferTexture2D, 3, TEXTURE},
+        {GL_ID_glFramebufferTexture3D, 3, TEXTURE},
+        {GL_ID_glFramebufferTextureLayer, 2, TEXTURE},
+        {GL_ID_glIsTexture, 0, TEXTURE},
+        {GL_ID_glBindVertexArray, 0, VERTEX_ARRAY},
+        {GL_ID_glIsVertexArray, 0, VERTEX_ARRAY},
+        {GL_ID_glBindFramebuffer, 1, FRAMEBUFFER},
+        {GL_ID_glIsFramebuffer, 0, FRAMEBUFFER},
+        {GL_ID_glBindRenderbuffer, 1, RENDERBUFFER},
+        {GL_ID_glFramebufferRenderbuffer, 3, RENDERBUFFER},
+        {GL_ID_glIsRenderbuffer, 0, RENDERBUFFER},
+        {GL_ID_glBeginQuery, 1, QUERY},
+        {GL_ID_glQueryCounter, 0, QUERY},
+        {GL_ID_glGetQueryObjectiv, 0, QUERY},
+        {GL_ID_glGetQueryObjectuiv, 0, QUERY},
+        {GL_ID_glGetQueryObjecti64v, 0, QUERY},
+        {GL_ID_glGetQueryObjectui64v, 0, QUERY},
+        {GL_ID_glBeginConditionalRender, 0, QUERY},
+        {GL_ID_glBindSampler, 1, SAMPLER},
+        {GL_ID_glSamplerParameteri, 0, SAMPLER},
+        {GL_ID_glSamplerParameterf, 0, SAMPLER},
+        {GL_ID_glUseProgram, 0, PROGRAM},
+        {GL_ID_glAttachShader, 0, PROGRAM},
+        {GL_ID_glAttachShader, 1, PROGRAM},
+        {GL_ID_glDetachShader, 0, PROGRAM},
+        {GL_ID_glDetachShader, 1, PROGRAM},
+        {GL_ID_glShaderSource, 0, PROGRAM},
+        {GL_ID_glCompileShader, 0, PROGRAM},
+        {GL_ID_glLinkProgram, 0, PROGRAM},
+        {GL_ID_glValidateProgram, 0, PROGRAM},
+        {GL_ID_glDeleteShader, 0, PROGRAM},
+        {GL_ID_glDeleteProgram, 0, PROGRAM},
+        {GL_ID_glGetShaderiv, 0, PROGRAM},
+        {GL_ID_glGetProgramiv, 0, PROGRAM},
+        {GL_ID_glGetShaderInfoLog, 0, PROGRAM},
+        {GL_ID_glGetProgramInfoLog, 0, PROGRAM},
+        {GL_ID_glGetUniformLocation, 0, PROGRAM},
+        {GL_ID_glGetAttribLocation, 0, PROGRAM},
+        {GL_ID_glBindAttribLocation, 0, PROGRAM},
+        {GL_ID_glBindFragDataLocation, 0, PROGRAM},
+        {GL_ID_glGetUniformBlockIndex, 0, PROGRAM},
+        {GL_ID_glUniformBlockBinding, 0, PROGRAM},
+        {GL_ID_glIsProgram, 0, PROGRAM},
+        {GL_ID_glIsShader, 0, PROGRAM}
+    };
+
+    // Entry points that create or delete arrays of names
+    struct NameArray {
+        GLFunction function;
+        Namespace space;
+    };
+
+    const NameArray GENERATE[] = {
+        {GL_ID_glGenBuffers, BUFFER},
+        {GL_ID_glGenTextures, TEXTURE},
+        {GL_ID_glGenVertexArrays, VERTEX_ARRAY},
+        {GL_ID_glGenFramebuffers, FRAMEBUFFER},
+        {GL_ID_glGenRenderbuffers, RENDERBUFFER},
+        {GL_ID_glGenQueries, QUERY},
+        {GL_ID_glGenSamplers, SAMPLER}
+    };
+
+    const NameArray DELETE[] = {
+        {GL_ID_glDeleteBuffers, BUFFER},
+        {GL_ID_glDeleteTextures, TEXTURE},
+        {GL_ID_glDeleteVertexArrays, VERTEX_ARRAY},
+        {GL_ID_glDeleteFramebuffers, FRAMEBUFFER},
+        {GL_ID_glDeleteRenderbuffers, RENDERBUFFER},
+        {GL_ID_glDeleteQueries, QUERY},
+        {GL_ID_glDeleteSamplers, SAMPLER}
+    };
+
+    // Pointer arguments that are offsets into a bound buffer rather than client memory
+    const GLFunction OFFSET_POINTERS[] = {
+        GL_ID_glVertexAttribPointer,
+        GL_ID_glVertexAttribIPointer,
+        GL_ID_glDrawElements,
+        GL_ID_glDrawElementsInstanced,
+        GL_ID_glDrawRangeElements,
+        GL_ID_glDrawElementsBaseVertex,
+        GL_ID_glDrawRangeElementsBaseVertex,
+        GL_ID_glDrawElementsInstancedBaseVertex
+    };
+
+    Namespace arrayNamespace(const NameArray *table, std::size_t count, GLFunction function) {
+        for (std::size_t i = 0; i < count; i++) {
+            if (table[i].function == function) {
+                return table[i].space;
+            }
+        }
+        return NONE;
+    }
+
+    // Location arguments of glUniform* that are looked up per program on replay
+    bool isUniformSetter(GLFunction function) {
+        const char *name = GL_FUNCTION_NAMES[function];
+        return std::strncmp(name, "glUniform", 9) == 0 && function != GL_ID_glUniformBlockBinding;
+    }
+
+    template<typename T>
+    void append(std::vector<char> &out, const T &value) {
+        const char *bytes = reinterpret_cast<const char*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // ---- Capture ----
+
+    void *real[GL_FUNCTION_COUNT];
+    bool active = false;
+    int framesLeft = 0;
+
+    std::ofstream file;
+    std::vector<char> stream;       // Encoded records waiting to be written
+    std::vector<char> call;         // The call being encoded, blobs it uses go to stream first
+    std::unordered_multimap<std::uint64_t, std::uint32_t> blobs;   // Content hash -> indices, equal hashes aren't equal content
+    std::vector<char> blobData;     // Every blob's bytes so far, to compare against
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> blobRanges;  // Index -> offset and size in blobData
+    std::uint32_t blobCount = 0;
+    bool warned[GL_FUNCTION_COUNT];
+
+    // Pixel store and buffer bindings the payload sizes depend on
+    GLint unpackRowLength = 0, unpackAlignment = 4, packRowLength = 0, packAlignment = 4;
+    GLuint packBuffer = 0, unpackBuffer = 0;
+
+    struct Mapping {
+        void *pointer;
+        GLsizeiptr length;
+        GLbitfield access;
+    };
+    std::unordered_map<GLenum, Mapping> mappings;
+
+    template<typename F>
+    F realFunction(GLFunction function) {
+        return reinterpret_cast<F>(real[function]);
+    }
+
+    void flush(bool force) {
+        if (force || stream.size() > (1 << 20)) {
+            file.write(stream.data(), stream.size());
+            stream.clear();
+        }
+    }
+
+    // FNV-1a, mixed with the size so equal prefixes of different lengths don't collide
+    std::uint64_t hash(const void *data, std::uint64_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        std::uint64_t h = 14695981039346656037ull ^ size;
+        for (std::uint64_t i = 0; i < size; i++) {
+            h = (h ^ bytes[i]) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Store data once, later calls with the same content reuse the index
+    std::uint32_t blob(const void *data, std::uint64_t size) {
+        std::uint64_t key = hash(data, size);
+        auto candidates = blobs.equal_range(key);
+        for (auto it = candidates.first; it != candidates.second; ++it) {
+            const std::pair<std::uint64_t, std::uint64_t> &range = blobRanges[it->second];
+            if (range.second == size && std::memcmp(blobData.data() + range.first, data, size) == 0) {
+                return it->second;
+            }
+        }
+
+        std::uint32_t index = blobCount++;
+        blobs.emplace(key, index);
+        const char *bytes = static_cast<const char*>(data);
+        blobRanges.emplace_back(blobData.size(), size);
+        blobData.insert(blobData.end(), bytes, bytes + size);
+        append(stream, TAG_BLOB);
+        append(stream, index);
+        append(stream, size);
+        stream.insert(stream.end(), bytes, bytes + size);
+        return index;
+    }
+
+    void putBlob(const void *data, std::uint64_t size) {
+        if (!data) {
+            append(call, (std::uint8_t)RAW);
+            append(call, (std::uint64_t)0);
+            return;
+        }
+        std::uint32_t index = blob(data, size);
+        append(call, (std::uint8_t)BLOB);
+        append(call, index);
+    }
+
+    void putRaw(const void *pointer) {
+        append(call, (std::uint8_t)RAW);
+        append(call, (std::uint64_t)reinterpret_cast<std::uintptr_t>(pointer));
+    }
+
+    void putOutput(std::uint64_t size) {
+        append(call, (std::uint8_t)OUTPUT);
+        append(call, (std::uint32_t)size);
+    }
+
+    void putNames(PointerKind kind, GLsizei n, const GLuint *names) {
+        append(call, (std::uint8_t)kind);
+        append(call, (std::uint32_t)n);
+        for (GLsizei i = 0; i < n; i++) {
+            append(call, (std::uint32_t)names[i]);
+        }
+    }
+
+    // Arguments by type
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type encode(GLFunction, T value) {
+        append(call, value);
+    }
+
+    void encode(GLFunction, GLsync sync) {
+        append(call, (std::uint64_t)reinterpret_cast<std::uintptr_t>(sync));
+    }
+
+    // Client memory without a known size can't be stored, replay gets null instead
+    template<typename T>
+    void encode(GLFunction function, const T *pointer) {
+        if (pointer && std::find(std::begin(OFFSET_POINTERS), std::end(OFFSET_POINTERS), function) == std::end(OFFSET_POINTERS)) {
+            if (!warned[function]) {
+                std::cout << "WARNING::GLTRACE::UNSIZED_POINTER " << GL_FUNCTION_NAMES[function] << std::endl;
+                warned[function] = true;
+            }
+            putRaw(nullptr);
+            return;
+        }
+        putRaw(pointer);
+    }
+
+    template<typename T>
+    void encode(GLFunction, T *) {
+        putOutput(0);
+    }
+
+    template<typename R>
+    typename std::enable_if<std::is_arithmetic<R>::value>::type encodeResult(R value) {
+        append(call, value);
+    }
+
+    template<typename R>
+    typename std::enable_if<std::is_pointer<R>::value>::type encodeResult(R value) {
+        append(call, (std::uint64_t)reinterpret_cast<std::uintptr_t>(value));
+    }
+
+    void beginCall(GLFunction function) {
+        call.clear();
+        append(call, (std::uint16_t)function);
+    }
+
+    void endCall() {
+        stream.insert(stream.end(), call.begin(), call.end());
+        flush(false);
+    }
+
+    // Calls after the real function returned, so outputs and results can be recorded
+    template<typename R>
+    struct Invoke {
+        template<typename F, typename... Args>
+        static R run(GLFunction function, F fn, Args... args) {
+            R result = fn(args...);
+            beginCall(function);
+            (encode(function, args), ...);
+            encodeResult(result);
+            endCall();
+            return result;
+        }
+    };
+
+    template<>
+    struct Invoke<void> {
+        template<typename F, typename... Args>
+        static void run(GLFunction function, F fn, Args... args) {
+            fn(args...);
+            beginCall(function);
+            (encode(function, args), ...);
+            endCall();
+        }
+    };
+
+    template<GLFunction Id, typename F> struct Wrap;
+
+    template<GLFunction Id, typename R, typename... Args>
+    struct Wrap<Id, R (APIENTRY *)(Args...)> {
+        static R APIENTRY call(Args... args) {
+            return Invoke<R>::run(Id, realFunction<R (APIENTRY *)(Args...)>(Id), args...);
+        }
+    };
+
+    // Entry points whose pointers need a size or name handling
+
+    template<GLFunction Id>
+    void APIENTRY genNames(GLsizei n, GLuint *names) {
+        realFunction<void (APIENTRY *)(GLsizei, GLuint*)>(Id)(n, names);
+        beginCall(Id);
+        append(call, n);
+        putNames(GEN_NAMES, n, names);
+        endCall();
+    }
+
+    template<GLFunction Id>
+    void APIENTRY deleteNames(GLsizei n, const GLuint *names) {
+        realFunction<void (APIENTRY *)(GLsizei, const GLuint*)>(Id)(n, names);
+        beginCall(Id);
+        append(call, n);
+        putNames(NAME_ARRAY, n, names);
+        endCall();
+    }
+
+    void APIENTRY shaderSource(GLuint shader, GLsizei count, const GLchar *const *strings, const GLint *lengths) {
+        realFunction<PFNGLSHADERSOURCEPROC>(GL_ID_glShaderSource)(shader, count, strings, lengths);
+        beginCall(GL_ID_glShaderSource);
+        append(call, shader);
+        append(call, count);
+
+        // Stored null terminated, the lengths aren't needed on replay
+        std::vector<std::uint32_t> indices;
+        for (GLsizei i = 0; i < count; i++) {
+            std::string source = (lengths && lengths[i] >= 0) ? std::string(strings[i], lengths[i]) : std::string(strings[i]);
+            indices.push_back(blob(source.c_str(), source.size() + 1));
+        }
+        append(call, (std::uint8_t)STRINGS);
+        append(call, (std::uint32_t)count);
+        for (std::uint32_t index : indices) {
+            append(call, index);
+        }
+        putRaw(nullptr);
+        endCall();
+    }
+
+    // Calls taking a program and a name string
+    template<GLFunction Id, typename R>
+    R APIENTRY programString(GLuint program, const GLchar *name) {
+        R result = realFunction<R (APIENTRY *)(GLuint, const GLchar*)>(Id)(program, name);
+        beginCall(Id);
+        append(call, program);
+        putBlob(name, std::strlen(name) + 1);
+        encodeResult(result);
+        endCall();
+        return result;
+    }
+
+    template<GLFunction Id>
+    void APIENTRY programIndexString(GLuint program, GLuint index, const GLchar *name) {
+        realFunction<void (APIENTRY *)(GLuint, GLuint, const GLchar*)>(Id)(program, index, name);
+        beginCall(Id);
+        append(call, program);
+        append(call, index);
+        putBlob(name, std::strlen(name) + 1);
+        endCall();
+    }
+
+    template<GLFunction Id, int N, typename T>
+    void APIENTRY uniformVector(GLint location, GLsizei count, const T *value) {
+        realFunction<void (APIENTRY *)(GLint, GLsizei, const T*)>(Id)(location, count, value);
+        beginCall(Id);
+        append(call, location);
+        append(call, count);
+        putBlob(value, (std::uint64_t)count * N * sizeof(T));
+        endCall();
+    }
+
+    template<GLFunction Id, int N>
+    void APIENTRY uniformMatrix(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+        realFunction<void (APIENTRY *)(GLint, GLsizei, GLboolean, const GLfloat*)>(Id)(location, count, transpose, value);
+        beginCall(Id);
+        append(call, location);
+        append(call, count);
+        append(call, transpose);
+        putBlob(value, (std::uint64_t)count * N * sizeof(GLfloat));
+        endCall();
+    }
+
+    void APIENTRY drawBuffers(GLsizei n, const GLenum *buffers) {
+        realFunction<PFNGLDRAWBUFFERSPROC>(GL_ID_glDrawBuffers)(n, buffers);
+        beginCall(GL_ID_glDrawBuffers);
+        append(call, n);
+        putBlob(buffers, (std::uint64_t)n * sizeof(GLenum));
+        endCall();
+    }
+
+    template<GLFunction Id, typename T>
+    void APIENTRY clearBuffer(GLenum buffer, GLint drawbuffer, const T *value) {
+        realFunction<void (APIENTRY *)(GLenum, GLint, const T*)>(Id)(buffer, drawbuffer, value);
+        beginCall(Id);
+        append(call, buffer);
+        append(call, drawbuffer);
+        putBlob(value, (buffer == GL_COLOR ? 4 : 1) * sizeof(T));
+        endCall();
+    }
+
+    void APIENTRY bindBuffer(GLenum target, GLuint buffer) {
+        if (target == GL_PIXEL_PACK_BUFFER) packBuffer = buffer;
+        if (target == GL_PIXEL_UNPACK_BUFFER) unpackBuffer = buffer;
+        Wrap<GL_ID_glBindBuffer, PFNGLBINDBUFFERPROC>::call(target, buffer);
+    }
+
+    void APIENTRY pixelStorei(GLenum pname, GLint value) {
+        if (pname == GL_UNPACK_ROW_LENGTH) unpackRowLength = value;
+        if (pname == GL_UNPACK_ALIGNMENT) unpackAlignment = value;
+        if (pname == GL_PACK_ROW_LENGTH) packRowLength = value;
+        if (pname == GL_PACK_ALIGNMENT) packAlignment = value;
+        Wrap<GL_ID_glPixelStorei, PFNGLPIXELSTOREIPROC>::call(pname, value);
+    }
+
+    // Bytes GL reads or writes for an image with the current row length and alignment
+    std::uint64_t imageSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLint rowLength, GLint alignment) {
+        std::uint64_t pixel = glPixelSize(format, type);
+        std::uint64_t row = (std::uint64_t)(rowLength > 0 ? rowLength : width) * pixel;
+        row = (row + alignment - 1) / alignment * alignment;
+        if (width == 0 || height == 0 || depth == 0) {
+            return 0;
+        }
+        return row * ((std::uint64_t)height * depth - 1) + width * pixel;
+    }
+
+    // Pixels come from client memory unless an unpack buffer is bound
+    void putPixels(const void *pixels, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type) {
+        if (unpackBuffer) {
+            putRaw(pixels);
+        } else {
+            putBlob(pixels, imageSize(width, height, depth, format, type, unpackRowLength, unpackAlignment));
+        }
+    }
+
+    void APIENTRY texImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {
+        realFunction<PFNGLTEXIMAGE2DPROC>(GL_ID_glTexImage2D)(target, level, internalformat, width, height, border, format, type, pixels);
+        beginCall(GL_ID_glTexImage2D);
+        append(call, target); append(call, level); append(call, internalformat);
+        append(call, width); append(call, height); append(call, border);
+        append(call, format); append(call, type);
+        putPixels(pixels, width, height, 1, format, type);
+        endCall();
+    }
+
+    void APIENTRY texSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {
+        realFunction<PFNGLTEXSUBIMAGE2DPROC>(GL_ID_glTexSubImage2D)(target, level, x, y, width, height, format, type, pixels);
+        beginCall(GL_ID_glTexSubImage2D);
+        append(call, target); append(call, level); append(call, x); append(call, y);
+        append(call, width); append(call, height);
+        append(call, format); append(call, type);
+        putPixels(pixels, width, height, 1, format, type);
+        endCall();
+    }
+
+    void APIENTRY texImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels) {
+        realFunction<PFNGLTEXIMAGE3DPROC>(GL_ID_glTexImage3D)(target, level, internalformat, width, height, depth, border, format, type, pixels);
+        beginCall(GL_ID_glTexImage3D);
+        append(call, target); append(call, level); append(call, internalformat);
+        append(call, width); append(call, height); append(call, depth); append(call, border);
+        append(call, format); append(call, type);
+        putPixels(pixels, width, height, depth, format, type);
+        endCall();
+    }
+
+    void APIENTRY texSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels) {
+        realFunction<PFNGLTEXSUBIMAGE3DPROC>(GL_ID_glTexSubImage3D)(target, level, x, y, z, width, height, depth, format, type, pixels);
+        beginCall(GL_ID_glTexSubImage3D);
+        append(call, target); append(call, level); append(call, x); append(call, y); append(call, z);
+        append(call, width); append(call, height); append(call, depth);
+        append(call, format); append(call, type);
+        putPixels(pixels, width, height, depth, format, type);
+        endCall();
+    }
+
+    void APIENTRY readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels) {
+        realFunction<PFNGLREADPIXELSPROC>(GL_ID_glReadPixels)(x, y, width, height, format, type, pixels);
+        beginCall(GL_ID_glReadPixels);
+        append(call, x); append(call, y); append(call, width); append(call, height);
+        append(call, format); append(call, type);
+        if (packBuffer) {
+            putRaw(pixels);
+        } else {
+            putOutput(imageSize(width, height, 1, format, type, packRowLength, packAlignment));
+        }
+        endCall();
+    }
+
+    void APIENTRY bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+        realFunction<PFNGLBUFFERDATAPROC>(GL_ID_glBufferData)(target, size, data, usage);
+        beginCall(GL_ID_glBufferData);
+        append(call, target);
+        append(call, size);
+        putBlob(data, size);
+        append(call, usage);
+        endCall();
+    }
+
+    void APIENTRY bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+        realFunction<PFNGLBUFFERSUBDATAPROC>(GL_ID_glBufferSubData)(target, offset, size, data);
+        beginCall(GL_ID_glBufferSubData);
+        append(call, target);
+        append(call, offset);
+        append(call, size);
+        putBlob(data, size);
+        endCall();
+    }
+
+    void* APIENTRY mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        void *pointer = Wrap<GL_ID_glMapBufferRange, PFNGLMAPBUFFERRANGEPROC>::call(target, offset, length, access);
+        Mapping mapping = {pointer, length, access};
+        mappings[target] = mapping;
+        return pointer;
+    }
+
+    // What the engine wrote into a mapping becomes part of the trace just before the unmap
+    GLboolean APIENTRY unmapBuffer(GLenum target) {
+        auto found = mappings.find(target);
+        if (found != mappings.end()) {
+            if ((found->second.access & GL_MAP_WRITE_BIT) && found->second.pointer) {
+                std::uint32_t index = blob(found->second.pointer, found->second.length);
+                append(stream, TAG_MAPPED_WRITE);
+                append(stream, (std::uint32_t)target);
+                append(stream, index);
+            }
+            mappings.erase(found);
+        }
+        return Wrap<GL_ID_glUnmapBuffer, PFNGLUNMAPBUFFERPROC>::call(target);
+    }
+
+    void installWrappers() {
+#define GLTRACE_WRAP(name, type) \
+        real[GL_ID_##name] = reinterpret_cast<void*>(name); \
+        if (name) name = &Wrap<GL_ID_##name, type>::call;
+        GL_FUNCTIONS(GLTRACE_WRAP)
+#undef GLTRACE_WRAP
+
+        glGenBuffers = &genNames<GL_ID_glGenBuffers>;
+        glGenTextures = &genNames<GL_ID_glGenTextures>;
+        glGenVertexArrays = &genNames<GL_ID_glGenVertexArrays>;
+        glGenFramebuffers = &genNames<GL_ID_glGenFramebuffers>;
+        glGenRenderbuffers = &genNames<GL_ID_glGenRenderbuffers>;
+        glGenQueries = &genNames<GL_ID_glGenQueries>;
+        glGenSamplers = &genNames<GL_ID_glGenSamplers>;
+        glDeleteBuffers = &deleteNames<GL_ID_glDeleteBuffers>;
+        glDeleteTextures = &deleteNames<GL_ID_glDeleteTextures>;
+        glDeleteVertexArrays = &deleteNames<GL_ID_glDeleteVertexArrays>;
+        glDeleteFramebuffers = &deleteNames<GL_ID_glDeleteFramebuffers>;
+        glDeleteRenderbuffers = &deleteNames<GL_ID_glDeleteRenderbuffers>;
+        glDeleteQueries = &deleteNames<GL_ID_glDeleteQueries>;
+        glDeleteSamplers = &deleteNames<GL_ID_glDeleteSamplers>;
+
+        glShaderSource = &shaderSource;
+        glGetUniformLocation = &programString<GL_ID_glGetUniformLocation, GLint>;
+        glGetAttribLocation = &programString<GL_ID_glGetAttribLocation, GLint>;
+        glGetUniformBlockIndex = &programString<GL_ID_glGetUniformBlockIndex, GLuint>;
+        glBindAttribLocation = &programIndexString<GL_ID_glBindAttribLocation>;
+        glBindFragDataLocation = &programIndexString<GL_ID_glBindFragDataLocation>;
+
+        glUniform1fv = &uniformVector<GL_ID_glUniform1fv, 1, GLfloat>;
+        glUniform2fv = &uniformVector<GL_ID_glUniform2fv, 2, GLfloat>;
+        glUniform3fv = &uniformVector<GL_ID_glUniform3fv, 3, GLfloat>;
+        glUniform4fv = &uniformVector<GL_ID_glUniform4fv, 4, GLfloat>;
+        glUniform1iv = &uniformVector<GL_ID_glUniform1iv, 1, GLint>;
+        glUniform2iv = &uniformVector<GL_ID_glUniform2iv, 2, GLint>;
+        glUniform3iv = &uniformVector<GL_ID_glUniform3iv, 3, GLint>;
+        glUniform4iv = &uniformVector<GL_ID_glUniform4iv, 4, GLint>;
+        glUniform1uiv = &uniformVector<GL_ID_glUniform1uiv, 1, GLuint>;
+        glUniform2uiv = &uniformVector<GL_ID_glUniform2uiv, 2, GLuint>;
+        glUniform3uiv = &uniformVector<GL_ID_glUniform3uiv, 3, GLuint>;
+        glUniform4uiv = &uniformVector<GL_ID_glUniform4uiv, 4, GLuint>;
+        glUniformMatrix2fv = &uniformMatrix<GL_ID_glUniformMatrix2fv, 4>;
+        glUniformMatrix3fv = &uniformMatrix<GL_ID_glUniformMatrix3fv, 9>;
+        glUniformMatrix4fv = &uniformMatrix<GL_ID_glUniformMatrix4fv, 16>;
+        glUniformMatrix2x3fv = &uniformMatrix<GL_ID_glUniformMatrix2x3fv, 6>;
+        glUniformMatrix3x2fv = &uniformMatrix<GL_ID_glUniformMatrix3x2fv, 6>;
+        glUniformMatrix2x4fv = &uniformMatrix<GL_ID_glUniformMatrix2x4fv, 8>;
+        glUniformMatrix4x2fv = &uniformMatrix<GL_ID_glUniformMatrix4x2fv, 8>;
+        glUniformMatrix3x4fv = &uniformMatrix<GL_ID_glUniformMatrix3x4fv, 12>;
+        glUniformMatrix4x3fv = &uniformMatrix<GL_ID_glUniformMatrix4x3fv, 12>;
+
+        glDrawBuffers = &drawBuffers;
+        glClearBufferfv = &clearBuffer<GL_ID_glClearBufferfv, GLfloat>;
+        glClearBufferiv = &clearBuffer<GL_ID_glClearBufferiv, GLint>;
+        glClearBufferuiv = &clearBuffer<GL_ID_glClearBufferuiv, GLuint>;
+        glBindBuffer = &bindBuffer;
+        glPixelStorei = &pixelStorei;
+        glTexImage2D = &texImage2D;
+        glTexSubImage2D = &texSubImage2D;
+        glTexImage3D = &texImage3D;
+        glTexSubImage3D = &texSubImage3D;
+        glReadPixels = &readPixels;
+        glBufferData = &bufferData;
+        glBufferSubData = &bufferSubData;
+        glMapBufferRange = &mapBufferRange;
+        glUnmapBuffer = &unmapBuffer;
+    }
+
+    void restoreFunctions() {
+#define GLTRACE_RESTORE(name, type) name = reinterpret_cast<type>(real[GL_ID_##name]);
+        GL_FUNCTIONS(GLTRACE_RESTORE)
+#undef GLTRACE_RESTORE
+    }
+
+    // ---- Replay ----
+
+    struct Blob {
+        const char *data;
+        std::uint64_t size;
+    };
+
+    class Player
+    {
+        public:
+            const char *cursor;
+            const char *end;
+            std::vector<Blob> blobs;
+            std::unordered_map<std::uint32_t, std::uint32_t> names[NAMESPACE_COUNT];
+            std::unordered_map<std::uint64_t, GLint> locations;        // (program << 32 | location) -> location
+            std::unordered_map<std::uint64_t, GLsync> syncs;
+            std::unordered_map<GLenum, void*> mapped;
+            std::int8_t argumentSpaces[GL_FUNCTION_COUNT][16];
+            GLuint program = 0;          // Current program as named in the trace
+            std::uint64_t calls = 0;
+            bool failed = false;
+
+            // Per call storage for outputs and rewritten arrays
+            std::vector<std::vector<char>> scratch;
+            std::size_t scratchUsed = 0;
+            std::uint64_t captured[16];  // Arguments as recorded, before remapping
+            std::vector<GLuint> generated; // Names a Gen call recorded
+
+            Player() {
+                std::memset(argumentSpaces, NONE, sizeof(argumentSpaces));
+                for (const NameArgument &argument : NAME_ARGUMENTS) {
+                    argumentSpaces[argument.function][argument.index] = argument.space;
+                }
+            }
+
+            template<typename T>
+            T read() {
+                T value;
+                if (cursor + sizeof(T) > end) {
+                    failed = true;
+                    std::memset(&value, 0, sizeof(T));
+                    return value;
+                }
+                std::memcpy(&value, cursor, sizeof(T));
+                cursor += sizeof(T);
+                return value;
+            }
+
+            char* allocate(std::size_t size) {
+                if (scratchUsed == scratch.size()) {
+                    scratch.emplace_back();
+                }
+                std::vector<char> &block = scratch[scratchUsed++];
+                if (block.size() < size) {
+                    block.resize(size);
+                }
+                return block.data();
+            }
+
+            GLuint mapName(Namespace space, GLuint name) {
+                if (name == 0) {
+                    return 0;
+                }
+                auto found = names[space].find(name);
+                return found != names[space].end() ? found->second : name;
+            }
+
+            // Arguments by type
+            template<typename T>
+            typename std::enable_if<std::is_arithmetic<T>::value, T>::type decode(GLFunction function, int index, T*) {
+                T value = read<T>();
+                if (index < 16) {
+                    captured[index] = (std::uint64_t)value;
+                }
+                if (std::is_integral<T>::value && index < 16) {
+                    if (argumentSpaces[function][index] != NONE) {
+                        return (T)mapName((Namespace)argumentSpaces[function][index], (GLuint)value);
+                    }
+                    if (index == 0 && isUniformSetter(function)) {
+                        auto found = locations.find(((std::uint64_t)program << 32) | (std::uint32_t)value);
+                        return found != locations.end() ? (T)found->second : value;
+                    }
+                }
+                return value;
+            }
+
+            GLsync decode(GLFunction, int, GLsync*) {
+                auto found = syncs.find(read<std::uint64_t>());
+                return found != syncs.end() ? found->second : nullptr;
+            }
+
+            template<typename T>
+            const T* decode(GLFunction function, int, const T**) {
+                std::uint8_t kind = read<std::uint8_t>();
+                switch (kind) {
+                    case RAW:
+                        return reinterpret_cast<const T*>((std::uintptr_t)read<std::uint64_t>());
+                    case BLOB: {
+                        std::uint32_t index = read<std::uint32_t>();
+                        return index < blobs.size() ? reinterpret_cast<const T*>(blobs[index].data) : nullptr;
+                    }
+                    case STRINGS: {
+                        std::uint32_t count = read<std::uint32_t>();
+                        const char **strings = reinterpret_cast<const char**>(allocate(count * sizeof(char*)));
+                        for (std::uint32_t i = 0; i < count; i++) {
+                            std::uint32_t index = read<std::uint32_t>();
+                            strings[i] = index < blobs.size() ? blobs[index].data : "";
+                        }
+                        return reinterpret_cast<const T*>(strings);
+                    }
+                    case NAME_ARRAY: {
+                        std::uint32_t count = read<std::uint32_t>();
+                        Namespace space = arrayNamespace(DELETE, std::size(DELETE), function);
+                        GLuint *array = reinterpret_cast<GLuint*>(allocate(count * sizeof(GLuint)));
+                        for (std::uint32_t i = 0; i < count; i++) {
+                            GLuint name = read<std::uint32_t>();
+                            array[i] = space != NONE ? mapName(space, name) : name;
+                            if (space != NONE) {
+                                names[space].erase(name);
+                            }
+                        }
+                        return reinterpret_cast<const T*>(array);
+                    }
+                }
+                failed = true;
+                return nullptr;
+            }
+
+            template<typename T>
+            T* decode(GLFunction, int, T**) {
+                std::uint8_t kind = read<std::uint8_t>();
+                if (kind == GEN_NAMES) {
+                    std::uint32_t count = read<std::uint32_t>();
+                    generated.resize(count);
+                    for (std::uint32_t i = 0; i < count; i++) {
+                        generated[i] = read<std::uint32_t>();
+                    }
+                    return reinterpret_cast<T*>(allocate(count * sizeof(GLuint)));
+                }
+                if (kind == RAW) {
+                    return reinterpret_cast<T*>((std::uintptr_t)read<std::uint64_t>());
+                }
+                if (kind != OUTPUT) {
+                    failed = true;
+                    return nullptr;
+                }
+                // Generous for queries whose size we didn't record
+                std::uint32_t size = read<std::uint32_t>();
+                return reinterpret_cast<T*>(allocate(std::max<std::uint32_t>(size, 1 << 16)));
+            }
+
+            template<typename R>
+            typename std::enable_if<std::is_arithmetic<R>::value, std::uint64_t>::type decodeResult() {
+                return (std::uint64_t)read<R>();
+            }
+
+            template<typename R>
+            typename std::enable_if<std::is_pointer<R>::value, std::uint64_t>::type decodeResult() {
+                return read<std::uint64_t>();
+            }
+
+            // Map what the trace created onto what this context created
+            template<typename R>
+            void created(GLFunction function, std::uint64_t recorded, R result);
+    };
+
+    Player *player = nullptr;
+
+    template<typename R>
+    void Player::created(GLFunction function, std::uint64_t recorded, R result) {
+        std::uint64_t value = 0;
+        std::memcpy(&value, &result, std::min(sizeof(R), sizeof(value)));
+        switch (function) {
+            case GL_ID_glCreateShader:
+            case GL_ID_glCreateProgram:
+                names[PROGRAM][(GLuint)recorded] = (GLuint)value;
+                break;
+            case GL_ID_glFenceSync:
+                syncs[recorded] = reinterpret_cast<GLsync>((std::uintptr_t)value);
+                break;
+            case GL_ID_glGetUniformLocation:
+                locations[((std::uint64_t)captured[0] << 32) | (std::uint32_t)recorded] = (GLint)value;
+                break;
+            case GL_ID_glMapBufferRange:
+                mapped[(GLenum)captured[0]] = reinterpret_cast<void*>((std::uintptr_t)value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    template<typename R>
+    struct Replay {
+        template<typename F, typename Tuple, std::size_t... I>
+        static void run(GLFunction function, F fn, Tuple &args, std::index_sequence<I...>) {
+            std::uint64_t recorded = player->decodeResult<R>();
+            R result = fn(std::get<I>(args)...);
+            player->created(function, recorded, result);
+        }
+    };
+
+    template<>
+    struct Replay<void> {
+        template<typename F, typename Tuple, std::size_t... I>
+        static void run(GLFunction, F fn, Tuple &args, std::index_sequence<I...>) {
+            fn(std::get<I>(args)...);
+        }
+    };
+
+    template<GLFunction Id, typename F> struct Play;
+
+    template<GLFunction Id, typename R, typename... Args>
+    struct Play<Id, R (APIENTRY *)(Args...)> {
+        static void run(void *function) {
+            run(function, std::index_sequence_for<Args...>());
+        }
+
+        template<std::size_t... I>
+        static void run(void *function, std::index_sequence<I...> sequence) {
+            // Braced initialisation decodes the arguments left to right
+            std::tuple<Args...> args{player->decode(Id, (int)I, (Args*)nullptr)...};
+            Replay<R>::run(Id, reinterpret_cast<R (APIENTRY *)(Args...)>(function), args, sequence);
+        }
+    };
+
+#define GLTRACE_PLAY(name, type) &Play<GL_ID_##name, type>::run,
+    void (* const PLAY[])(void*) = {
+        GL_FUNCTIONS(GLTRACE_PLAY)
+    };
+#undef GLTRACE_PLAY
+
+    // Run records until the end of the next frame, false at the end of the trace
+    bool playFrame(Player &p) {
+        void *functions[GL_FUNCTION_COUNT];
+#define GLTRACE_POINTER(name, type) functions[GL_ID_##name] = reinterpret_cast<void*>(name);
+        GL_FUNCTIONS(GLTRACE_POINTER)
+#undef GLTRACE_POINTER
+
+        while (p.cursor < p.end && !p.failed) {
+            std::uint16_t tag = p.read<std::uint16_t>();
+            if (tag == TAG_FRAME) {
+                return true;
+            }
+            if (tag == TAG_BLOB) {
+                std::uint32_t index = p.read<std::uint32_t>();
+                std::uint64_t size = p.read<std::uint64_t>();
+                if (p.cursor + size > p.end) {
+                    p.failed = true;
+                    break;
+                }
+                if (index >= p.blobs.size()) {
+                    p.blobs.resize(index + 1);
+                }
+                p.blobs[index].data = p.cursor;
+                p.blobs[index].size = size;
+                p.cursor += size;
+                continue;
+            }
+            if (tag == TAG_MAPPED_WRITE) {
+                GLenum target = p.read<std::uint32_t>();
+                std::uint32_t index = p.read<std::uint32_t>();
+                void *pointer = p.mapped[target];
+                if (pointer && index < p.blobs.size()) {
+                    std::memcpy(pointer, p.blobs[index].data, p.blobs[index].size);
+                }
+                continue;
+            }
+            if (tag >= GL_FUNCTION_COUNT || !functions[tag]) {
+                std::cout << "ERROR::GLTRACE::BAD_RECORD " << tag << std::endl;
+                p.failed = true;
+                break;
+            }
+
+            p.scratchUsed = 0;
+            PLAY[tag](functions[tag]);
+            if (tag == GL_ID_glUseProgram) {
+                p.program = (GLuint)p.captured[0];
+            }
+            if (!p.generated.empty()) {
+                Namespace space = arrayNamespace(GENERATE, std::size(GENERATE), (GLFunction)tag);
+                const GLuint *made = reinterpret_cast<const GLuint*>(p.scratch[0].data());
+                for (std::size_t i = 0; i < p.generated.size() && space != NONE; i++) {
+                    p.names[space][p.generated[i]] = made[i];
+                }
+                p.generated.clear();
+            }
+            p.calls++;
+        }
+        return false;
+    }
+
+    bool readFile(const std::string &path, std::vector<char> &data) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    const std::size_t HEADER_SIZE = sizeof(MAGIC) + 3 * sizeof(std::uint32_t);
+}
+
+void GLTrace::begin(const std::string &path, int frames, int width, int height) {
+    if (active) {
+        return;
+    }
+    file.open(path, std::ios::binary);
+    if (!file) {
+        std::cout << "ERROR::GLTRACE::OPEN_FAILED " << path << std::endl;
+        return;
+    }
+
+    // Entry point numbering has to match the replaying build
+    file.write(MAGIC, sizeof(MAGIC));
+    std::uint32_t header[3] = {(std::uint32_t)GL_FUNCTION_COUNT, (std::uint32_t)width, (std::uint32_t)height};
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::memset(warned, 0, sizeof(warned));
+    blobs.clear();
+    blobData.clear();
+    blobRanges.clear();
+    blobCount = 0;
+    framesLeft = frames;
+    installWrappers();
+    active = true;
+}
+
+bool GLTrace::recording() {
+    return active;
+}
+
+void GLTrace::endFrame() {
+    if (!active) {
+        return;
+    }
+    append(stream, TAG_FRAME);
+    flush(false);
+    if (--framesLeft <= 0) {
+        GLTrace::end();
+    }
+}
+
+void GLTrace::end() {
+    if (!active) {
+        return;
+    }
+    restoreFunctions();
+    flush(true);
+    file.close();
+    active = false;
+
+    // The copies only matter while recording
+    blobs.clear();
+    std::vector<char>().swap(blobData);
+    blobRanges.clear();
+    std::cout << "GLTRACE::WRITTEN blobs=" << blobCount << std::endl;
+}
+
+bool GLTrace::readHeader(const std::string &path, int &width, int &height) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    std::uint32_t header[3];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != GL_FUNCTION_COUNT) {
+        return false;
+    }
+    width = (int)header[1];
+    height = (int)header[2];
+    return true;
+}
+
+bool GLTrace::replay(const std::string &path, int loops, ReplayResult &result) {
+    int width, height;
+    std::vector<char> data;
+    if (!readHeader(path, width, height) || !readFile(path, data)) {
+        std::cout << "ERROR::GLTRACE::NOT_A_TRACE " << path << std::endl;
+        return false;
+    }
+
+    Player p;
+    player = &p;
+    p.cursor = data.data() + HEADER_SIZE;
+    p.end = data.data() + data.size();
+
+    // Setup and the first frame run once, they create what the other frames use
+    playFrame(p);
+    glFinish();
+    const char *loopStart = p.cursor;
+
+    std::vector<double> times;
+    std::uint64_t loopCalls = 0;
+    std::uint64_t loopFrames = 0;
+    for (int loop = 0; loop < loops && !p.failed; loop++) {
+        p.cursor = loopStart;
+        p.calls = 0;
+        loopFrames = 0;
+        for (;;) {
+            auto start = std::chrono::steady_clock::now();
+            bool more = playFrame(p);
+            glFinish();
+            if (!more || p.failed) {
+                break;
+            }
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            loopFrames++;
+        }
+        loopCalls = p.calls;
+    }
+    player = nullptr;
+
+    if (p.failed) {
+        std::cout << "ERROR::GLTRACE::CORRUPT_TRACE " << path << std::endl;
+        return false;
+    }
+
+    result.frames = (int)times.size();
+    result.calls = loopFrames ? loopCalls / loopFrames : 0;
+    result.medianMs = 0.0;
+    result.p95Ms = 0.0;
+    if (!times.empty()) {
+        std::sort(times.begin(), times.end());
+        result.medianMs = times[times.size() / 2];
+        result.p95Ms = times[std::min(times.size() - 1, (std::size_t)(times.size() * 0.95))];
+    }
+    return true;
+}
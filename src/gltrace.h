@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * GL command capture and replay. While recording, every glad entry point is
+ * wrapped so each call and its arguments go to a compact binary trace along
+ * with the data it reads: buffer, texture, uniform and shader payloads are
+ * stored once per distinct content and referenced by index after that. The
+ * replay side re-issues the calls against a fresh context, mapping object
+ * names and uniform locations from the recording onto the ones it gets.
+ */
+
+namespace GLTrace {
+    // Start recording on the context thread, before any GL call that should be replayed.
+    // Stops by itself once frames frames have ended
+    extern void begin(const std::string &path, int frames, int width, int height);
+    extern bool recording();
+
+    // Mark the end of a frame
+    extern void endFrame();
+
+    // Stop recording, put the real entry points back and close the file
+    extern void end();
+
+    // Window size the trace was recorded at, false if path isn't a trace
+    extern bool readHeader(const std::string &path, int &width, int &height);
+
+    struct ReplayResult {
+        int frames;             // Frames timed
+        double medianMs;
+        double p95Ms;
+        std::uint64_t calls;    // GL calls per frame
+    };
+
+    // Replay the setup and first frame once, then the remaining frames loops times,
+    // finishing and timing every frame. Needs a current context
+    extern bool replay(const std::string &path, int loops, ReplayResult &result);
+}
@@ -0,0 +1,182 @@
+#include "./gpucull.h"
+#include "./gl43.h"
+#include "./glstate.h"
+#include "./cube.h"
+#include "./scene.h"
+#include "./frustum.h"
+#include "./occlusion.h"
+#include "./stats.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+    const GLuint GROUP_SIZE = 64;   // local_size_x of gpuCull.comp
+
+    // Same layout as Instance in gpuCull.comp and the per instance attributes of cubeInstanced.vs
+    struct Instance {
+        glm::vec4 centreRadius;
+        glm::vec4 scale;
+    };
+
+    // Handed from the simulation to the context thread
+    std::mutex captureMutex;
+    std::vector<Instance> captured;
+    std::uint64_t capturedRevision = 0;
+
+    std::uint64_t uploadedRevision = 0;
+    GLuint instanceCount = 0;       // Resident instances
+    GLuint program;
+    GLint instanceCountLocation, planesLocation, hiZLocation, pyramidViewProjectionLocation, pyramidSizeLocation, pyramidLevelsLocation;
+    GLuint instanceBuffer, visibleBuffer, commandBuffer, pyramidBuffer;
+    unsigned int cubeVAO, cubeVBO, cubeEBO;
+
+    GLuint compileCompute(const char* path) {
+        std::ifstream file(path);
+        std::stringstream source;
+        source << file.rdbuf();
+        if (!file) {
+            std::cout << "ERROR::GPUCULL::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+        }
+        std::string code = source.str();
+        const char* text = code.c_str();
+
+        int success;
+        char infoLog[1024];
+        GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, &text, NULL);
+        glCompileShader(shader);
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::GPUCULL::COMPILATION_ERROR\n" << infoLog << std::endl;
+        }
+
+        GLuint linked = glCreateProgram();
+        glAttachShader(linked, shader);
+        glLinkProgram(linked);
+        glGetProgramiv(linked, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(linked, 1024, NULL, infoLog);
+            std::cout << "ERROR::GPUCULL::LINKING_ERROR\n" << infoLog << std::endl;
+        }
+        glDeleteShader(shader);
+        return linked;
+    }
+
+    // A scene captured since the last upload replaces the resident one, the copy is freed after
+    void upload() {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        if (capturedRevision == uploadedRevision) {
+            return;
+        }
+        uploadedRevision = capturedRevision;
+        instanceCount = (GLuint)captured.size();
+
+        GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, captured.size() * sizeof(Instance), captured.data(), GL_STATIC_DRAW);
+        GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, captured.size() * sizeof(Instance), nullptr, GL_DYNAMIC_COPY);
+        std::vector<Instance>().swap(captured);
+    }
+}
+
+void GpuCull::capture() {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    captured.clear();
+    for (const Scene::Instance &instance : Scene::resident) {
+        captured.push_back(Instance{glm::vec4(instance.position, instance.radius), glm::vec4(instance.scale, 0.0f)});
+    }
+    capturedRevision++;
+}
+
+void GpuCull::init() {
+    program = compileCompute("../src/shaders/gpuCull.comp");
+    instanceCountLocation = glGetUniformLocation(program, "instanceCount");
+    planesLocation = glGetUniformLocation(program, "planes");
+    hiZLocation = glGetUniformLocation(program, "hiZ");
+    pyramidViewProjectionLocation = glGetUniformLocation(program, "pyramidViewProjection");
+    pyramidSizeLocation = glGetUniformLocation(program, "pyramidSize");
+    pyramidLevelsLocation = glGetUniformLocation(program, "pyramidLevels");
+
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers(1, &visibleBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &pyramidBuffer);
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(GL43::DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+
+    // The cube's attributes, trivial indices since it isn't indexed elsewhere, and the survivors per instance
+    Cube::createCube(cubeVAO, cubeVBO, 0);
+    Cube::bindNormals(cubeVAO, cubeVBO, 1);
+    Cube::bindTexture(cubeVAO, cubeVBO, 2);
+    std::vector<GLuint> indices(Cube::vertCount);
+    for (std::size_t i = 0; i < indices.size(); i++) {
+        indices[i] = (GLuint)i;
+    }
+    glGenBuffers(1, &cubeEBO);
+    GLState::bindVertexArray(cubeVAO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)sizeof(glm::vec4));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+    GLState::bindVertexArray(0);
+}
+
+void GpuCull::cull(const glm::mat4 &viewProjection, const std::vector<float> &pyramid, const glm::mat4 &pyramidViewProjection) {
+    upload();
+    Stats::set("gpu_cull_instances", (double)instanceCount);
+    if (instanceCount == 0) {
+        return;
+    }
+
+    // Survivors are counted into instanceCount from zero
+    GL43::DrawElementsIndirectCommand command = {(GLuint)Cube::vertCount, 0, 0, 0, 0};
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+
+    bool hiZ = !pyramid.empty();
+    if (hiZ) {
+        GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, pyramidBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, pyramid.size() * sizeof(float), pyramid.data(), GL_STREAM_DRAW);
+    }
+
+    Frustum frustum(viewProjection);
+    GLState::useProgram(program);
+    glUniform1ui(instanceCountLocation, instanceCount);
+    glUniform4fv(planesLocation, 6, glm::value_ptr(frustum.Planes[0]));
+    glUniform1i(hiZLocation, hiZ ? 1 : 0);
+    if (hiZ) {
+        glUniformMatrix4fv(pyramidViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(pyramidViewProjection));
+        glUniform2i(pyramidSizeLocation, Occlusion::WIDTH, Occlusion::HEIGHT);
+        glUniform1i(pyramidLevelsLocation, Occlusion::LEVELS);
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, pyramidBuffer);
+    GL43::dispatchCompute((instanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+    // The draw reads the count as a command and the survivors as vertex attributes
+    GL43::memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuCull::draw() {
+    if (instanceCount == 0) {
+        return;
+    }
+    GLState::bindVertexArray(cubeVAO);
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    GL43::multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 1, 0);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/**
+ * GPU driven culling of the static lit cubes in Scene::resident, on GL 4.3.
+ * Their centres, radii and scales stay resident in a storage buffer, uploaded
+ * once per scene. Every frame a compute shader tests each against the
+ * frustum, and against the occlusion pyramid when Occlusion is on too,
+ * appends the survivors to a compacted instance buffer and counts them
+ * atomically into an indirect draw command, so one glMultiDrawElementsIndirect
+ * draws them all without the CPU reading a single instance back. No CPU
+ * pass visits them per frame: their shadow casters are recorded once, and
+ * occlusion takes a fixed set of them as occluders.
+ */
+
+namespace GpuCull {
+    // Simulation side, once the scene is built: copy the resident cubes for the next upload
+    extern void capture();
+
+    // Context side: compile the compute shader and create the buffers
+    extern void init();
+
+    // Upload a newly captured scene, then cull it for the frame. The pyramid is Occlusion's as
+    // copied by copyPyramid, empty to test the frustum only
+    extern void cull(const glm::mat4 &viewProjection, const std::vector<float> &pyramid, const glm::mat4 &pyramidViewProjection);
+
+    // Draw the survivors with the bound shader, which must be linked with cubeInstanced.vs
+    extern void draw();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Measures GPU time between Begin and End with GL_TIMESTAMP queries. Results
+// are read a few frames later so the CPU never waits on them, and timers may
+// overlap each other unlike GL_TIME_ELAPSED.
+class GpuTimer
+{
+    public:
+        // Most recent measured span in milliseconds
+        double Milliseconds;
+
+        GpuTimer() : Milliseconds(0.0), frame(0), created(false) {}
+
+        void Begin()
+        {
+            if (!created)
+            {
+                glGenQueries(LATENCY * 2, queries);
+                created = true;
+            }
+            glQueryCounter(queries[(frame % LATENCY) * 2], GL_TIMESTAMP);
+        }
+
+        // Returns true if an older measurement became available
+        bool End()
+        {
+            glQueryCounter(queries[(frame % LATENCY) * 2 + 1], GL_TIMESTAMP);
+            frame++;
+            if (frame < LATENCY)
+                return false;
+
+            // Oldest pair, issued LATENCY - 1 frames ago
+            unsigned int slot = frame % LATENCY;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[slot * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return false;
+
+            GLuint64 begin, end;
+            glGetQueryObjectui64v(queries[slot * 2], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(queries[slot * 2 + 1], GL_QUERY_RESULT, &end);
+            Milliseconds = (end - begin) * 1e-6;
+            return true;
+        }
+
+        void Destroy()
+        {
+            if (created)
+                glDeleteQueries(LATENCY * 2, queries);
+            created = false;
+        }
+
+    private:
+        static const unsigned int LATENCY = 4;
+
+        GLuint queries[LATENCY * 2];
+        unsigned int frame;
+        bool created;
+};
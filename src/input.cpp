@@ -0,0 +1,63 @@
+#include "./input.h"
+#include "./spscring.h"
+
+namespace {
+    SpscRing<Input::Event, 1024> events;
+
+    // Producer side: what couldn't be queued because the ring was full, folded into the next push
+    bool overflowing = false;
+    Input::Event overflow[2];
+}
+
+void Input::push(EventType type, double time, float x, float y) {
+    // Flush anything held back first so events stay in order
+    if (overflowing) {
+        overflowing = false;
+        for (Event &held : overflow) {
+            if (held.time != 0.0 && !events.Push(held)) {
+                overflowing = true;
+            } else {
+                held.time = 0.0;
+            }
+        }
+    }
+
+    Event event = {type, time, x, y};
+    if (!overflowing && events.Push(event)) {
+        return;
+    }
+
+    // Ring full, coalesce into the held event of the same type and keep its older timestamp
+    Event &held = overflow[type];
+    if (held.time == 0.0) {
+        held = event;
+    } else {
+        held.x += x;
+        held.y += y;
+    }
+    overflowing = true;
+}
+
+Input::Summary Input::drain() {
+    Summary summary = {0.0f, 0.0f, 0.0f, 0.0, 0};
+
+    Event event;
+    while (events.Pop(event)) {
+        if (summary.count == 0) {
+            summary.firstTime = event.time;
+        }
+        summary.count++;
+
+        switch (event.type) {
+            case MOUSE_MOVE:
+                summary.mouseX += event.x;
+                summary.mouseY += event.y;
+                break;
+            case SCROLL:
+                summary.scroll += event.y;
+                break;
+        }
+    }
+
+    return summary;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * Timestamped input events. GLFW callbacks push into a lock-free queue and
+ * the simulation drains it once per step, so callbacks never touch the camera.
+ */
+
+namespace Input {
+    enum EventType {
+        MOUSE_MOVE,
+        SCROLL
+    };
+
+    struct Event {
+        EventType type;
+        double time;    // glfwGetTime() when the callback fired
+        float x, y;     // Mouse offset or scroll offset
+    };
+
+    // Everything that arrived since the last drain, coalesced
+    struct Summary {
+        float mouseX, mouseY;   // Summed mouse offsets
+        float scroll;           // Summed vertical scroll
+        double firstTime;       // Timestamp of the oldest event, 0 if there were none
+        int count;              // Number of events drained
+    };
+
+    // Producer side, call from the thread polling GLFW events
+    extern void push(EventType type, double time, float x, float y);
+
+    // Consumer side, call from the simulation step
+    extern Summary drain();
+}
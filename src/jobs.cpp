@@ -0,0 +1,388 @@
+#include "./jobs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+    // Chase-Lev work-stealing deque with a fixed capacity. The owner pushes
+    // and pops at the bottom, thieves take from the top.
+    class WorkDeque
+    {
+        public:
+            static const std::int64_t CAPACITY = 4096;
+
+            WorkDeque() : top(0), bottom(0) {
+                for (auto &slot : buffer) {
+                    slot.store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            // Owner only. Returns false when full
+            bool push(Jobs::Task *task) {
+                std::int64_t b = bottom.load(std::memory_order_relaxed);
+                std::int64_t t = top.load(std::memory_order_acquire);
+                if (b - t >= CAPACITY) {
+                    return false;
+                }
+                buffer[b & (CAPACITY - 1)].store(task, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // Owner only
+            Jobs::Task* pop() {
+                std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+                bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t t = top.load(std::memory_order_relaxed);
+
+                if (t > b) {
+                    // Empty
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                Jobs::Task *task = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+                if (t == b) {
+                    // Last element, race the thieves for it
+                    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                        task = nullptr;
+                    }
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                }
+                return task;
+            }
+
+            // Any thread
+            Jobs::Task* steal() {
+                std::int64_t t = top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t b = bottom.load(std::memory_order_acquire);
+                if (t >= b) {
+                    return nullptr;
+                }
+
+                Jobs::Task *task = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return nullptr;
+                }
+                return task;
+            }
+
+        private:
+            alignas(64) std::atomic<std::int64_t> top;
+            alignas(64) std::atomic<std::int64_t> bottom;
+            std::atomic<Jobs::Task*> buffer[CAPACITY];
+    };
+
+    // Threads that are not workers each take one of these extra slots for good, running out is fatal
+    const unsigned int FOREIGN_SLOTS = 8;
+
+    std::vector<std::unique_ptr<WorkDeque>> deques;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running(false);
+
+    // FIFO ring that doubles when full and otherwise keeps its storage, so
+    // steady-state submits don't allocate the way std::deque's blocks do
+    class TaskQueue
+    {
+        public:
+            bool empty() const { return count == 0; }
+
+            void push(Jobs::Task *task) {
+                if (count == items.size()) {
+                    std::vector<Jobs::Task*> grown(std::max<std::size_t>(items.size() * 2, 64));
+                    for (std::size_t i = 0; i < count; i++) {
+                        grown[i] = items[(head + i) % items.size()];
+                    }
+                    items.swap(grown);
+                    head = 0;
+                }
+                items[(head + count) % items.size()] = task;
+                count++;
+            }
+
+            Jobs::Task* pop() {
+                Jobs::Task *task = items[head];
+                head = (head + 1) % items.size();
+                count--;
+                return task;
+            }
+
+        private:
+            std::vector<Jobs::Task*> items;
+            std::size_t head = 0;
+            std::size_t count = 0;
+    };
+
+    // Shared queue used by threads that don't own a deque
+    std::mutex globalMutex;
+    TaskQueue globalQueue;
+
+    // Sleeping support for idle workers
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int> queued(0);
+
+    std::atomic<unsigned int> nextForeignSlot(0);
+    thread_local int slot = -1;
+    thread_local unsigned int stealSeed = 0;
+
+    void execute(Jobs::Task *task) {
+        task->fn(task->data);
+
+        for (Jobs::Task *next : task->successors) {
+            if (next->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Jobs::submit(next);
+            }
+        }
+        task->remaining->fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    Jobs::Task* takeGlobal() {
+        std::lock_guard<std::mutex> lock(globalMutex);
+        if (globalQueue.empty()) {
+            return nullptr;
+        }
+        return globalQueue.pop();
+    }
+
+    Jobs::Task* findWork() {
+        Jobs::Task *task = nullptr;
+        unsigned int count = (unsigned int)deques.size();
+
+        // Own deque first, LIFO keeps caches warm
+        if (slot >= 0 && (unsigned int)slot < count) {
+            task = deques[slot]->pop();
+        }
+
+        if (!task) {
+            task = takeGlobal();
+        }
+
+        // Steal from a random victim onwards
+        if (!task && count > 0) {
+            stealSeed = stealSeed * 1664525u + 1013904223u;
+            unsigned int start = (stealSeed >> 8) % count;
+            for (unsigned int i = 0; i < count && !task; i++) {
+                unsigned int victim = (start + i) % count;
+                if ((int)victim != slot) {
+                    task = deques[victim]->steal();
+                }
+            }
+        }
+
+        if (task) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    void workerLoop(unsigned int index) {
+        slot = (int)index;
+        stealSeed = index * 2654435761u + 1;
+
+        while (running.load(std::memory_order_acquire)) {
+            Jobs::Task *task = findWork();
+            if (task) {
+                execute(task);
+                continue;
+            }
+
+            // Nothing to do, sleep until something is submitted
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCv.wait_for(lock, std::chrono::milliseconds(1), [] {
+                return queued.load(std::memory_order_relaxed) > 0 || !running.load(std::memory_order_relaxed);
+            });
+        }
+    }
+
+    // Arguments of one parallelFor call, shared by all its tasks
+    struct ParallelFor {
+        std::atomic<std::size_t> next;
+        std::size_t count;
+        std::size_t grain;
+        void (*fn)(const void *data, std::size_t i);
+        const void *data;
+    };
+
+    void runParallelFor(void *data) {
+        ParallelFor *job = static_cast<ParallelFor*>(data);
+        for (;;) {
+            std::size_t begin = job->next.fetch_add(job->grain, std::memory_order_relaxed);
+            if (begin >= job->count) {
+                break;
+            }
+            std::size_t end = std::min(begin + job->grain, job->count);
+            for (std::size_t i = begin; i < end; i++) {
+                job->fn(job->data, i);
+            }
+        }
+    }
+
+    void runFunction(void *data) {
+        (*static_cast<std::function<void()>*>(data))();
+    }
+}
+
+void Jobs::init(unsigned int count) {
+    if (running.load()) {
+        return;
+    }
+
+    if (count == 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        count = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    deques.clear();
+    for (unsigned int i = 0; i < count; i++) {
+        deques.emplace_back(new WorkDeque());
+    }
+
+    running.store(true, std::memory_order_release);
+    for (unsigned int i = 0; i < count; i++) {
+        workers.emplace_back(workerLoop, i);
+    }
+}
+
+void Jobs::shutdown() {
+    running.store(false, std::memory_order_release);
+    sleepCv.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    deques.clear();
+}
+
+unsigned int Jobs::workerCount() {
+    return (unsigned int)workers.size();
+}
+
+unsigned int Jobs::threadIndex() {
+    if (slot < 0) {
+        // First call from a thread that isn't a worker. Sharing a slot would race on its per thread state
+        unsigned int foreign = nextForeignSlot.fetch_add(1);
+        if (foreign >= FOREIGN_SLOTS) {
+            std::cout << "ERROR::JOBS::OUT_OF_FOREIGN_SLOTS " << FOREIGN_SLOTS << " threads that aren't workers already have one" << std::endl;
+            std::abort();
+        }
+        slot = (int)(deques.size() + foreign);
+    }
+    return (unsigned int)slot;
+}
+
+unsigned int Jobs::maxThreads() {
+    return (unsigned int)deques.size() + FOREIGN_SLOTS;
+}
+
+void Jobs::submit(Task *task) {
+    queued.fetch_add(1, std::memory_order_relaxed);
+
+    bool pushed = false;
+    if (slot >= 0 && (unsigned int)slot < deques.size()) {
+        pushed = deques[slot]->push(task);
+    }
+    if (!pushed) {
+        if (deques.empty()) {
+            // No workers, run it right here
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            execute(task);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(globalMutex);
+        globalQueue.push(task);
+    }
+
+    sleepCv.notify_one();
+}
+
+void Jobs::wait(const std::atomic<int> &counter) {
+    while (counter.load(std::memory_order_acquire) > 0) {
+        Task *task = findWork();
+        if (task) {
+            execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Jobs::parallelFor(std::size_t count, std::size_t grain, void (*fn)(const void *data, std::size_t i), const void *data) {
+    const unsigned int MAX_TASKS = 64;
+
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+
+    ParallelFor job;
+    job.next.store(0);
+    job.count = count;
+    job.grain = grain;
+    job.fn = fn;
+    job.data = data;
+
+    // One task per thread that can help, the caller is one of them
+    std::size_t chunks = (count + grain - 1) / grain;
+    unsigned int helpers = (unsigned int)std::min<std::size_t>({chunks, (std::size_t)workerCount() + 1, (std::size_t)MAX_TASKS});
+
+    std::atomic<int> remaining(0);
+    Task tasks[MAX_TASKS];
+    for (unsigned int i = 1; i < helpers; i++) {
+        tasks[i].fn = runParallelFor;
+        tasks[i].data = &job;
+        tasks[i].dependencies = 0;
+        tasks[i].pending.store(0);
+        tasks[i].remaining = &remaining;
+        remaining.fetch_add(1);
+        submit(&tasks[i]);
+    }
+
+    runParallelFor(&job);
+    wait(remaining);
+}
+
+Jobs::Graph::TaskId Jobs::Graph::add(std::function<void()> fn) {
+    functions.push_back(std::move(fn));
+    tasks.emplace_back();
+
+    Task &task = tasks.back();
+    task.fn = runFunction;
+    task.data = &functions.back();
+    task.dependencies = 0;
+    task.pending.store(0);
+    task.remaining = &remaining;
+    return tasks.size() - 1;
+}
+
+void Jobs::Graph::precede(TaskId before, TaskId after) {
+    tasks[before].successors.push_back(&tasks[after]);
+    tasks[after].dependencies++;
+}
+
+void Jobs::Graph::run() {
+    // Reset counters first so no task is released before everything is armed
+    remaining.store((int)tasks.size(), std::memory_order_relaxed);
+    for (Task &task : tasks) {
+        task.pending.store(task.dependencies, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (Task &task : tasks) {
+        if (task.dependencies == 0) {
+            submit(&task);
+        }
+    }
+
+    wait(remaining);
+}
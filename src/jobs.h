@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/**
+ * Work-stealing job system. Every worker owns a deque it pushes to and pops
+ * from at the bottom, idle workers steal from the top of the others. Threads
+ * that are not workers (the main and render threads) submit through a shared
+ * queue and help run jobs while they wait.
+ */
+
+namespace Jobs {
+    // A unit of work. Tasks are owned by a Graph and reused every time it runs
+    struct Task {
+        void (*fn)(void *data);
+        void *data;
+        std::atomic<int> pending;               // Predecessors that still have to finish
+        int dependencies;                       // Number of predecessors
+        std::vector<Task*> successors;
+        std::atomic<int> *remaining;            // Counter of the graph run this task belongs to
+    };
+
+    // Start the workers, 0 picks one per hardware thread minus the caller
+    extern void init(unsigned int workers = 0);
+    extern void shutdown();
+
+    // Number of worker threads
+    extern unsigned int workerCount();
+
+    // Slot of the calling thread in [0, maxThreads()), stable for the thread's lifetime
+    extern unsigned int threadIndex();
+    extern unsigned int maxThreads();
+
+    // Queue a task whose dependencies are satisfied
+    extern void submit(Task *task);
+
+    // Run other jobs until counter drops to zero
+    extern void wait(const std::atomic<int> &counter);
+
+    // Run fn(data, i) for every i in [0, count), split in chunks of grain, and wait for it
+    extern void parallelFor(std::size_t count, std::size_t grain, void (*fn)(const void *data, std::size_t i), const void *data);
+
+    // Same for any callable, called by reference so capturing lambdas don't go through the heap
+    template<typename F>
+    void parallelFor(std::size_t count, std::size_t grain, const F &fn) {
+        parallelFor(count, grain, [](const void *data, std::size_t i) {
+            (*static_cast<const F*>(data))(i);
+        }, &fn);
+    }
+
+    // A reusable task graph, build it once and run it every frame
+    class Graph
+    {
+        public:
+            typedef std::size_t TaskId;
+
+            // Add a task, returns the id used to express dependencies
+            TaskId add(std::function<void()> fn);
+
+            // before has to finish before after may start
+            void precede(TaskId before, TaskId after);
+
+            // Run every task respecting dependencies and return once all are done
+            void run();
+
+            std::size_t size() const { return tasks.size(); }
+
+        private:
+            std::deque<Task> tasks;             // deque so task addresses stay stable
+            std::deque<std::function<void()>> functions;
+            std::atomic<int> remaining{0};
+    };
+}
@@ -0,0 +1,340 @@
+#include "./lod.h"
+#include "./config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    bool onBounds(const glm::vec3 &p, const glm::vec3 &min, const glm::vec3 &max) {
+        for (int a = 0; a < 3; a++) {
+            if (p[a] <= min[a] || p[a] >= max[a]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Axis and side of the face of bounds all three corners lie in, -1 if none
+    int boundsPlane(const glm::vec3 *corners, const glm::vec3 &min, const glm::vec3 &max) {
+        for (int a = 0; a < 3; a++) {
+            if (corners[0][a] == min[a] && corners[1][a] == min[a] && corners[2][a] == min[a]) {
+                return a * 2;
+            }
+            if (corners[0][a] == max[a] && corners[1][a] == max[a] && corners[2][a] == max[a]) {
+                return a * 2 + 1;
+            }
+        }
+        return -1;
+    }
+}
+
+std::uint8_t Lod::select(float radius, float depth, float projectionScale, const float errors[LEVELS], bool impostor, std::uint8_t current) {
+    if (projectionScale <= 0.0f) {
+        return 0;
+    }
+    // Half the screen height is 1
+    float scale = projectionScale / std::max(depth, 0.001f);
+
+    if (impostor) {
+        float limit = current == IMPOSTOR ? Config::lodImpostor : Config::lodImpostor / HYSTERESIS;
+        if (radius * scale < limit) {
+            return IMPOSTOR;
+        }
+    }
+
+    std::uint8_t from = current == IMPOSTOR ? 0 : current;
+    for (int level = LEVELS - 1; level > 0; level--) {
+        if (errors[level] < 0.0f) {
+            continue;
+        }
+        float limit = level > from ? Config::lodError / HYSTERESIS : Config::lodError;
+        if (errors[level] * scale <= limit) {
+            return (std::uint8_t)level;
+        }
+    }
+    return 0;
+}
+
+void Lod::Simplifier::reset(const std::vector<glm::vec3> &positions, const std::vector<std::uint32_t> &indices, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax) {
+    position.clear();
+    quadric.clear();
+    locked.clear();
+    dead.clear();
+    version.clear();
+    face.clear();
+    removed.clear();
+    firstCorner.clear();
+    nextCorner.clear();
+    heap.clear();
+    liveFaces = 0;
+    largestError = 0.0f;
+
+    // Weld through an open addressing table of twice the input size
+    std::size_t cells = 1;
+    while (cells < positions.size() * 2) {
+        cells *= 2;
+    }
+    weld.assign(cells, -1);
+    auto vertexOf = [&](const glm::vec3 &p) {
+        std::uint32_t h = 2166136261u;
+        for (int a = 0; a < 3; a++) {
+            std::uint32_t bits;
+            float value = p[a] + 0.0f;      // No negative zero
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int byte = 0; byte < 4; byte++) {
+                h = (h ^ ((bits >> (byte * 8)) & 0xffu)) * 16777619u;
+            }
+        }
+        std::size_t cell = h & (cells - 1);
+        while (weld[cell] >= 0 && position[weld[cell]] != p) {
+            cell = (cell + 1) & (cells - 1);
+        }
+        if (weld[cell] < 0) {
+            weld[cell] = (int)position.size();
+            position.push_back(p);
+            locked.push_back(onBounds(p, boundsMin, boundsMax) ? 1 : 0);
+            dead.push_back(0);
+            version.push_back(0);
+            firstCorner.push_back(-1);
+            quadric.push_back(Quadric());
+        }
+        return (std::uint32_t)weld[cell];
+    };
+
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::uint32_t v[3];
+        for (int k = 0; k < 3; k++) {
+            v[k] = vertexOf(positions[indices[i + k]]);
+        }
+        if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) {
+            continue;
+        }
+
+        int f = (int)(face.size() / 3);
+        for (int k = 0; k < 3; k++) {
+            face.push_back(v[k]);
+            nextCorner.push_back(firstCorner[v[k]]);
+            firstCorner[v[k]] = f * 3 + k;
+        }
+        removed.push_back(0);
+        liveFaces++;
+
+        for (int k = 0; k < 3; k++) {
+            addPlane(quadric[v[k]], position[v[0]], position[v[1]], position[v[2]]);
+        }
+    }
+
+    // Walls lying flat in a face of bounds, where there was nothing to cull them against, may still
+    // be simplified inside: a vertex whose faces all lie in the same one and that is on no open edge
+    // can only slide across the wall without changing its outline
+    for (std::uint32_t v = 0; v < position.size(); v++) {
+        if (!locked[v]) {
+            continue;
+        }
+        int plane = -2;
+        bool inside = true;
+        for (int corner = firstCorner[v]; corner >= 0 && inside; corner = nextCorner[corner]) {
+            int f = corner / 3;
+            const glm::vec3 corners[3] = {position[face[f * 3]], position[face[f * 3 + 1]], position[face[f * 3 + 2]]};
+            int facePlane = boundsPlane(corners, boundsMin, boundsMax);
+            inside = facePlane >= 0 && (plane == -2 || facePlane == plane) &&
+                sharedEdge(v, face[f * 3 + (corner % 3 + 1) % 3]) && sharedEdge(v, face[f * 3 + (corner % 3 + 2) % 3]);
+            plane = facePlane;
+        }
+        locked[v] = inside && plane >= 0 ? 0 : 1;
+    }
+
+    // Each interior edge comes up from both its faces, the second entry is simply skipped as stale later
+    for (std::size_t f = 0; f < removed.size(); f++) {
+        for (int k = 0; k < 3; k++) {
+            pushEdge(face[f * 3 + k], face[f * 3 + (k + 1) % 3]);
+        }
+    }
+}
+
+// Do exactly two faces hold the edge
+bool Lod::Simplifier::sharedEdge(std::uint32_t a, std::uint32_t b) const {
+    int faces = 0;
+    for (int corner = firstCorner[a]; corner >= 0; corner = nextCorner[corner]) {
+        int f = corner / 3;
+        if (face[f * 3] == b || face[f * 3 + 1] == b || face[f * 3 + 2] == b) {
+            faces++;
+        }
+    }
+    return faces == 2;
+}
+
+void Lod::Simplifier::addPlane(Quadric &q, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+    glm::vec3 n = glm::cross(b - a, c - a);
+    float length = glm::length(n);
+    if (length <= 0.0f) {
+        return;
+    }
+    n /= length;
+    double p[4] = {n.x, n.y, n.z, -glm::dot(n, a)};
+    int i = 0;
+    for (int r = 0; r < 4; r++) {
+        for (int c2 = r; c2 < 4; c2++) {
+            q.a[i++] += p[r] * p[c2];
+        }
+    }
+}
+
+double Lod::Simplifier::error(const Quadric &q, const glm::vec3 &p) const {
+    double v[4] = {p.x, p.y, p.z, 1.0};
+    double sum = 0.0;
+    int i = 0;
+    for (int r = 0; r < 4; r++) {
+        for (int c = r; c < 4; c++) {
+            sum += q.a[i++] * v[r] * v[c] * (r == c ? 1.0 : 2.0);
+        }
+    }
+    return std::max(sum, 0.0);
+}
+
+void Lod::Simplifier::pushEdge(std::uint32_t a, std::uint32_t b) {
+    if (locked[a] && locked[b]) {
+        return;
+    }
+
+    Quadric q;
+    for (int i = 0; i < 10; i++) {
+        q.a[i] = quadric[a].a[i] + quadric[b].a[i];
+    }
+
+    // A locked end stays where it is, otherwise whichever of the ends and the middle costs least
+    Edge edge;
+    if (locked[a] || locked[b]) {
+        edge.keep = locked[a] ? a : b;
+        edge.remove = locked[a] ? b : a;
+        edge.target = position[edge.keep];
+        edge.cost = (float)error(q, edge.target);
+    } else {
+        const glm::vec3 candidates[3] = {position[a], position[b], (position[a] + position[b]) * 0.5f};
+        int best = 0;
+        double bestCost = error(q, candidates[0]);
+        for (int i = 1; i < 3; i++) {
+            double cost = error(q, candidates[i]);
+            if (cost < bestCost) {
+                best = i;
+                bestCost = cost;
+            }
+        }
+        edge.keep = best == 1 ? b : a;
+        edge.remove = best == 1 ? a : b;
+        edge.target = candidates[best];
+        edge.cost = (float)bestCost;
+    }
+    edge.keepVersion = version[edge.keep];
+    edge.removeVersion = version[edge.remove];
+
+    heap.push_back(edge);
+    std::push_heap(heap.begin(), heap.end(), [](const Edge &x, const Edge &y) { return x.cost > y.cost; });
+}
+
+// Would moving vertex to target turn any of its faces that don't also hold other upside down or flat
+bool Lod::Simplifier::flips(std::uint32_t vertex, std::uint32_t other, const glm::vec3 &target) const {
+    for (int corner = firstCorner[vertex]; corner >= 0; corner = nextCorner[corner]) {
+        int f = corner / 3;
+        if (removed[f]) {
+            continue;
+        }
+        std::uint32_t a = face[f * 3], b = face[f * 3 + 1], c = face[f * 3 + 2];
+        if (a == other || b == other || c == other) {
+            continue;
+        }
+
+        glm::vec3 before = glm::cross(position[b] - position[a], position[c] - position[a]);
+        glm::vec3 p[3] = {position[a], position[b], position[c]};
+        p[corner % 3] = target;
+        glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+        float afterLength = glm::length(after);
+        if (afterLength <= 1e-6f || glm::dot(before, after) < 0.2f * glm::length(before) * afterLength) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Lod::Simplifier::collapse(const Edge &edge) {
+    std::uint32_t keep = edge.keep, remove = edge.remove;
+    position[keep] = edge.target;
+    for (int i = 0; i < 10; i++) {
+        quadric[keep].a[i] += quadric[remove].a[i];
+    }
+
+    // Faces on the edge vanish, the others of remove move over to keep
+    for (int corner = firstCorner[remove]; corner >= 0; corner = nextCorner[corner]) {
+        int f = corner / 3;
+        if (removed[f]) {
+            continue;
+        }
+        if (face[f * 3] == keep || face[f * 3 + 1] == keep || face[f * 3 + 2] == keep) {
+            removed[f] = 1;
+            liveFaces--;
+        } else {
+            face[corner] = keep;
+        }
+    }
+
+    // Splice the lists, dropping corners of removed faces on the way
+    int merged = -1;
+    const std::uint32_t owners[2] = {keep, remove};
+    for (std::uint32_t owner : owners) {
+        int corner = firstCorner[owner];
+        while (corner >= 0) {
+            int next = nextCorner[corner];
+            if (!removed[corner / 3]) {
+                nextCorner[corner] = merged;
+                merged = corner;
+            }
+            corner = next;
+        }
+    }
+    firstCorner[keep] = merged;
+    firstCorner[remove] = -1;
+    dead[remove] = 1;
+    version[keep]++;
+    version[remove]++;
+
+    // Every edge around keep changed cost
+    for (int corner = firstCorner[keep]; corner >= 0; corner = nextCorner[corner]) {
+        int f = corner / 3;
+        pushEdge(keep, face[f * 3 + (corner % 3 + 1) % 3]);
+        pushEdge(keep, face[f * 3 + (corner % 3 + 2) % 3]);
+    }
+}
+
+float Lod::Simplifier::reduce(std::size_t targetTriangles, float maxError) {
+    auto order = [](const Edge &x, const Edge &y) { return x.cost > y.cost; };
+    double limit = (double)maxError * maxError;
+
+    while (liveFaces > targetTriangles && !heap.empty()) {
+        Edge edge = heap.front();
+        if (edge.cost > limit) {
+            break;
+        }
+        std::pop_heap(heap.begin(), heap.end(), order);
+        heap.pop_back();
+
+        bool stale = dead[edge.keep] || dead[edge.remove] || version[edge.keep] != edge.keepVersion || version[edge.remove] != edge.removeVersion;
+        if (stale || flips(edge.keep, edge.remove, edge.target) || flips(edge.remove, edge.keep, edge.target)) {
+            continue;
+        }
+        collapse(edge);
+        largestError = std::max(largestError, std::sqrt(edge.cost));
+    }
+    return largestError;
+}
+
+void Lod::Simplifier::triangles(std::vector<glm::vec3> &out) const {
+    out.clear();
+    for (std::size_t f = 0; f < removed.size(); f++) {
+        if (!removed[f]) {
+            out.push_back(position[face[f * 3]]);
+            out.push_back(position[face[f * 3 + 1]]);
+            out.push_back(position[face[f * 3 + 2]]);
+        }
+    }
+}
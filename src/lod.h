@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Level of detail. Meshes carry a chain of coarser copies made with quadric
+ * error metric edge collapse when they are built, each with the worst
+ * distance any of its collapses moved the surface. Every frame an object
+ * gets the coarsest level whose error projects below a fraction of the
+ * screen, and objects that project smaller than a cutoff are drawn as
+ * billboards from a prerendered atlas, all of them in one instanced draw.
+ * Switching to a coarser level needs a margin over switching back, so an
+ * object sitting near a threshold doesn't flicker between the two.
+ */
+
+namespace Lod {
+    const int LEVELS = 3;                   // Mesh levels, 0 is full detail
+    const std::uint8_t IMPOSTOR = 255;      // Level of an object drawn as a billboard
+    const float HYSTERESIS = 1.25f;         // How much further past a threshold a coarser level has to be
+
+    // Level for an object at depth in front of the camera. projectionScale is the projection's y scale,
+    // errors are each level's error in world units, negative where the mesh has no such level, and
+    // current is the level the object had last frame. Only objects with an impostor may get IMPOSTOR
+    extern std::uint8_t select(float radius, float depth, float projectionScale, const float errors[LEVELS], bool impostor, std::uint8_t current);
+
+    // Quadric error metric simplification of an indexed triangle mesh. Coincident positions are
+    // welded first, collapses only go to either end or the middle of an edge, and never move a
+    // vertex where the surface crosses the faces of bounds, so neighbouring meshes still meet.
+    // Keeps its storage between meshes
+    class Simplifier
+    {
+        public:
+            void reset(const std::vector<glm::vec3> &positions, const std::vector<std::uint32_t> &indices, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+
+            // Collapse the cheapest edges until at most targetTriangles remain or the next would move
+            // the surface by more than maxError. Returns the largest error so far
+            float reduce(std::size_t targetTriangles, float maxError);
+
+            std::size_t triangleCount() const { return liveFaces; }
+
+            // Corners of the remaining triangles, three per triangle
+            void triangles(std::vector<glm::vec3> &out) const;
+
+        private:
+            struct Quadric {
+                double a[10];       // Upper triangle of the symmetric 4x4 matrix
+            };
+
+            struct Edge {
+                float cost;
+                std::uint32_t keep, remove;
+                std::uint32_t keepVersion, removeVersion;
+                glm::vec3 target;
+            };
+
+            void addPlane(Quadric &q, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c);
+            double error(const Quadric &q, const glm::vec3 &p) const;
+            void pushEdge(std::uint32_t a, std::uint32_t b);
+            bool sharedEdge(std::uint32_t a, std::uint32_t b) const;
+            bool flips(std::uint32_t vertex, std::uint32_t other, const glm::vec3 &target) const;
+            void collapse(const Edge &edge);
+
+            std::vector<glm::vec3> position;
+            std::vector<Quadric> quadric;
+            std::vector<std::uint8_t> locked;
+            std::vector<std::uint8_t> dead;
+            std::vector<std::uint32_t> version;
+            std::vector<std::uint32_t> face;            // Three vertices per face
+            std::vector<std::uint8_t> removed;          // Per face
+            std::vector<int> firstCorner;               // Per vertex, corner = face * 3 + k
+            std::vector<int> nextCorner;                // Per corner, -1 ends the list
+            std::vector<int> weld;                      // Open addressing table used by reset
+            std::vector<Edge> heap;
+            std::size_t liveFaces = 0;
+            float largestError = 0.0f;
+    };
+}
@@ -7,108 +7,187 @@
 
 // local includes
 #include "./window.h"   // GLFW window code
-#include "./shader.h"   // Loading and compiling shader code
 #include "./camera.h"   // Camera object
-#include "./cube.h"     // Cube code
-#include "./texture.h"  // Texture loader
+#include "./jobs.h"     // Work-stealing job system
+#include "./scene.h"    // Scene instances
+#include "./simulation.h" // Per frame update, culling and recording
+#include "./renderthread.h" // Render thread and frame packets
+#include "./config.h"   // Command line options
+#include "./bench.h"    // Headless regression runs
+#include "./nullgl.h"   // GL stubs for CPU only runs
+#include "./alloctrack.h" // Heap allocation counting
+#include "./voxels.h"   // Chunked voxel terrain
+#include "./streaming.h" // Voxel terrain loaded around the camera
+#include "./occlusion.h" // CPU occlusion culling
+#include "./picking.h"  // Ray queries against the scene
+#include "./stats.h"    // Per frame counters
+
+#include <cmath>
+#include <iostream>
 
 //camera
 Camera camera = Camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
-//Cubes
-unsigned int cubeVAO, cubeVBO, lampVAO, lampVBO;
-
 //Lights position
 glm::vec3 lightPos = glm::vec3(1.2f,1.0f,2.0f);
+glm::vec3 sunDirection = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
+
+// Snapshot of the camera for interpolation on the render thread
+CameraState captureCamera() {
+    CameraState state;
+    state.position = camera.Position;
+    state.yaw = camera.Yaw;
+    state.pitch = camera.Pitch;
+    state.zoom = camera.Zoom;
+    return state;
+}
 
-int main()
+int main(int argc, char** argv)
 {
-    GLFWwindow* window = Window::init("Learn OpenGL");
-
-    // Init shaders
-    Shader lightingShader("../src/shaders/lightingShader.vs", "../src/shaders/lightingShader.fs"); 
-    Shader lampShader("../src/shaders/lampShader.vs", "../src/shaders/lampShader.fs");
-
-    // Create cubes
-    Cube::createCube(cubeVAO, cubeVBO, 0);
-    Cube::createCube(lampVAO, lampVBO, 0);
+    Config::parse(argc, argv);
+
+    // The CPU rasterizer only draws what the draw list holds, lit by the main light alone
+    if (Config::renderer == "soft") {
+        Config::gpuCulling = false;
+        if (Config::pointLights > 0 || Config::shadows || Config::sun > 0.0f || Config::voxelWorld > 0 || Config::streamRadius > 0) {
+            std::cout << "ERROR::RENDERER::SOFT_UNSUPPORTED point-lights, shadows, sun, voxel-world and stream-radius need a GPU renderer, turning them off" << std::endl;
+            Config::pointLights = 0;
+            Config::shadows = false;
+            Config::sun = 0.0f;
+            Config::voxelWorld = 0;
+            Config::streamRadius = 0;
+        }
+    }
+    if (Config::allocTrack || Config::allocCheck || Config::allocSample > 0) {
+        AllocTrack::enable(Config::allocSample);
+    }
 
-    // Bind Normals
-    Cube::bindNormals(cubeVAO, cubeVBO, 1);
+    // Regression runs render on this thread into a hidden window, or into no window at all under null GL, and exit
+    if (!Config::bench.empty() || Config::nullGL) {
+        GLFWwindow* window = nullptr;
+        if (Config::nullGL) {
+            NullGL::install();
+            if (Config::bench.empty()) {
+                Config::bench = "all";
+            }
+        } else {
+            window = Window::init("Learn OpenGL", false);
+        }
+        Jobs::init();
+        int failures = Bench::run(window);
+        AllocTrack::report();
+        Jobs::shutdown();
+        glfwTerminate();
+        return failures == 0 ? 0 : 1;
+    }
 
-    // Bind Textures
-    Cube::bindTexture(cubeVAO, cubeVBO, 2);
+    GLFWwindow* window = Window::init("Learn OpenGL");
 
-    // Load Textures
-    unsigned int texture = Texture::load("../assets/wall.jpg", GL_RGB, GL_REPEAT, GL_LINEAR);
+    // Start the job system
+    Jobs::init();
+
+    // Hand the context to the render thread, this thread keeps input and simulation
+    RenderThread::start(window);
+
+    // Populate scene
+    Scene::addStatic(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+    Scene::add(lightPos, glm::vec3(0.2f), Scene::LAMP);
+    Scene::addRandomLights(Config::pointLights, glm::vec3(-10.0f, -2.0f, -10.0f), glm::vec3(10.0f, 4.0f, 10.0f), 4.0f, 1);
+    if (Config::streamRadius > 0) {
+        Streaming::start(Config::streamRadius, (std::size_t)Config::streamBudget * 1024 * 1024, 1);
+    } else if (Config::voxelWorld > 0) {
+        int half = Config::voxelWorld / 2;
+        Voxels::build(glm::ivec3(-half, -1, -half), glm::ivec3(Config::voxelWorld - half, 1, Config::voxelWorld - half), 1);
+    }
 
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    // Build the per frame task graph
+    Simulation::init();
 
     // setup game loop
+    CameraState previousCamera = captureCamera();
+    double accumulator = 0.0;
+    double inputTime = 0.0;
     while (!glfwWindowShouldClose(window))
     {
         // update Delta time
         Window::updateDeltaTime();
+        accumulator += Window::deltaTime;
 
         // process inputs
-        Window::processInput(window);
-
-        // clear
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Draw cube ---------------------------------------
-        
-        // Set shader
-        lightingShader.use();
-        lightingShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
-        lightingShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-
-        // Set texture
-        Texture::activate(GL_TEXTURE0, texture);
-        lightingShader.setInt("texture", 0);
-
-        // Setup camera
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)Window::SCR_WIDTH / (float)Window::SCR_HEIGHT, 0.1f, 100.0f);
-        lightingShader.setMat4("projection", projection);
-        glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("view", view);
-
-        // Setup Cube
-        glBindVertexArray(cubeVAO);
-        glm::vec3 pos = glm::vec3(0.0f, 0.0f, 0.0f);
-        glm::mat4 model;
-        model = glm::translate(model, pos);
-        lightingShader.setMat4("model", model);
-        lightingShader.setVec3("lightPos", lightPos);
-        lightingShader.setVec3("viewPos", camera.Position);
-
-        // Draw Shape
-        glDrawArrays(GL_TRIANGLES, 0, Cube::vertCount);
-
-        // Draw lamp -------------------------------------
-        
-        // Set shader
-        lampShader.use();
-        lampShader.setMat4("projection", projection);
-        lampShader.setMat4("view", view);
-
-        // Setup Lamp
-        glBindVertexArray(lampVAO);
-        pos = lightPos;
-        model = glm::translate(glm::mat4(), pos);
-        model = glm::scale(model, glm::vec3(0.2f));
-        lampShader.setMat4("model", model);
-
-        // Draw Shape
-        glDrawArrays(GL_TRIANGLES, 0, Cube::vertCount);
-
-        // swap buffers
-        glfwSwapBuffers(window);
         glfwPollEvents();
+
+        // Step the simulation at a fixed rate, whatever the frame rate is
+        float stepLength = 1.0f / Config::simulationRate;
+        int steps = 0;
+        while (accumulator >= stepLength && steps < Config::maxSimulationSteps) {
+            previousCamera = captureCamera();
+            Scene::saveState();
+            Input::Summary input = Window::processInput(window, stepLength);
+            if (input.count > 0 && inputTime == 0.0) {
+                inputTime = input.firstTime;
+            }
+
+            accumulator -= stepLength;
+            steps++;
+        }
+
+        // Too far behind to catch up, drop the whole steps we couldn't afford
+        if (accumulator >= stepLength) {
+            accumulator = std::fmod(accumulator, (double)stepLength);
+        }
+
+        // Nothing new to show, wait for input or the next step
+        if (steps == 0) {
+            glfwWaitEventsTimeout(stepLength - accumulator);
+            continue;
+        }
+
+        // Counted as the simulation's allocations for the frame
+        {
+            AllocTrack::Scope scope("alloc_simulation");
+
+            // Chunks around where the camera ended up, before recording sees the scene
+            Streaming::update(camera.Position, camera.Front);
+
+            // Record draw lists in parallel
+            CameraState current = captureCamera();
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)Window::SCR_WIDTH / (float)Window::SCR_HEIGHT, 0.1f, 100.0f);
+            const std::vector<DrawCommand> &commands = Simulation::record(projection * camera.GetViewMatrix());
+
+            // The cube under the crosshair, shown with --stats
+            Bvh::Hit hit;
+            bool picked = Picking::pick(camera.Position, camera.Front, 100.0f, hit);
+            Stats::set("pick_instance", picked ? (double)hit.object : -1.0);
+            Stats::set("pick_distance", picked ? (double)hit.distance : 0.0);
+
+            // Hand the frame to the render thread
+            FramePacket &packet = RenderThread::packet();
+            packet.previousCamera = previousCamera;
+            packet.camera = current;
+            packet.stepTime = Window::lastFrame - accumulator;
+            packet.stepLength = stepLength;
+            packet.inputTime = inputTime;
+            packet.streamFrame = Streaming::frame();
+            packet.lightPos = lightPos;
+            packet.lightColor = glm::vec3(1.0f, 1.0f, 1.0f);
+            packet.sunDirection = sunDirection;
+            packet.sunColor = glm::vec3(Config::sun);
+            packet.commands = commands;
+            packet.lights = Scene::lights;
+            packet.casters = DrawList::casters();
+            if (Config::gpuCulling && Config::occlusion) {
+                Occlusion::copyPyramid(packet.occlusionDepth, packet.occlusionViewProjection);
+            }
+            RenderThread::publish();
+        }
+        inputTime = 0.0;
+        AllocTrack::endFrame();
     }
 
+    RenderThread::stop();
+    Streaming::stop();
+    AllocTrack::report();
+    Jobs::shutdown();
     glfwTerminate();
     return 0;
 }
@@ -0,0 +1,412 @@
+#include "./nullgl.h"
+#include "./glfunctions.h"
+#include "./gl43.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Only the context thread calls GL, so plain counters are enough. The GL 4.3 entry points
+    // are counted after the ones glad loads
+    const int FUNCTION_COUNT = GL_FUNCTION_COUNT + GL43_FUNCTION_COUNT;
+    std::uint64_t callCounts[FUNCTION_COUNT];
+    std::uint64_t byteCounts[FUNCTION_COUNT];
+    bool active = false;
+
+    GLuint nextName = 1;
+    GLuint pixelPackBuffer = 0, pixelUnpackBuffer = 0;
+    std::vector<unsigned char> mapped;     // Memory handed out by glMapBufferRange
+
+    void count(int id, std::uint64_t size = 0) {
+        callCounts[id]++;
+        byteCounts[id] += size;
+    }
+
+    // Catch-all: count and return a zero value
+    template<int Id, typename F> struct Stub;
+
+    template<int Id, typename R, typename... Args>
+    struct Stub<Id, R (APIENTRY *)(Args...)> {
+        static R APIENTRY call(Args...) {
+            count(Id);
+            return R();
+        }
+    };
+
+    // Names for every Gen* entry point
+    void generate(GLsizei n, GLuint *names) {
+        for (GLsizei i = 0; i < n; i++) {
+            names[i] = nextName++;
+        }
+    }
+
+    // Queries the loader and the engine make, everything else reads as 0
+    GLint64 integer(GLenum pname) {
+        switch (pname) {
+            case GL_NUM_EXTENSIONS: return 1;     // glad treats an empty list as a failed load
+            case GL_MAJOR_VERSION: return 4;
+            case GL_MINOR_VERSION: return 3;
+            case GL_MAX_TEXTURE_SIZE: return 16384;
+            case GL_MAX_COLOR_ATTACHMENTS: return 8;
+            case GL_MAX_DRAW_BUFFERS: return 8;
+            case GL_MAX_SAMPLES: return 8;
+            case GL_MAX_TEXTURE_IMAGE_UNITS: return 16;
+            case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: return 32;
+            case GL_MAX_VERTEX_ATTRIBS: return 16;
+            case GL_MAX_UNIFORM_BLOCK_SIZE: return 65536;
+            case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: return 256;
+            case GL_TIMESTAMP:
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        return 0;
+    }
+
+    const GLubyte* APIENTRY getString(GLenum name) {
+        count(GL_ID_glGetString);
+        const char *value = "";
+        switch (name) {
+            case GL_VERSION: value = "4.3 NullGL"; break;
+            case GL_VENDOR: value = "NullGL"; break;
+            case GL_RENDERER: value = "NullGL"; break;
+            case GL_SHADING_LANGUAGE_VERSION: value = "4.30"; break;
+        }
+        return reinterpret_cast<const GLubyte*>(value);
+    }
+
+    const GLubyte* APIENTRY getStringi(GLenum, GLuint) {
+        count(GL_ID_glGetStringi);
+        return reinterpret_cast<const GLubyte*>("");
+    }
+
+    void APIENTRY getIntegerv(GLenum pname, GLint *data) {
+        count(GL_ID_glGetIntegerv);
+        *data = (GLint)integer(pname);
+    }
+
+    void APIENTRY getInteger64v(GLenum pname, GLint64 *data) {
+        count(GL_ID_glGetInteger64v);
+        *data = integer(pname);
+    }
+
+    void APIENTRY getFloatv(GLenum pname, GLfloat *data) {
+        count(GL_ID_glGetFloatv);
+        *data = (GLfloat)integer(pname);
+    }
+
+    void APIENTRY getBooleanv(GLenum pname, GLboolean *data) {
+        count(GL_ID_glGetBooleanv);
+        *data = integer(pname) != 0 ? GL_TRUE : GL_FALSE;
+    }
+
+    GLenum APIENTRY getError() {
+        count(GL_ID_glGetError);
+        return GL_NO_ERROR;
+    }
+
+    // Object names
+    void APIENTRY genBuffers(GLsizei n, GLuint *names) { count(GL_ID_glGenBuffers); generate(n, names); }
+    void APIENTRY genTextures(GLsizei n, GLuint *names) { count(GL_ID_glGenTextures); generate(n, names); }
+    void APIENTRY genVertexArrays(GLsizei n, GLuint *names) { count(GL_ID_glGenVertexArrays); generate(n, names); }
+    void APIENTRY genFramebuffers(GLsizei n, GLuint *names) { count(GL_ID_glGenFramebuffers); generate(n, names); }
+    void APIENTRY genRenderbuffers(GLsizei n, GLuint *names) { count(GL_ID_glGenRenderbuffers); generate(n, names); }
+    void APIENTRY genQueries(GLsizei n, GLuint *names) { count(GL_ID_glGenQueries); generate(n, names); }
+    void APIENTRY genSamplers(GLsizei n, GLuint *names) { count(GL_ID_glGenSamplers); generate(n, names); }
+    GLuint APIENTRY createShader(GLenum) { count(GL_ID_glCreateShader); return nextName++; }
+    GLuint APIENTRY createProgram() { count(GL_ID_glCreateProgram); return nextName++; }
+
+    // Shaders always compile and link
+    void APIENTRY getShaderiv(GLuint, GLenum pname, GLint *params) {
+        count(GL_ID_glGetShaderiv);
+        *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+    }
+
+    void APIENTRY getProgramiv(GLuint, GLenum pname, GLint *params) {
+        count(GL_ID_glGetProgramiv);
+        *params = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+    }
+
+    void APIENTRY getShaderInfoLog(GLuint, GLsizei size, GLsizei *length, GLchar *log) {
+        count(GL_ID_glGetShaderInfoLog);
+        if (length) *length = 0;
+        if (log && size > 0) log[0] = '\0';
+    }
+
+    void APIENTRY getProgramInfoLog(GLuint, GLsizei size, GLsizei *length, GLchar *log) {
+        count(GL_ID_glGetProgramInfoLog);
+        if (length) *length = 0;
+        if (log && size > 0) log[0] = '\0';
+    }
+
+    void APIENTRY shaderSource(GLuint, GLsizei n, const GLchar *const *strings, const GLint *lengths) {
+        std::uint64_t size = 0;
+        for (GLsizei i = 0; i < n; i++) {
+            size += (lengths && lengths[i] >= 0) ? lengths[i] : std::strlen(strings[i]);
+        }
+        count(GL_ID_glShaderSource, size);
+    }
+
+    GLenum APIENTRY checkFramebufferStatus(GLenum) {
+        count(GL_ID_glCheckFramebufferStatus);
+        return GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    // Fences are signalled the moment they're created
+    GLsync APIENTRY fenceSync(GLenum, GLbitfield) {
+        count(GL_ID_glFenceSync);
+        return reinterpret_cast<GLsync>((std::uintptr_t)nextName++);
+    }
+
+    GLenum APIENTRY clientWaitSync(GLsync, GLbitfield, GLuint64) {
+        count(GL_ID_glClientWaitSync);
+        return GL_ALREADY_SIGNALED;
+    }
+
+    void APIENTRY getSynciv(GLsync, GLenum pname, GLsizei, GLsizei *length, GLint *values) {
+        count(GL_ID_glGetSynciv);
+        if (length) *length = 1;
+        *values = pname == GL_SYNC_STATUS ? GL_SIGNALED : 0;
+    }
+
+    // Queries are available at once and measured nothing
+    void APIENTRY getQueryObjectiv(GLuint, GLenum pname, GLint *params) {
+        count(GL_ID_glGetQueryObjectiv);
+        *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+    }
+
+    void APIENTRY getQueryObjectuiv(GLuint, GLenum pname, GLuint *params) {
+        count(GL_ID_glGetQueryObjectuiv);
+        *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+    }
+
+    void APIENTRY getQueryObjecti64v(GLuint, GLenum pname, GLint64 *params) {
+        count(GL_ID_glGetQueryObjecti64v);
+        *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+    }
+
+    void APIENTRY getQueryObjectui64v(GLuint, GLenum pname, GLuint64 *params) {
+        count(GL_ID_glGetQueryObjectui64v);
+        *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+    }
+
+    // Uploads
+    void APIENTRY bindBuffer(GLenum target, GLuint buffer) {
+        count(GL_ID_glBindBuffer);
+        if (target == GL_PIXEL_PACK_BUFFER) pixelPackBuffer = buffer;
+        if (target == GL_PIXEL_UNPACK_BUFFER) pixelUnpackBuffer = buffer;
+    }
+
+    void APIENTRY bufferData(GLenum, GLsizeiptr size, const void *data, GLenum) {
+        count(GL_ID_glBufferData, data ? size : 0);
+    }
+
+    void APIENTRY bufferSubData(GLenum, GLintptr, GLsizeiptr size, const void *) {
+        count(GL_ID_glBufferSubData, size);
+    }
+
+    void* APIENTRY mapBufferRange(GLenum, GLintptr, GLsizeiptr length, GLbitfield access) {
+        count(GL_ID_glMapBufferRange, (access & GL_MAP_WRITE_BIT) ? length : 0);
+        if (mapped.size() < (std::size_t)length) {
+            mapped.resize(length);
+        }
+        return mapped.data();
+    }
+
+    GLboolean APIENTRY unmapBuffer(GLenum) {
+        count(GL_ID_glUnmapBuffer);
+        return GL_TRUE;
+    }
+
+    // Pixel data from a bound unpack buffer is already on the GPU and not counted
+    std::uint64_t pixels(GLsizei w, GLsizei h, GLsizei d, GLenum format, GLenum type, const void *data) {
+        return (data && !pixelUnpackBuffer) ? (std::uint64_t)w * h * d * glPixelSize(format, type) : 0;
+    }
+
+    void APIENTRY texImage2D(GLenum, GLint, GLint, GLsizei w, GLsizei h, GLint, GLenum format, GLenum type, const void *data) {
+        count(GL_ID_glTexImage2D, pixels(w, h, 1, format, type, data));
+    }
+
+    void APIENTRY texSubImage2D(GLenum, GLint, GLint, GLint, GLsizei w, GLsizei h, GLenum format, GLenum type, const void *data) {
+        count(GL_ID_glTexSubImage2D, pixels(w, h, 1, format, type, data));
+    }
+
+    void APIENTRY texImage3D(GLenum, GLint, GLint, GLsizei w, GLsizei h, GLsizei d, GLint, GLenum format, GLenum type, const void *data) {
+        count(GL_ID_glTexImage3D, pixels(w, h, d, format, type, data));
+    }
+
+    void APIENTRY texSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei w, GLsizei h, GLsizei d, GLenum format, GLenum type, const void *data) {
+        count(GL_ID_glTexSubImage3D, pixels(w, h, d, format, type, data));
+    }
+
+    // Readbacks into client memory get zeros, into a pack buffer nothing
+    void APIENTRY readPixels(GLint, GLint, GLsizei w, GLsizei h, GLenum format, GLenum type, void *data) {
+        std::uint64_t size = (std::uint64_t)w * h * glPixelSize(format, type);
+        count(GL_ID_glReadPixels, size);
+        if (!pixelPackBuffer && data) {
+            std::memset(data, 0, size);
+        }
+    }
+
+    // Uniforms count the bytes they set
+    void APIENTRY uniform1i(GLint, GLint) { count(GL_ID_glUniform1i, 4); }
+    void APIENTRY uniform1f(GLint, GLfloat) { count(GL_ID_glUniform1f, 4); }
+    void APIENTRY uniform2f(GLint, GLfloat, GLfloat) { count(GL_ID_glUniform2f, 8); }
+    void APIENTRY uniform3f(GLint, GLfloat, GLfloat, GLfloat) { count(GL_ID_glUniform3f, 12); }
+    void APIENTRY uniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { count(GL_ID_glUniform4f, 16); }
+    void APIENTRY uniform1fv(GLint, GLsizei n, const GLfloat *) { count(GL_ID_glUniform1fv, n * 4); }
+    void APIENTRY uniform2fv(GLint, GLsizei n, const GLfloat *) { count(GL_ID_glUniform2fv, n * 8); }
+    void APIENTRY uniform3fv(GLint, GLsizei n, const GLfloat *) { count(GL_ID_glUniform3fv, n * 12); }
+    void APIENTRY uniform4fv(GLint, GLsizei n, const GLfloat *) { count(GL_ID_glUniform4fv, n * 16); }
+    void APIENTRY uniform1iv(GLint, GLsizei n, const GLint *) { count(GL_ID_glUniform1iv, n * 4); }
+    void APIENTRY uniformMatrix3fv(GLint, GLsizei n, GLboolean, const GLfloat *) { count(GL_ID_glUniformMatrix3fv, n * 36); }
+    void APIENTRY uniformMatrix4fv(GLint, GLsizei n, GLboolean, const GLfloat *) { count(GL_ID_glUniformMatrix4fv, n * 64); }
+
+    struct Entry {
+        const char *name;
+        void *proc;
+    };
+
+    // Forces fn to have exactly the type of the entry point it replaces
+    template<typename F>
+    void* entry(F fn) {
+        return reinterpret_cast<void*>(fn);
+    }
+
+    const Entry SPECIAL[] = {
+        {"glGetString", entry<PFNGLGETSTRINGPROC>(getString)},
+        {"glGetStringi", entry<PFNGLGETSTRINGIPROC>(getStringi)},
+        {"glGetIntegerv", entry<PFNGLGETINTEGERVPROC>(getIntegerv)},
+        {"glGetInteger64v", entry<PFNGLGETINTEGER64VPROC>(getInteger64v)},
+        {"glGetFloatv", entry<PFNGLGETFLOATVPROC>(getFloatv)},
+        {"glGetBooleanv", entry<PFNGLGETBOOLEANVPROC>(getBooleanv)},
+        {"glGetError", entry<PFNGLGETERRORPROC>(getError)},
+        {"glGenBuffers", entry<PFNGLGENBUFFERSPROC>(genBuffers)},
+        {"glGenTextures", entry<PFNGLGENTEXTURESPROC>(genTextures)},
+        {"glGenVertexArrays", entry<PFNGLGENVERTEXARRAYSPROC>(genVertexArrays)},
+        {"glGenFramebuffers", entry<PFNGLGENFRAMEBUFFERSPROC>(genFramebuffers)},
+        {"glGenRenderbuffers", entry<PFNGLGENRENDERBUFFERSPROC>(genRenderbuffers)},
+        {"glGenQueries", entry<PFNGLGENQUERIESPROC>(genQueries)},
+        {"glGenSamplers", entry<PFNGLGENSAMPLERSPROC>(genSamplers)},
+        {"glCreateShader", entry<PFNGLCREATESHADERPROC>(createShader)},
+        {"glCreateProgram", entry<PFNGLCREATEPROGRAMPROC>(createProgram)},
+        {"glGetShaderiv", entry<PFNGLGETSHADERIVPROC>(getShaderiv)},
+        {"glGetProgramiv", entry<PFNGLGETPROGRAMIVPROC>(getProgramiv)},
+        {"glGetShaderInfoLog", entry<PFNGLGETSHADERINFOLOGPROC>(getShaderInfoLog)},
+        {"glGetProgramInfoLog", entry<PFNGLGETPROGRAMINFOLOGPROC>(getProgramInfoLog)},
+        {"glShaderSource", entry<PFNGLSHADERSOURCEPROC>(shaderSource)},
+        {"glCheckFramebufferStatus", entry<PFNGLCHECKFRAMEBUFFERSTATUSPROC>(checkFramebufferStatus)},
+        {"glFenceSync", entry<PFNGLFENCESYNCPROC>(fenceSync)},
+        {"glClientWaitSync", entry<PFNGLCLIENTWAITSYNCPROC>(clientWaitSync)},
+        {"glGetSynciv", entry<PFNGLGETSYNCIVPROC>(getSynciv)},
+        {"glGetQueryObjectiv", entry<PFNGLGETQUERYOBJECTIVPROC>(getQueryObjectiv)},
+        {"glGetQueryObjectuiv", entry<PFNGLGETQUERYOBJECTUIVPROC>(getQueryObjectuiv)},
+        {"glGetQueryObjecti64v", entry<PFNGLGETQUERYOBJECTI64VPROC>(getQueryObjecti64v)},
+        {"glGetQueryObjectui64v", entry<PFNGLGETQUERYOBJECTUI64VPROC>(getQueryObjectui64v)},
+        {"glBindBuffer", entry<PFNGLBINDBUFFERPROC>(bindBuffer)},
+        {"glBufferData", entry<PFNGLBUFFERDATAPROC>(bufferData)},
+        {"glBufferSubData", entry<PFNGLBUFFERSUBDATAPROC>(bufferSubData)},
+        {"glMapBufferRange", entry<PFNGLMAPBUFFERRANGEPROC>(mapBufferRange)},
+        {"glUnmapBuffer", entry<PFNGLUNMAPBUFFERPROC>(unmapBuffer)},
+        {"glTexImage2D", entry<PFNGLTEXIMAGE2DPROC>(texImage2D)},
+        {"glTexSubImage2D", entry<PFNGLTEXSUBIMAGE2DPROC>(texSubImage2D)},
+        {"glTexImage3D", entry<PFNGLTEXIMAGE3DPROC>(texImage3D)},
+        {"glTexSubImage3D", entry<PFNGLTEXSUBIMAGE3DPROC>(texSubImage3D)},
+        {"glReadPixels", entry<PFNGLREADPIXELSPROC>(readPixels)},
+        {"glUniform1i", entry<PFNGLUNIFORM1IPROC>(uniform1i)},
+        {"glUniform1f", entry<PFNGLUNIFORM1FPROC>(uniform1f)},
+        {"glUniform2f", entry<PFNGLUNIFORM2FPROC>(uniform2f)},
+        {"glUniform3f", entry<PFNGLUNIFORM3FPROC>(uniform3f)},
+        {"glUniform4f", entry<PFNGLUNIFORM4FPROC>(uniform4f)},
+        {"glUniform1fv", entry<PFNGLUNIFORM1FVPROC>(uniform1fv)},
+        {"glUniform2fv", entry<PFNGLUNIFORM2FVPROC>(uniform2fv)},
+        {"glUniform3fv", entry<PFNGLUNIFORM3FVPROC>(uniform3fv)},
+        {"glUniform4fv", entry<PFNGLUNIFORM4FVPROC>(uniform4fv)},
+        {"glUniform1iv", entry<PFNGLUNIFORM1IVPROC>(uniform1iv)},
+        {"glUniformMatrix3fv", entry<PFNGLUNIFORMMATRIX3FVPROC>(uniformMatrix3fv)},
+        {"glUniformMatrix4fv", entry<PFNGLUNIFORMMATRIX4FVPROC>(uniformMatrix4fv)}
+    };
+
+#define NULLGL_STUB(name, type) {#name, entry<type>(&Stub<GL_ID_##name, type>::call)},
+    const Entry GENERIC[] = {
+        GL_FUNCTIONS(NULLGL_STUB)
+    };
+#undef NULLGL_STUB
+
+#define NULLGL_STUB43(name, type) {#name, entry<type>(&Stub<GL_FUNCTION_COUNT + GL43_ID_##name, type>::call)},
+    const Entry GENERIC43[] = {
+        GL43_FUNCTIONS(NULLGL_STUB43)
+    };
+#undef NULLGL_STUB43
+
+    // Stands in for glfwGetProcAddress
+    void* getProcAddress(const char *name) {
+        for (const Entry &e : SPECIAL) {
+            if (std::strcmp(e.name, name) == 0) {
+                return e.proc;
+            }
+        }
+        for (const Entry &e : GENERIC) {
+            if (std::strcmp(e.name, name) == 0) {
+                return e.proc;
+            }
+        }
+        for (const Entry &e : GENERIC43) {
+            if (std::strcmp(e.name, name) == 0) {
+                return e.proc;
+            }
+        }
+        return nullptr;
+    }
+}
+
+void NullGL::install() {
+    if (!gladLoadGLLoader((GLADloadproc)getProcAddress)) {
+        throw new std::runtime_error("Failed to install the null GL backend");
+    }
+    GL43::load(getProcAddress);
+    active = true;
+    NullGL::reset();
+}
+
+bool NullGL::installed() {
+    return active;
+}
+
+std::uint64_t NullGL::calls() {
+    std::uint64_t total = 0;
+    for (int i = 0; i < FUNCTION_COUNT; i++) {
+        total += callCounts[i];
+    }
+    return total;
+}
+
+std::uint64_t NullGL::bytes() {
+    std::uint64_t total = 0;
+    for (int i = 0; i < FUNCTION_COUNT; i++) {
+        total += byteCounts[i];
+    }
+    return total;
+}
+
+void NullGL::reset() {
+    std::fill(callCounts, callCounts + FUNCTION_COUNT, 0);
+    std::fill(byteCounts, byteCounts + FUNCTION_COUNT, 0);
+}
+
+void NullGL::report() {
+    std::vector<int> used;
+    for (int i = 0; i < FUNCTION_COUNT; i++) {
+        if (callCounts[i] > 0) {
+            used.push_back(i);
+        }
+    }
+    std::sort(used.begin(), used.end(), [](int a, int b) { return callCounts[a] > callCounts[b]; });
+
+    for (int i : used) {
+        const char *name = i < GL_FUNCTION_COUNT ? GL_FUNCTION_NAMES[i] : GL43_FUNCTION_NAMES[i - GL_FUNCTION_COUNT];
+        std::cout << "NULLGL::" << name << " calls=" << callCounts[i] << " bytes=" << byteCounts[i] << std::endl;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Null GL backend. Every glad entry point, and the GL 4.3 ones of gl43.h, is
+ * pointed at a stub that does nothing but count the call and the bytes it
+ * would have moved, so the engine's own CPU cost can be measured without a
+ * context or a driver. Calls that hand data back (names, statuses, mapped
+ * memory) get plausible answers so the engine runs its normal paths.
+ */
+
+namespace NullGL {
+    // Load the stubs into glad instead of the driver. No context is needed
+    extern void install();
+    extern bool installed();
+
+    // Totals since install or the last reset
+    extern std::uint64_t calls();
+    extern std::uint64_t bytes();
+    extern void reset();
+
+    // Print calls and bytes per entry point, busiest first
+    extern void report();
+}
@@ -0,0 +1,331 @@
+#include "./occlusion.h"
+#include "./scene.h"
+#include "./simd.h"
+#include "./stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using Simd::Float4;
+
+namespace {
+    const float NEAR_W = 0.1f;      // Clip w of the near plane, anything closer can't be projected
+
+    // Unit cube corners are (i & 1, i >> 1 & 1, i >> 2 & 1) - 0.5, faces wound counter-clockwise seen from outside
+    const int CUBE_FACES[6][4] = {
+        {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}
+    };
+
+    // A front facing occluder triangle in depth buffer texels
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];     // Edge functions a * x + b * y + c, all at least 0 inside
+        float depthA, depthB, depthC;           // Depth plane a * x + b * y + c
+        int minX, minY, maxX, maxY;             // Texel bounds, max exclusive
+    };
+
+    struct Candidate {
+        float size;         // Radius over distance, how much of the screen it may cover
+        std::uint32_t instance;
+    };
+
+    glm::mat4 viewProjection;
+    Frustum frustum;
+    std::vector<Candidate> candidates;
+    std::vector<std::uint32_t> residentOccluders;  // Fixed, the rest of Scene::resident is never looked at
+    std::vector<Triangle> triangles;
+    std::size_t occluders = 0;
+
+    // Level 0 of nearest is what the occluders are rasterized into
+    std::vector<float> nearest[Occlusion::LEVELS];
+    std::vector<float> furthest[Occlusion::LEVELS];
+    std::vector<float> rowMax;
+
+    std::chrono::steady_clock::time_point started;
+    double milliseconds = 0.0;
+    std::atomic<std::size_t> hidden(0);
+
+    int levelWidth(int level) {
+        return std::max(Occlusion::WIDTH >> level, 1);
+    }
+
+    int levelHeight(int level) {
+        return std::max(Occlusion::HEIGHT >> level, 1);
+    }
+
+    // Screen position in texels and depth from 0 to 1, false when the point is too close to project
+    bool project(const glm::vec4 &clip, glm::vec3 &out) {
+        if (clip.w <= NEAR_W) {
+            return false;
+        }
+        float invW = 1.0f / clip.w;
+        out = glm::vec3((clip.x * invW * 0.5f + 0.5f) * Occlusion::WIDTH, (clip.y * invW * 0.5f + 0.5f) * Occlusion::HEIGHT, clip.z * invW * 0.5f + 0.5f);
+        return true;
+    }
+
+    // Counter-clockwise triangles only, the back faces of a box are covered by its front ones
+    void setup(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2) {
+        float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+        if (!(area > 0.0f)) {
+            return;
+        }
+
+        Triangle t;
+        const glm::vec3 *p[3] = {&p0, &p1, &p2};
+        for (int i = 0; i < 3; i++) {
+            const glm::vec3 &from = *p[i];
+            const glm::vec3 &to = *p[(i + 1) % 3];
+            t.edgeA[i] = from.y - to.y;
+            t.edgeB[i] = to.x - from.x;
+            t.edgeC[i] = (to.y - from.y) * from.x - (to.x - from.x) * from.y;
+        }
+        t.depthA = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) / area;
+        t.depthB = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) / area;
+        t.depthC = p0.z - t.depthA * p0.x - t.depthB * p0.y;
+
+        // Texel centres sit at half integers
+        t.minX = std::max(0, (int)std::floor(std::min({p0.x, p1.x, p2.x}) - 0.5f));
+        t.minY = std::max(0, (int)std::floor(std::min({p0.y, p1.y, p2.y}) - 0.5f));
+        t.maxX = std::min(Occlusion::WIDTH, (int)std::ceil(std::max({p0.x, p1.x, p2.x}) + 0.5f));
+        t.maxY = std::min(Occlusion::HEIGHT, (int)std::ceil(std::max({p0.y, p1.y, p2.y}) + 0.5f));
+        if (t.minX < t.maxX && t.minY < t.maxY) {
+            triangles.push_back(t);
+        }
+    }
+
+    // Is any part of the texel's area at this level, within the box's texels, nearer than what covers it
+    bool visibleIn(int level, int x, int y, int x0, int y0, int x1, int y1, float depth) {
+        std::size_t i = (std::size_t)y * levelWidth(level) + x;
+        if (depth > furthest[level][i]) {
+            return false;
+        }
+        if (level == 0 || depth <= nearest[level][i]) {
+            return true;
+        }
+
+        int finer = level - 1;
+        for (int cy = y * 2; cy <= std::min(y * 2 + 1, levelHeight(finer) - 1); cy++) {
+            for (int cx = x * 2; cx <= std::min(x * 2 + 1, levelWidth(finer) - 1); cx++) {
+                bool inside = cx >= (x0 >> finer) && cx <= (x1 >> finer) && cy >= (y0 >> finer) && cy <= (y1 >> finer);
+                if (inside && visibleIn(finer, cx, cy, x0, y0, x1, y1, depth)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+}
+
+void Occlusion::init() {
+    // The largest resident cubes, whatever the view. Scanning them all per frame is what residency avoids
+    residentOccluders.clear();
+    for (std::size_t i = 0; i < Scene::resident.size(); i++) {
+        residentOccluders.push_back((std::uint32_t)i);
+    }
+    if (residentOccluders.size() > (std::size_t)RESIDENT_OCCLUDERS) {
+        std::nth_element(residentOccluders.begin(), residentOccluders.begin() + RESIDENT_OCCLUDERS, residentOccluders.end(), [](std::uint32_t a, std::uint32_t b) {
+            float sizeA = Scene::resident[a].radius, sizeB = Scene::resident[b].radius;
+            return sizeA > sizeB || (sizeA == sizeB && a < b);
+        });
+        residentOccluders.resize(RESIDENT_OCCLUDERS);
+    }
+
+    candidates.reserve(Scene::instances.size() + residentOccluders.size());
+    triangles.reserve(MAX_OCCLUDERS * 12);
+    for (int level = 0; level < LEVELS; level++) {
+        nearest[level].assign((std::size_t)levelWidth(level) * levelHeight(level), 1.0f);
+        furthest[level].assign((std::size_t)levelWidth(level) * levelHeight(level), 1.0f);
+    }
+    rowMax.assign((std::size_t)WIDTH * HEIGHT, 1.0f);
+}
+
+void Occlusion::begin(const glm::mat4 &matrix, const Frustum &view) {
+    viewProjection = matrix;
+    frustum = view;
+}
+
+void Occlusion::gather() {
+    started = std::chrono::steady_clock::now();
+
+    // Chunk meshes aren't solid like their boxes, only cubes occlude
+    candidates.clear();
+    auto consider = [](const Scene::Instance &instance, std::uint32_t index) {
+        if (instance.material == Scene::CHUNK || instance.radius <= 0.0f || !frustum.SphereVisible(instance.position, instance.radius)) {
+            return;
+        }
+        float distance = std::max(frustum.NearDistance(instance.position), NEAR_W);
+        candidates.push_back(Candidate{instance.radius / distance, index});
+    };
+    for (std::size_t i = 0; i < Scene::instances.size(); i++) {
+        consider(Scene::instances[i], (std::uint32_t)i);
+    }
+    for (std::uint32_t i : residentOccluders) {
+        consider(Scene::resident[i], Scene::RESIDENT | i);
+    }
+
+    // The largest on screen, in instance order so the buffer doesn't depend on the sort
+    if (candidates.size() > (std::size_t)MAX_OCCLUDERS) {
+        std::nth_element(candidates.begin(), candidates.begin() + MAX_OCCLUDERS, candidates.end(), [](const Candidate &a, const Candidate &b) {
+            return a.size > b.size || (a.size == b.size && a.instance < b.instance);
+        });
+        candidates.resize(MAX_OCCLUDERS);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.instance < b.instance;
+    });
+    occluders = candidates.size();
+
+    // Faces with a corner too close to project are left out, which only makes the occluder smaller
+    triangles.clear();
+    for (const Candidate &candidate : candidates) {
+        const Scene::Instance &instance = candidate.instance & Scene::RESIDENT ? Scene::resident[candidate.instance & ~Scene::RESIDENT] : Scene::instances[candidate.instance];
+        glm::mat4 mvp = viewProjection * instance.model;
+        glm::vec3 corners[8];
+        bool projected[8];
+        for (int c = 0; c < 8; c++) {
+            glm::vec4 local((c & 1) - 0.5f, ((c >> 1) & 1) - 0.5f, ((c >> 2) & 1) - 0.5f, 1.0f);
+            projected[c] = project(mvp * local, corners[c]);
+        }
+        for (const int *face : CUBE_FACES) {
+            if (projected[face[0]] && projected[face[1]] && projected[face[2]] && projected[face[3]]) {
+                setup(corners[face[0]], corners[face[1]], corners[face[2]]);
+                setup(corners[face[0]], corners[face[2]], corners[face[3]]);
+            }
+        }
+    }
+}
+
+void Occlusion::rasterize(int band) {
+    int bandMin = band * HEIGHT / BANDS;
+    int bandMax = (band + 1) * HEIGHT / BANDS;
+    std::vector<float> &depth = nearest[0];
+    std::fill(depth.begin() + (std::size_t)bandMin * WIDTH, depth.begin() + (std::size_t)bandMax * WIDTH, 1.0f);
+
+    // Four texels per step, the buffer width is a multiple of four so a step never runs off a row
+    const Float4 lanes = Simd::set(0.5f, 1.5f, 2.5f, 3.5f);
+    const Float4 zero = Simd::splat(0.0f);
+    for (const Triangle &t : triangles) {
+        int y0 = std::max(t.minY, bandMin);
+        int y1 = std::min(t.maxY, bandMax);
+        for (int y = y0; y < y1; y++) {
+            float py = y + 0.5f;
+            Float4 row0 = Simd::splat(t.edgeB[0] * py + t.edgeC[0]);
+            Float4 row1 = Simd::splat(t.edgeB[1] * py + t.edgeC[1]);
+            Float4 row2 = Simd::splat(t.edgeB[2] * py + t.edgeC[2]);
+            Float4 rowDepth = Simd::splat(t.depthB * py + t.depthC);
+
+            for (int x = t.minX & ~3; x < t.maxX; x += 4) {
+                Float4 px = Simd::splat((float)x) + lanes;
+                Float4 inside = (Simd::splat(t.edgeA[0]) * px + row0 >= zero) & (Simd::splat(t.edgeA[1]) * px + row1 >= zero) & (Simd::splat(t.edgeA[2]) * px + row2 >= zero);
+                if (Simd::mask(inside) == 0) {
+                    continue;
+                }
+                float *texels = &depth[(std::size_t)y * WIDTH + x];
+                Float4 current = Simd::load(texels);
+                Float4 z = Simd::splat(t.depthA) * px + rowDepth;
+                Simd::store(texels, Simd::select(inside & (z < current), z, current));
+            }
+        }
+    }
+}
+
+void Occlusion::buildPyramid() {
+    // Furthest of each texel and its neighbours, a row pass then a column pass
+    const std::vector<float> &depth = nearest[0];
+    for (int y = 0; y < HEIGHT; y++) {
+        const float *row = &depth[(std::size_t)y * WIDTH];
+        for (int x = 0; x < WIDTH; x++) {
+            rowMax[(std::size_t)y * WIDTH + x] = std::max({row[std::max(x - 1, 0)], row[x], row[std::min(x + 1, WIDTH - 1)]});
+        }
+    }
+    for (int y = 0; y < HEIGHT; y++) {
+        const float *above = &rowMax[(std::size_t)std::max(y - 1, 0) * WIDTH];
+        const float *here = &rowMax[(std::size_t)y * WIDTH];
+        const float *below = &rowMax[(std::size_t)std::min(y + 1, HEIGHT - 1) * WIDTH];
+        float *out = &furthest[0][(std::size_t)y * WIDTH];
+        for (int x = 0; x < WIDTH; x += 4) {
+            Simd::store(out + x, Simd::max(Simd::max(Simd::load(above + x), Simd::load(here + x)), Simd::load(below + x)));
+        }
+    }
+
+    for (int level = 1; level < LEVELS; level++) {
+        int width = levelWidth(level), height = levelHeight(level);
+        int finerWidth = levelWidth(level - 1), finerHeight = levelHeight(level - 1);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                float near = 1.0f, far = 0.0f;
+                for (int cy = y * 2; cy <= std::min(y * 2 + 1, finerHeight - 1); cy++) {
+                    for (int cx = x * 2; cx <= std::min(x * 2 + 1, finerWidth - 1); cx++) {
+                        std::size_t i = (std::size_t)cy * finerWidth + cx;
+                        near = std::min(near, nearest[level - 1][i]);
+                        far = std::max(far, furthest[level - 1][i]);
+                    }
+                }
+                nearest[level][(std::size_t)y * width + x] = near;
+                furthest[level][(std::size_t)y * width + x] = far;
+            }
+        }
+    }
+    milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+bool Occlusion::visible(const glm::vec3 &min, const glm::vec3 &max) {
+    if (occluders == 0) {
+        return true;
+    }
+
+    // Texels the box touches and its nearest depth, anything reaching past the near plane is kept
+    glm::vec3 low(1e9f), high(-1e9f);
+    for (int c = 0; c < 8; c++) {
+        glm::vec3 corner((c & 1) ? max.x : min.x, (c & 2) ? max.y : min.y, (c & 4) ? max.z : min.z);
+        glm::vec3 p;
+        if (!project(viewProjection * glm::vec4(corner, 1.0f), p)) {
+            return true;
+        }
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+    }
+    int x0 = std::max(0, (int)std::floor(low.x));
+    int y0 = std::max(0, (int)std::floor(low.y));
+    int x1 = std::min(WIDTH - 1, (int)std::floor(high.x));
+    int y1 = std::min(HEIGHT - 1, (int)std::floor(high.y));
+    if (x0 > x1 || y0 > y1) {
+        return true;
+    }
+
+    // Start where the box spans at most two texels each way
+    int level = 0;
+    while (level < LEVELS - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        level++;
+    }
+    for (int y = y0 >> level; y <= (y1 >> level); y++) {
+        for (int x = x0 >> level; x <= (x1 >> level); x++) {
+            if (visibleIn(level, x, y, x0, y0, x1, y1, low.z)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Occlusion::copyPyramid(std::vector<float> &out, glm::mat4 &matrix) {
+    out.clear();
+    for (int level = 0; level < LEVELS; level++) {
+        out.insert(out.end(), furthest[level].begin(), furthest[level].end());
+    }
+    matrix = viewProjection;
+}
+
+void Occlusion::countHidden(std::size_t count) {
+    if (count > 0) {
+        hidden.fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+void Occlusion::endFrame() {
+    Stats::set("occlusion_occluders", (double)occluders);
+    Stats::set("occlusion_hidden", (double)hidden.exchange(0));
+    Stats::set("occlusion_ms", milliseconds);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "./frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Software hierarchical-Z occlusion culling. Every frame the cubes that
+ * cover the most of the screen become occluders and are rasterized, four
+ * pixels at a time, into a small depth buffer split into bands that are
+ * filled as separate jobs. A pyramid of the nearest and furthest depth per
+ * texel is built from it, and the box of every instance is then tested
+ * against the pyramid from the coarsest level that covers it in two by two
+ * texels down to the finest it needs. The furthest depth of the finest level
+ * is widened by a texel first, so an occluder edge running through a texel
+ * never hides what shows beside it. Runs inside the simulation's job graph
+ * between the transform updates and recording.
+ */
+
+namespace Occlusion {
+    const int WIDTH = 256;              // Depth buffer size, independent of the window
+    const int HEIGHT = 128;
+    const int LEVELS = 9;               // Pyramid levels, down to one texel
+    const int BANDS = 8;                // Rows of the depth buffer rasterized as separate jobs
+    const int MAX_OCCLUDERS = 128;
+    const int RESIDENT_OCCLUDERS = 4 * MAX_OCCLUDERS;  // Resident cubes ever considered, picked once by init
+
+    // Size the buffers for the scene, call when the scene changes
+    extern void init();
+
+    // Main thread, before the graph runs: the view the frame is culled for
+    extern void begin(const glm::mat4 &viewProjection, const Frustum &frustum);
+
+    // Jobs, in this order: pick the occluders and set up their triangles, fill each band,
+    // then build the pyramid
+    extern void gather();
+    extern void rasterize(int band);
+    extern void buildPyramid();
+
+    // Any thread once the pyramid is built: false only when the box is certainly hidden
+    extern bool visible(const glm::vec3 &min, const glm::vec3 &max);
+
+    // Once the pyramid is built: the furthest depth of every level, finest first, and the view it
+    // was built for, for culling on the GPU
+    extern void copyPyramid(std::vector<float> &furthest, glm::mat4 &viewProjection);
+
+    // Record how many instances of a partition were hidden, then report the frame's totals to Stats
+    extern void countHidden(std::size_t hidden);
+    extern void endFrame();
+}
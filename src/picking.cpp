@@ -0,0 +1,54 @@
+#include "./picking.h"
+#include "./scene.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+    Bvh::Tree tree;
+    std::vector<Bvh::Box> boxes;
+    std::vector<std::uint32_t> instanceOf;     // Per box
+    std::size_t movable = 0;                    // Boxes of Scene::instances, the resident cubes' come after
+
+    // Every instance is a unit cube scaled
+    Bvh::Box boxOf(const Scene::Instance &instance) {
+        return Bvh::Box{instance.position - instance.scale * 0.5f, instance.position + instance.scale * 0.5f};
+    }
+}
+
+void Picking::build() {
+    boxes.clear();
+    instanceOf.clear();
+    for (std::size_t i = 0; i < Scene::instances.size(); i++) {
+        const Scene::Instance &instance = Scene::instances[i];
+        if (instance.material != Scene::CHUNK && instance.scale != glm::vec3(0.0f)) {
+            boxes.push_back(boxOf(instance));
+            instanceOf.push_back((std::uint32_t)i);
+        }
+    }
+    movable = boxes.size();
+    for (std::size_t i = 0; i < Scene::resident.size(); i++) {
+        boxes.push_back(boxOf(Scene::resident[i]));
+        instanceOf.push_back(Scene::RESIDENT | (std::uint32_t)i);
+    }
+    tree.build(boxes);
+}
+
+void Picking::refit() {
+    for (std::size_t i = 0; i < movable; i++) {
+        boxes[i] = boxOf(Scene::instances[instanceOf[i]]);
+    }
+    tree.refit(boxes);
+}
+
+bool Picking::pick(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Bvh::Hit &hit) {
+    if (!tree.raycast(origin, direction, maxDistance, hit)) {
+        return false;
+    }
+    hit.object = instanceOf[hit.object];
+    return true;
+}
+
+bool Picking::lineOfSight(const glm::vec3 &from, const glm::vec3 &to) {
+    return !tree.intersects(from, to);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "./bvh.h"
+
+#include <glm/glm.hpp>
+
+/**
+ * Ray queries against the scene's cubes, through a BVH over their boxes.
+ * Chunks and parked instances are left out, a chunk's box is mostly air.
+ * Runs on the simulation side, like everything else that reads the scene.
+ */
+
+namespace Picking {
+    // Index the cubes, call once the scene is built
+    extern void build();
+
+    // Follow cubes that moved since the build, resident ones never do
+    extern void refit();
+
+    // Nearest cube the ray from origin along the unit direction enters within maxDistance,
+    // hit.object is its instance index, with Scene::RESIDENT set for a resident cube
+    extern bool pick(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Bvh::Hit &hit);
+
+    // True when no cube touches the segment between the two points
+    extern bool lineOfSight(const glm::vec3 &from, const glm::vec3 &to);
+}
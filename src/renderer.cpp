@@ -0,0 +1,635 @@
+#include "./renderer.h"
+#include "./shader.h"
+#include "./cube.h"
+#include "./texture.h"
+#include "./glstate.h"
+#include "./clusters.h"
+#include "./shadows.h"
+#include "./config.h"
+#include "./stats.h"
+#include "./voxels.h"
+#include "./streaming.h"
+#include "./gpucull.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+namespace {
+    std::unique_ptr<Shader> lightingShader, lampShader;
+    unsigned int cubeVAO, cubeVBO, lampVAO, lampVBO;
+    unsigned int texture;
+
+    // Deferred path
+    std::unique_ptr<Shader> gbufferShader, keyLightShader, pointLightShader;
+    unsigned int volumeVAO, instanceVBO, emptyVAO;
+    std::vector<float> lightInstances;  // Position and radius, color, per point light
+
+    // Depth pre-pass and overdraw view, drawn from a position-only copy of the cube
+    std::unique_ptr<Shader> depthShader, overdrawShader, overdrawViewShader;
+    unsigned int positionVAO, positionVBO;
+    std::vector<float> overdrawCounts;
+
+    // Billboards of distant lit cubes, see lod.h. The atlas holds the cube seen from IMPOSTOR_YAWS
+    // directions around it at each of IMPOSTOR_PITCHES heights, albedo with coverage in alpha and normals
+    const int IMPOSTOR_YAWS = 8, IMPOSTOR_PITCHES = 4, IMPOSTOR_CELL = 64;
+    std::unique_ptr<Shader> impostorShader, gbufferImpostorShader;
+    GLuint impostorAlbedo, impostorNormals;
+    unsigned int impostorVAO, impostorVBO;
+    std::vector<float> impostorInstances;   // Centre and radius per billboard
+
+    // Lit cubes culled and drawn by GpuCull, forward and into the G-buffer
+    std::unique_ptr<Shader> culledShader, gbufferCulledShader;
+
+    // Voxel chunk meshes, uploaded on first use and again when Voxels rebuilds them
+    struct ChunkBuffers {
+        GLuint vao, vbo, ebo;
+        std::uint32_t levelStart[Lod::LEVELS + 1];
+        std::uint32_t revision;     // Of the mesh in the buffers, 0 before the first upload
+    };
+    std::vector<ChunkBuffers> chunkBuffers;
+
+    const ChunkBuffers& chunkMesh(std::uint32_t mesh) {
+        if (mesh >= chunkBuffers.size()) {
+            chunkBuffers.resize(mesh + 1, ChunkBuffers{0, 0, 0, {}, 0});
+        }
+        ChunkBuffers &buffers = chunkBuffers[mesh];
+        const Voxels::Mesh &source = Voxels::meshes[mesh];
+        if (buffers.revision == source.revision) {
+            return buffers;
+        }
+
+        // Same attribute locations as the cube's vertex array
+        if (buffers.vao == 0) {
+            glGenVertexArrays(1, &buffers.vao);
+            glGenBuffers(1, &buffers.vbo);
+            glGenBuffers(1, &buffers.ebo);
+            GLState::bindVertexArray(buffers.vao);
+            GLState::bindBuffer(GL_ARRAY_BUFFER, buffers.vbo);
+            GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ebo);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)(5 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(2);
+        } else {
+            GLState::bindVertexArray(buffers.vao);
+            GLState::bindBuffer(GL_ARRAY_BUFFER, buffers.vbo);
+        }
+        glBufferData(GL_ARRAY_BUFFER, source.vertices.size() * sizeof(float), source.vertices.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, source.indices.size() * sizeof(std::uint32_t), source.indices.data(), GL_STATIC_DRAW);
+        std::copy(source.levelStart, source.levelStart + Lod::LEVELS + 1, buffers.levelStart);
+        buffers.revision = source.revision;
+        return buffers;
+    }
+
+    // Issue one command's draw. Cubes use the bound cube vertex array, chunks bind their own and draw
+    // the index range of their level. Impostors aren't drawn here but all together by drawImpostors
+    void submit(const DrawCommand &command) {
+        if (command.material != Scene::CHUNK) {
+            glDrawArrays(GL_TRIANGLES, 0, Cube::vertCount);
+            return;
+        }
+        if (command.mesh & Streaming::STREAMED) {
+            Streaming::draw(command.mesh & ~Streaming::STREAMED, command.lod);
+            return;
+        }
+        const ChunkBuffers &buffers = chunkMesh(command.mesh);
+        GLsizei count = (GLsizei)(buffers.levelStart[command.lod + 1] - buffers.levelStart[command.lod]);
+        GLState::bindVertexArray(buffers.vao);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(buffers.levelStart[command.lod] * sizeof(std::uint32_t)));
+    }
+
+    // Triangles the commands submit, and would submit at full detail, for Stats
+    void countTriangles(const std::vector<DrawCommand> &commands) {
+        const double CUBE_TRIANGLES = Cube::vertCount / 3;
+        double submitted = 0.0, full = 0.0;
+        for (const DrawCommand &command : commands) {
+            if (command.material != Scene::CHUNK) {
+                submitted += command.lod == Lod::IMPOSTOR ? 2.0 : CUBE_TRIANGLES;
+                full += CUBE_TRIANGLES;
+            } else if (command.mesh & Streaming::STREAMED) {
+                submitted += Streaming::triangles(command.mesh & ~Streaming::STREAMED, command.lod);
+                full += Streaming::triangles(command.mesh & ~Streaming::STREAMED, 0);
+            } else {
+                const std::uint32_t *levelStart = Voxels::meshes[command.mesh].levelStart;
+                submitted += (levelStart[command.lod + 1] - levelStart[command.lod]) / 3;
+                full += levelStart[1] / 3;
+            }
+        }
+        Stats::set("triangles", submitted);
+        Stats::set("triangles_full", full);
+    }
+
+    // Translation and scale only, so blending the matrices interpolates correctly
+    glm::mat4 interpolatedModel(const DrawCommand &command, const Renderer::Frame &frame) {
+        if (frame.alpha < 1.0f) {
+            return command.previousModel * (1.0f - frame.alpha) + command.model * frame.alpha;
+        }
+        return command.model;
+    }
+
+    // Uniforms of lightingShader.fs, whichever vertex shader it is linked with
+    void bindLit(Shader &shader, const Renderer::Frame &frame) {
+        shader.use();
+        shader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+        shader.setVec3("lightColor", frame.lightColor);
+        shader.setMat4("projection", frame.projection);
+        shader.setMat4("view", frame.view);
+        shader.setVec3("lightPos", frame.lightPos);
+        shader.setVec3("viewPos", frame.viewPos);
+        shader.setVec3("sunDirection", frame.sunDirection);
+        shader.setVec3("sunColor", frame.sunColor);
+
+        // Point light lists and shadow maps on the units after the wall texture
+        Clusters::bind(shader, 1);
+        Shadows::bind(shader, 4);
+    }
+
+    // Set the uniforms that stay the same for every draw of a material
+    Shader* bindMaterial(Scene::Material material, const Renderer::Frame &frame) {
+        // Lit cubes laid down in the pre-pass only shade the nearest fragment and leave depth alone
+        bool prepassed = Config::depthPrepass && material == Scene::LIT;
+        GLState::depthFunc(prepassed ? GL_LEQUAL : GL_LESS);
+        GLState::depthMask(prepassed ? GL_FALSE : GL_TRUE);
+
+        if (material == Scene::LAMP) {
+            lampShader->use();
+            lampShader->setMat4("projection", frame.projection);
+            lampShader->setMat4("view", frame.view);
+
+            GLState::bindVertexArray(lampVAO);
+            return lampShader.get();
+        }
+
+        bindLit(*lightingShader, frame);
+
+        // Set texture
+        Texture::activate(texture, GL_TEXTURE0);
+        lightingShader->setInt("texture1", 0);
+
+        GLState::bindVertexArray(cubeVAO);
+        return lightingShader.get();
+    }
+
+    void initPositions() {
+        depthShader.reset(new Shader("../src/shaders/depthOnly.vs", "../src/shaders/depthOnly.fs"));
+        overdrawShader.reset(new Shader("../src/shaders/depthOnly.vs", "../src/shaders/overdraw.fs"));
+        overdrawViewShader.reset(new Shader("../src/shaders/upscale.vs", "../src/shaders/overdrawView.fs"));
+
+        // Tightly packed positions, a third of the bandwidth of the interleaved stream
+        std::vector<float> positions;
+        for (std::size_t v = 0; v < Cube::vertCount; v++) {
+            const float *vertex = &Cube::vertices[v * (Cube::vertSize / sizeof(float))];
+            positions.insert(positions.end(), vertex, vertex + 3);
+        }
+
+        glGenVertexArrays(1, &positionVAO);
+        glGenBuffers(1, &positionVBO);
+        GLState::bindVertexArray(positionVAO);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        GLState::bindVertexArray(0);
+    }
+
+    // Replay the commands of one material with a shader that only needs positions
+    void drawPositions(const std::vector<DrawCommand> &commands, const Renderer::Frame &frame, Shader &shader, Scene::Material material) {
+        shader.use();
+        shader.setMat4("projection", frame.projection);
+        shader.setMat4("view", frame.view);
+        GLState::bindVertexArray(positionVAO);
+
+        for (const DrawCommand &command : commands) {
+            if (command.material == material && command.lod != Lod::IMPOSTOR) {
+                shader.setMat4("model", interpolatedModel(command, frame));
+                submit(command);
+            }
+        }
+    }
+
+    // Depth of the lit cubes only, the lamps are cheap enough to shade twice
+    void depthPrepass(const std::vector<DrawCommand> &commands, const Renderer::Frame &frame) {
+        GLState::depthFunc(GL_LESS);
+        GLState::depthMask(GL_TRUE);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        drawPositions(commands, frame, *depthShader, Scene::LIT);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    void initDeferred() {
+        gbufferShader.reset(new Shader("../src/shaders/gbuffer.vs", "../src/shaders/gbuffer.fs"));
+        keyLightShader.reset(new Shader("../src/shaders/deferredKeyLight.vs", "../src/shaders/deferredLight.fs"));
+        pointLightShader.reset(new Shader("../src/shaders/deferredPointLight.vs", "../src/shaders/deferredLight.fs"));
+
+        // Light volumes: the lamp cube's positions and normals, the light per instance
+        glGenVertexArrays(1, &volumeVAO);
+        glGenBuffers(1, &instanceVBO);
+        GLState::bindVertexArray(volumeVAO);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, lampVBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, Cube::vertSize, (void*)(5 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+
+        GLState::bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+        GLState::bindVertexArray(0);
+
+        // Fullscreen triangles are generated from the vertex id
+        glGenVertexArrays(1, &emptyVAO);
+    }
+
+    // Uniforms both deferred light shaders use to rebuild positions from the G-buffer
+    void bindDeferredLight(Shader &shader, const Renderer::Frame &frame) {
+        shader.use();
+        shader.setInt("gAlbedo", 0);
+        shader.setInt("gNormal", 1);
+        shader.setInt("gDepth", 2);
+        shader.setVec3("viewPos", frame.viewPos);
+        shader.setMat4("inverseProjection", glm::inverse(frame.projection));
+        shader.setMat4("inverseView", glm::inverse(frame.view));
+        shader.setVec3("sunDirection", frame.sunDirection);
+        shader.setVec3("sunColor", frame.sunColor);
+        Shadows::bind(shader, 3);
+    }
+
+    // Where the atlas cell of column and row was captured from, the same as cellDirection in impostor.vs
+    glm::vec3 impostorDirection(int column, int row) {
+        float yaw = column * glm::two_pi<float>() / IMPOSTOR_YAWS;
+        float pitch = (row + 0.5f) * glm::pi<float>() / IMPOSTOR_PITCHES - glm::half_pi<float>();
+        return glm::vec3(std::cos(pitch) * std::sin(yaw), std::sin(pitch), std::cos(pitch) * std::cos(yaw));
+    }
+
+    GLuint createAtlasTexture() {
+        GLuint id;
+        glGenTextures(1, &id);
+        GLState::bindTexture(GL_TEXTURE_2D, id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, IMPOSTOR_YAWS * IMPOSTOR_CELL, IMPOSTOR_PITCHES * IMPOSTOR_CELL, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return id;
+    }
+
+    // Render the lit cube into every cell of the atlas, orthographic so each cell fits its bounding sphere
+    void initImpostors() {
+        impostorShader.reset(new Shader("../src/shaders/impostor.vs", "../src/shaders/lightingShader.fs"));
+        if (Config::renderer == "deferred") {
+            gbufferImpostorShader.reset(new Shader("../src/shaders/impostor.vs", "../src/shaders/gbuffer.fs"));
+        }
+
+        impostorAlbedo = createAtlasTexture();
+        impostorNormals = createAtlasTexture();
+
+        GLuint framebuffer, depth;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IMPOSTOR_YAWS * IMPOSTOR_CELL, IMPOSTOR_PITCHES * IMPOSTOR_CELL);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, impostorAlbedo, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, impostorNormals, 0);
+        const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::RENDERER::IMPOSTOR_FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+
+        // Nothing covered is zero alpha, which the billboards discard
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::depthFunc(GL_LESS);
+        GLState::depthMask(GL_TRUE);
+        GLState::viewport(0, 0, IMPOSTOR_YAWS * IMPOSTOR_CELL, IMPOSTOR_PITCHES * IMPOSTOR_CELL);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        Shader capture("../src/shaders/gbuffer.vs", "../src/shaders/impostorCapture.fs");
+        capture.use();
+        capture.setMat4("model", glm::mat4(1.0f));
+        const float RADIUS = 0.8660254f;
+        capture.setMat4("projection", glm::ortho(-RADIUS, RADIUS, -RADIUS, RADIUS, 1.0f, 3.0f));
+        Texture::activate(texture, GL_TEXTURE0);
+        capture.setInt("texture1", 0);
+        GLState::bindVertexArray(cubeVAO);
+        for (int row = 0; row < IMPOSTOR_PITCHES; row++) {
+            for (int column = 0; column < IMPOSTOR_YAWS; column++) {
+                capture.setMat4("view", glm::lookAt(impostorDirection(column, row) * 2.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+                GLState::viewport(column * IMPOSTOR_CELL, row * IMPOSTOR_CELL, IMPOSTOR_CELL, IMPOSTOR_CELL);
+                glDrawArrays(GL_TRIANGLES, 0, Cube::vertCount);
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &depth);
+        GLState::deleteProgram(capture.ID);
+
+        // Four corners from the vertex id, centre and radius per instance
+        glGenVertexArrays(1, &impostorVAO);
+        glGenBuffers(1, &impostorVBO);
+        GLState::bindVertexArray(impostorVAO);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, impostorVBO);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+        GLState::bindVertexArray(0);
+    }
+
+    // Collect the impostor commands into the instance buffer, returns how many there are
+    GLsizei gatherImpostors(const std::vector<DrawCommand> &commands, const Renderer::Frame &frame) {
+        impostorInstances.clear();
+        for (const DrawCommand &command : commands) {
+            if (command.lod != Lod::IMPOSTOR) {
+                continue;
+            }
+            glm::mat4 model = interpolatedModel(command, frame);
+            float largest = std::max(model[0][0], std::max(model[1][1], model[2][2]));
+            impostorInstances.insert(impostorInstances.end(), {model[3][0], model[3][1], model[3][2], 0.8660254f * largest});
+        }
+        if (!impostorInstances.empty()) {
+            GLState::bindBuffer(GL_ARRAY_BUFFER, impostorVBO);
+            glBufferData(GL_ARRAY_BUFFER, impostorInstances.size() * sizeof(float), impostorInstances.data(), GL_STREAM_DRAW);
+        }
+        return (GLsizei)(impostorInstances.size() / 4);
+    }
+
+    // One instanced draw of every billboard, with a shader already bound and set up for lit surfaces
+    void drawImpostors(Shader &shader, GLsizei count) {
+        GLState::depthFunc(GL_LESS);
+        GLState::depthMask(GL_TRUE);
+        shader.setBool("impostor", true);
+        shader.setVec2("atlasCells", glm::vec2((float)IMPOSTOR_YAWS, (float)IMPOSTOR_PITCHES));
+        Texture::activate(impostorNormals, GL_TEXTURE6);
+        shader.setInt("impostorNormals", 6);
+        Texture::activate(impostorAlbedo, GL_TEXTURE0);
+        shader.setInt("texture1", 0);
+        GLState::bindVertexArray(impostorVAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    }
+}
+
+void Renderer::init() {
+    // Init shaders
+    lightingShader.reset(new Shader("../src/shaders/lightingShader.vs", "../src/shaders/lightingShader.fs"));
+    lampShader.reset(new Shader("../src/shaders/lampShader.vs", "../src/shaders/lampShader.fs"));
+
+    // Create cubes
+    Cube::createCube(cubeVAO, cubeVBO, 0);
+    Cube::createCube(lampVAO, lampVBO, 0);
+
+    // Bind Normals
+    Cube::bindNormals(cubeVAO, cubeVBO, 1);
+
+    // Bind Textures
+    Cube::bindTexture(cubeVAO, cubeVBO, 2);
+
+    // Load Textures, bench runs draw their own so the references don't depend on the assets
+    if (Config::bench.empty()) {
+        texture = Texture::load("../assets/wall.jpg", GL_RGB, GL_REPEAT, GL_LINEAR);
+    } else {
+        texture = Texture::loadBricks(GL_REPEAT, GL_LINEAR);
+    }
+
+    // Buffers for the point light lists, and the shadow maps
+    Clusters::init();
+    Shadows::init();
+
+    if (Config::renderer == "deferred") {
+        initDeferred();
+    }
+    if (Config::depthPrepass || Config::overdraw) {
+        initPositions();
+    }
+    if (Config::lod) {
+        initImpostors();
+    }
+    if (Config::gpuCulling) {
+        culledShader.reset(new Shader("../src/shaders/cubeInstanced.vs", "../src/shaders/lightingShader.fs"));
+        if (Config::renderer == "deferred") {
+            gbufferCulledShader.reset(new Shader("../src/shaders/cubeInstanced.vs", "../src/shaders/gbuffer.fs"));
+        }
+        GpuCull::init();
+    }
+
+    // Enable depth testing
+    GLState::enable(GL_DEPTH_TEST);
+}
+
+void Renderer::draw(const std::vector<DrawCommand> &commands, const Frame &frame) {
+    static const std::vector<Scene::Light> noLights;
+    Clusters::build(frame.lights ? *frame.lights : noLights, frame.view, frame.projection);
+
+    // clear
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (Config::depthPrepass) {
+        depthPrepass(commands, frame);
+    }
+
+    // Commands arrive sorted by material, so switch shaders only when it changes
+    Shader *shader = nullptr;
+    Scene::Material current = Scene::MATERIAL_COUNT;
+
+    for (const DrawCommand &command : commands) {
+        if (command.lod == Lod::IMPOSTOR) {
+            continue;
+        }
+        if (command.material != current) {
+            current = command.material;
+            shader = bindMaterial(current, frame);
+        }
+
+        shader->setMat4("model", interpolatedModel(command, frame));
+        submit(command);
+    }
+
+    // Not laid down by the pre-pass, so they test and write depth as usual
+    if (Config::gpuCulling) {
+        GLState::depthFunc(GL_LESS);
+        GLState::depthMask(GL_TRUE);
+        bindLit(*culledShader, frame);
+        Texture::activate(texture, GL_TEXTURE0);
+        culledShader->setInt("texture1", 0);
+        GpuCull::draw();
+    }
+
+    GLsizei impostors = gatherImpostors(commands, frame);
+    if (impostors > 0) {
+        bindLit(*impostorShader, frame);
+        drawImpostors(*impostorShader, impostors);
+    }
+    countTriangles(commands);
+
+    // The next clear needs depth writes on
+    GLState::depthFunc(GL_LESS);
+    GLState::depthMask(GL_TRUE);
+}
+
+void Renderer::drawOverdraw(const std::vector<DrawCommand> &commands, const Frame &frame, int width, int height) {
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Same depth work as draw, counting every fragment that passes where draw would shade
+    if (Config::depthPrepass) {
+        depthPrepass(commands, frame);
+    }
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_ONE, GL_ONE);
+    for (int m = 0; m < Scene::MATERIAL_COUNT; m++) {
+        Scene::Material material = (Scene::Material)m;
+        bool prepassed = Config::depthPrepass && material == Scene::LIT;
+        GLState::depthFunc(prepassed ? GL_LEQUAL : GL_LESS);
+        GLState::depthMask(prepassed ? GL_FALSE : GL_TRUE);
+        drawPositions(commands, frame, *overdrawShader, material);
+    }
+    GLState::disable(GL_BLEND);
+    GLState::depthFunc(GL_LESS);
+    GLState::depthMask(GL_TRUE);
+
+    // Read the counts back, this stalls but it is a debug view
+    overdrawCounts.resize((std::size_t)width * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, overdrawCounts.data());
+
+    double shaded = 0.0;
+    std::size_t covered = 0;
+    for (float count : overdrawCounts) {
+        shaded += count;
+        covered += count > 0.0f ? 1 : 0;
+    }
+    Stats::set("overdraw", overdrawCounts.empty() ? 0.0 : shaded / overdrawCounts.size());
+    Stats::set("overdraw_covered", covered > 0 ? shaded / covered : 0.0);
+}
+
+void Renderer::showOverdraw(GLuint counts) {
+    GLState::disable(GL_DEPTH_TEST);
+    overdrawViewShader->use();
+    Texture::activate(counts, GL_TEXTURE0);
+    overdrawViewShader->setInt("counts", 0);
+    overdrawViewShader->setVec2("uvScale", glm::vec2(1.0f));
+
+    // The fullscreen triangle is generated from the vertex id, any VAO will do
+    GLState::bindVertexArray(positionVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    GLState::enable(GL_DEPTH_TEST);
+}
+
+void Renderer::drawGBuffer(const std::vector<DrawCommand> &commands, const Frame &frame) {
+    // Zero depth marks pixels nothing covers
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    gbufferShader->use();
+    gbufferShader->setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+    gbufferShader->setMat4("projection", frame.projection);
+    gbufferShader->setMat4("view", frame.view);
+    Texture::activate(texture, GL_TEXTURE0);
+    gbufferShader->setInt("texture1", 0);
+    GLState::bindVertexArray(cubeVAO);
+
+    for (const DrawCommand &command : commands) {
+        if (command.material == Scene::LAMP || command.lod == Lod::IMPOSTOR) {
+            continue;
+        }
+        gbufferShader->setMat4("model", interpolatedModel(command, frame));
+        submit(command);
+    }
+
+    if (Config::gpuCulling) {
+        gbufferCulledShader->use();
+        gbufferCulledShader->setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+        gbufferCulledShader->setMat4("projection", frame.projection);
+        gbufferCulledShader->setMat4("view", frame.view);
+        gbufferCulledShader->setInt("texture1", 0);
+        GpuCull::draw();
+    }
+
+    GLsizei impostors = gatherImpostors(commands, frame);
+    if (impostors > 0) {
+        gbufferImpostorShader->use();
+        gbufferImpostorShader->setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+        gbufferImpostorShader->setMat4("projection", frame.projection);
+        gbufferImpostorShader->setMat4("view", frame.view);
+        gbufferImpostorShader->setVec3("viewPos", frame.viewPos);
+        drawImpostors(*gbufferImpostorShader, impostors);
+    }
+    countTriangles(commands);
+}
+
+void Renderer::drawDeferredLighting(const std::vector<DrawCommand> &commands, const Frame &frame, GLuint albedo, GLuint normal, GLuint depth) {
+    // Depth is the G-buffer's, it stays
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    Texture::activate(normal, GL_TEXTURE1);
+    Texture::activate(depth, GL_TEXTURE2);
+    Texture::activate(albedo, GL_TEXTURE0);
+
+    // The main light covers the whole screen
+    GLState::disable(GL_DEPTH_TEST);
+    bindDeferredLight(*keyLightShader, frame);
+    keyLightShader->setVec3("lightPos", frame.lightPos);
+    keyLightShader->setVec3("lightColor", frame.lightColor);
+    GLState::bindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Point lights add up. A volume's back faces pass the depth test where a surface is in front of them
+    std::size_t lightCount = frame.lights ? frame.lights->size() : 0;
+    if (lightCount > 0) {
+        lightInstances.clear();
+        for (const Scene::Light &light : *frame.lights) {
+            lightInstances.insert(lightInstances.end(), {
+                light.position.x, light.position.y, light.position.z, light.radius,
+                light.color.r, light.color.g, light.color.b
+            });
+        }
+        GLState::bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, lightInstances.size() * sizeof(float), lightInstances.data(), GL_STREAM_DRAW);
+
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::depthFunc(GL_GEQUAL);
+        GLState::depthMask(GL_FALSE);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_ONE, GL_ONE);
+
+        bindDeferredLight(*pointLightShader, frame);
+        pointLightShader->setMat4("viewProjection", frame.projection * frame.view);
+        GLState::bindVertexArray(volumeVAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, Cube::vertCount, (GLsizei)lightCount);
+
+        GLState::disable(GL_BLEND);
+        GLState::depthMask(GL_TRUE);
+        GLState::depthFunc(GL_LESS);
+    }
+    GLState::enable(GL_DEPTH_TEST);
+
+    // Lamps aren't lit, they go on top forward shaded
+    Shader *shader = nullptr;
+    Scene::Material current = Scene::MATERIAL_COUNT;
+    for (const DrawCommand &command : commands) {
+        if (command.material != Scene::LAMP) {
+            continue;
+        }
+        if (command.material != current) {
+            current = command.material;
+            shader = bindMaterial(current, frame);
+        }
+        shader->setMat4("model", interpolatedModel(command, frame));
+        glDrawArrays(GL_TRIANGLES, 0, Cube::vertCount);
+    }
+}
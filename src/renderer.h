@@ -0,0 +1,48 @@
+#pragma once
+
+#include "./drawlist.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/**
+ * Owns the GL resources of the scene and replays merged draw lists.
+ * Only call from the thread that owns the GL context.
+ */
+
+namespace Renderer {
+    // Per frame values shared by every draw
+    struct Frame {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::vec3 viewPos;
+        glm::vec3 lightPos;
+        glm::vec3 lightColor;
+        glm::vec3 sunDirection;     // Direction the sunlight travels
+        glm::vec3 sunColor;         // Black for no sun
+        const std::vector<Scene::Light> *lights;    // Point lights shaded through the clusters, may be null
+        float alpha;    // Blend from previousModel (0) to model (1) of each command
+    };
+
+    // Load shaders, geometry and textures
+    extern void init();
+
+    // Clear and replay the commands in order
+    extern void draw(const std::vector<DrawCommand> &commands, const Frame &frame);
+
+    // Overdraw view: count the fragments draw would shade per pixel into the bound R16F target,
+    // reporting the averages to Stats, then show the counts as a heat map
+    extern void drawOverdraw(const std::vector<DrawCommand> &commands, const Frame &frame, int width, int height);
+    extern void showOverdraw(GLuint counts);
+
+    // Deferred path. The G-buffer takes albedo with specular strength (RGBA8) and an octahedral
+    // normal (RG16_SNORM) of the lit cubes and chunks, positions come back from the depth buffer
+    extern void drawGBuffer(const std::vector<DrawCommand> &commands, const Frame &frame);
+
+    // Light the G-buffer into the bound target, which must have the G-buffer's depth attached and
+    // depth as its texture, then draw the unlit commands on top. Point lights are instanced lamp
+    // cubes and leave the depth alone while they read it
+    extern void drawDeferredLighting(const std::vector<DrawCommand> &commands, const Frame &frame, GLuint albedo, GLuint normal, GLuint depth);
+}
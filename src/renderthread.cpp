@@ -0,0 +1,322 @@
+#include "./renderthread.h"
+#include "./renderer.h"
+#include "./triplebuffer.h"
+#include "./window.h"
+#include "./glstate.h"
+#include "./framepacer.h"
+#include "./dynres.h"
+#include "./rtpool.h"
+#include "./framegraph.h"
+#include "./capture.h"
+#include "./gltrace.h"
+#include "./alloctrack.h"
+#include "./softraster.h"
+#include "./shadows.h"
+#include "./streaming.h"
+#include "./gpucull.h"
+#include "./config.h"
+#include "./stats.h"
+#include "./camera.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+    TripleBuffer<FramePacket> packets;
+    std::uint64_t nextSequence = 0;
+
+    std::thread thread;
+    std::atomic<bool> running(false);
+
+    FrameGraph graph;
+
+    CameraState interpolate(const CameraState &a, const CameraState &b, float t) {
+        CameraState state;
+        state.position = glm::mix(a.position, b.position, t);
+        state.yaw = glm::mix(a.yaw, b.yaw, t);
+        state.pitch = glm::mix(a.pitch, b.pitch, t);
+        state.zoom = glm::mix(a.zoom, b.zoom, t);
+        return state;
+    }
+
+    Renderer::Frame makeFrame(const FramePacket &packet, double now, int width, int height) {
+        // Show the state one step behind the simulation, so there are always two states to blend
+        float alpha = 1.0f;
+        if (packet.stepLength > 0.0f) {
+            alpha = glm::clamp((float)((now - packet.stepTime) / packet.stepLength), 0.0f, 1.0f);
+        }
+        CameraState state = interpolate(packet.previousCamera, packet.camera, alpha);
+        Camera view(state.position, glm::vec3(0.0f, 1.0f, 0.0f), state.yaw, state.pitch);
+
+        Renderer::Frame frame;
+        frame.projection = glm::perspective(glm::radians(state.zoom), (float)width / (float)height, 0.1f, 100.0f);
+        frame.view = view.GetViewMatrix();
+        frame.viewPos = state.position;
+        frame.lightPos = packet.lightPos;
+        frame.lightColor = packet.lightColor;
+        frame.sunDirection = packet.sunDirection;
+        frame.sunColor = packet.sunColor;
+        frame.lights = &packet.lights;
+        frame.alpha = alpha;
+        return frame;
+    }
+
+    // G-buffer, lighting into a target that shares its depth, then out to the window
+    void buildDeferred(FrameGraph &graph, const FramePacket &packet, const Renderer::Frame &frame, FrameGraph::Resource backbuffer, int width, int height) {
+        FrameGraph::Resource albedo = graph.create("gbuffer_albedo", RenderTargets::window(GL_RGBA8));
+        FrameGraph::Resource normal = graph.create("gbuffer_normal", RenderTargets::window(GL_RG16_SNORM));
+        FrameGraph::Resource zbuffer = graph.create("gbuffer_zbuffer", RenderTargets::window(GL_DEPTH24_STENCIL8));
+        RenderTargetDesc colorDesc = RenderTargets::window(GL_RGBA16F);
+        FrameGraph::Resource color = graph.create("deferred_color", colorDesc);
+        int targetWidth = colorDesc.resolvedWidth();
+        int targetHeight = colorDesc.resolvedHeight();
+
+        FrameGraph::Pass geometry = graph.addPass("gbuffer", [&packet, &frame, albedo, normal, zbuffer, targetWidth, targetHeight](const FrameGraph::Context &ctx) {
+            FrameGraph::Resource targets[] = {albedo, normal};
+            ctx.bindFramebuffer(targets, 2, zbuffer);
+            if (Config::dynamicResolution) {
+                DynamicResolution::begin(targetWidth, targetHeight);
+            }
+            Renderer::drawGBuffer(packet.commands, frame);
+        });
+        graph.write(geometry, albedo);
+        graph.write(geometry, normal);
+        graph.write(geometry, zbuffer);
+
+        // Positions come back from the depth buffer, which stays attached for the light volumes' test
+        FrameGraph::Pass lighting = graph.addPass("deferred_lighting", [&packet, &frame, albedo, normal, zbuffer, color](const FrameGraph::Context &ctx) {
+            ctx.bindFramebuffer(&color, 1, zbuffer);
+            Renderer::drawDeferredLighting(packet.commands, frame, ctx.texture(albedo), ctx.texture(normal), ctx.texture(zbuffer));
+        });
+        graph.read(lighting, albedo);
+        graph.read(lighting, normal);
+        graph.read(lighting, zbuffer);
+        graph.write(lighting, color);
+
+        FrameGraph::Pass present = graph.addPass("deferred_present", [color, backbuffer, targetWidth, targetHeight, width, height](const FrameGraph::Context &ctx) {
+            if (Config::dynamicResolution) {
+                ctx.bindFramebuffer(&backbuffer, 1, -1);
+                DynamicResolution::upscale(ctx.texture(color), targetWidth, targetHeight, width, height);
+                return;
+            }
+            ctx.bindFramebuffer(&color, 1, -1);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, targetWidth, targetHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        });
+        graph.read(present, color);
+        graph.write(present, backbuffer);
+    }
+
+    // Debug view of the forward pass: fragments shaded per pixel instead of the scene
+    void buildOverdraw(FrameGraph &graph, const FramePacket &packet, const Renderer::Frame &frame, FrameGraph::Resource backbuffer) {
+        RenderTargetDesc countDesc = RenderTargets::window(GL_R16F);
+        FrameGraph::Resource counts = graph.create("overdraw_counts", countDesc);
+        FrameGraph::Resource depth = graph.create("overdraw_depth", RenderTargets::window(GL_DEPTH24_STENCIL8));
+        int targetWidth = countDesc.resolvedWidth();
+        int targetHeight = countDesc.resolvedHeight();
+
+        FrameGraph::Pass count = graph.addPass("overdraw_count", [&packet, &frame, counts, depth, targetWidth, targetHeight](const FrameGraph::Context &ctx) {
+            ctx.bindFramebuffer(&counts, 1, depth);
+            Renderer::drawOverdraw(packet.commands, frame, targetWidth, targetHeight);
+        });
+        graph.write(count, counts);
+        graph.write(count, depth);
+
+        FrameGraph::Pass show = graph.addPass("overdraw_show", [counts, backbuffer](const FrameGraph::Context &ctx) {
+            ctx.bindFramebuffer(&backbuffer, 1, -1);
+            Renderer::showOverdraw(ctx.texture(counts));
+        });
+        graph.read(show, counts);
+        graph.write(show, backbuffer);
+    }
+
+    // Declare this frame's passes, the graph decides what runs and in which order
+    void buildFrame(FrameGraph &graph, const FramePacket &packet, const Renderer::Frame &frame, int width, int height) {
+        graph.reset();
+        FrameGraph::Resource backbuffer = graph.import("backbuffer", 0);
+
+        // Declared first so it runs first. The maps persist between frames, outside the graph's resources
+        if (Config::shadows && Config::renderer != "soft" && !Config::overdraw) {
+            FrameGraph::Pass shadows = graph.addPass("shadows", [&packet, &frame, width, height](const FrameGraph::Context &) {
+                Shadows::update(packet.casters, frame);
+                GLState::viewport(0, 0, width, height);
+            });
+            graph.sideEffect(shadows);
+        }
+
+        if (Config::renderer == "soft") {
+            // Drawn on the CPU at window size and copied over
+            FrameGraph::Pass scene = graph.addPass("scene", [&packet, &frame, backbuffer, width, height](const FrameGraph::Context &ctx) {
+                ctx.bindFramebuffer(&backbuffer, 1, -1);
+                SoftRaster::draw(packet.commands, frame, width, height);
+                SoftRaster::present();
+            });
+            graph.write(scene, backbuffer);
+        } else if (Config::overdraw) {
+            buildOverdraw(graph, packet, frame, backbuffer);
+        } else if (Config::renderer == "deferred") {
+            buildDeferred(graph, packet, frame, backbuffer, width, height);
+        } else if (!Config::dynamicResolution) {
+            FrameGraph::Pass scene = graph.addPass("scene", [&packet, &frame, backbuffer](const FrameGraph::Context &ctx) {
+                ctx.bindFramebuffer(&backbuffer, 1, -1);
+                Renderer::draw(packet.commands, frame);
+            });
+            graph.write(scene, backbuffer);
+        } else {
+            // Scene at full window size, rendered into the scaled corner and upscaled
+            RenderTargetDesc colorDesc = RenderTargets::window(GL_RGBA8);
+            FrameGraph::Resource color = graph.create("scene_color", colorDesc);
+            FrameGraph::Resource depth = graph.create("scene_depth", RenderTargets::window(GL_DEPTH24_STENCIL8));
+            int targetWidth = colorDesc.resolvedWidth();
+            int targetHeight = colorDesc.resolvedHeight();
+
+            FrameGraph::Pass scene = graph.addPass("scene", [&packet, &frame, color, depth, targetWidth, targetHeight](const FrameGraph::Context &ctx) {
+                ctx.bindFramebuffer(&color, 1, depth);
+                DynamicResolution::begin(targetWidth, targetHeight);
+                Renderer::draw(packet.commands, frame);
+            });
+            graph.write(scene, color);
+            graph.write(scene, depth);
+
+            FrameGraph::Pass upscale = graph.addPass("upscale", [color, backbuffer, targetWidth, targetHeight, width, height](const FrameGraph::Context &ctx) {
+                ctx.bindFramebuffer(&backbuffer, 1, -1);
+                DynamicResolution::upscale(ctx.texture(color), targetWidth, targetHeight, width, height);
+            });
+            graph.read(upscale, color);
+            graph.write(upscale, backbuffer);
+        }
+
+        // Read back the finished image, declared last so it follows every backbuffer write
+        if (Capture::enabled()) {
+            FrameGraph::Pass capture = graph.addPass("capture", [backbuffer, width, height](const FrameGraph::Context &ctx) {
+                ctx.bindFramebuffer(&backbuffer, 1, -1);
+                glReadBuffer(GL_BACK);
+                Capture::frame(width, height);
+            });
+            graph.read(capture, backbuffer);
+            graph.sideEffect(capture);
+        }
+    }
+
+    void renderLoop(GLFWwindow* window) {
+        glfwMakeContextCurrent(window);
+
+        RenderThread::initContext();
+        FramePacer::init();
+
+        bool havePacket = false;
+        std::uint64_t measured = ~0ull;
+        while (running.load(std::memory_order_acquire)) {
+            // Wait for the GPU and the frame's start time before looking at input
+            FramePacer::beginFrame();
+
+            // Pick up the newest packet, keep interpolating the current one otherwise
+            if (packets.Acquire()) {
+                havePacket = true;
+            }
+            if (!havePacket) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+
+            // Follow window resizes reported by the main thread, skip drawing while minimised
+            int width = Window::framebufferWidth.load();
+            int height = Window::framebufferHeight.load();
+            if (width <= 0 || height <= 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            const FramePacket &packet = packets.ReadBuffer();
+            RenderThread::render(packet, glfwGetTime(), width, height);
+
+            // Input latency counts once per packet, later frames only re-interpolate it
+            FramePacer::endFrame(packet.sequence != measured ? packet.inputTime : 0.0);
+            measured = packet.sequence;
+
+            // swap buffers
+            glfwSwapBuffers(window);
+            Stats::report();
+        }
+
+        FramePacer::shutdown();
+        RenderThread::shutdownContext();
+        glfwMakeContextCurrent(NULL);
+    }
+}
+
+void RenderThread::start(GLFWwindow* window) {
+    // The context can only be current on one thread
+    glfwMakeContextCurrent(NULL);
+
+    running.store(true, std::memory_order_release);
+    thread = std::thread(renderLoop, window);
+}
+
+void RenderThread::stop() {
+    running.store(false, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+FramePacket& RenderThread::packet() {
+    return packets.WriteBuffer();
+}
+
+void RenderThread::publish() {
+    packets.WriteBuffer().sequence = nextSequence++;
+    packets.Publish();
+}
+
+bool RenderThread::pending() {
+    return packets.Pending();
+}
+
+void RenderThread::initContext() {
+    // Record from the first call so the trace holds everything its frames depend on
+    if (!Config::glTrace.empty()) {
+        GLTrace::begin(Config::glTrace, Config::glTraceFrames, Window::framebufferWidth.load(), Window::framebufferHeight.load());
+    }
+
+    // Load shaders, cubes and textures on the thread that owns the context
+    if (Config::renderer == "soft") {
+        SoftRaster::init();
+    } else {
+        Renderer::init();
+    }
+    Capture::init();
+    if (Config::dynamicResolution && Config::renderer != "soft") {
+        DynamicResolution::init();
+    }
+}
+
+void RenderThread::shutdownContext() {
+    Capture::shutdown();
+    Streaming::shutdownContext();
+    RenderTargets::clear();
+    GLTrace::end();
+}
+
+void RenderThread::render(const FramePacket &packet, double now, int width, int height) {
+    AllocTrack::Scope scope("alloc_render");
+    GLState::viewport(0, 0, width, height);
+    Renderer::Frame frame = makeFrame(packet, now, width, height);
+
+    // Streamed chunks finished since, a capped amount per frame
+    Streaming::upload(packet.streamFrame);
+
+    // Lit cubes on the GPU path, before any pass draws them
+    if (Config::gpuCulling) {
+        GpuCull::cull(frame.projection * frame.view, packet.occlusionDepth, packet.occlusionViewProjection);
+    }
+
+    RenderTargets::beginFrame();
+    buildFrame(graph, packet, frame, width, height);
+    graph.compile();
+    graph.execute();
+    GLTrace::endFrame();
+}
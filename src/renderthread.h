@@ -0,0 +1,30 @@
+#pragma once
+
+#include "./framepacket.h"
+
+#include <GLFW/glfw3.h>
+
+/**
+ * Thread that owns the GL context. It renders the newest frame packet the
+ * simulation published and swaps, so a slow swap never holds up input.
+ */
+
+namespace RenderThread {
+    // Release the context on the calling thread and start rendering on a new one
+    extern void start(GLFWwindow* window);
+
+    // Stop rendering and join the thread
+    extern void stop();
+
+    // Simulation side: fill the returned packet then publish it
+    extern FramePacket& packet();
+    extern void publish();
+
+    // True while the last published packet hasn't been picked up yet
+    extern bool pending();
+
+    // Context side, also used by the bench which renders on the main thread
+    extern void initContext();
+    extern void shutdownContext();
+    extern void render(const FramePacket &packet, double now, int width, int height);
+}
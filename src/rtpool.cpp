@@ -0,0 +1,291 @@
+#include "./rtpool.h"
+#include "./config.h"
+#include "./glstate.h"
+#include "./stats.h"
+#include "./window.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+    struct Attachment {
+        GLuint texture;
+        RenderTargetDesc desc;      // As requested
+        int width, height;          // As allocated
+        bool inUse;
+        unsigned long lastUsed;
+        std::size_t bytes;
+    };
+
+    struct CachedFramebuffer {
+        GLuint id;
+        GLuint colors[4];
+        int colorCount;
+        GLuint depth;
+    };
+
+    const int MAX_COLORS = 4;
+
+    std::vector<Attachment> attachments;
+    std::vector<CachedFramebuffer> framebuffers;
+    unsigned long frame = 0;
+
+    // Window size as the render thread last applied it, and as last reported
+    int windowWidth = 0, windowHeight = 0;
+    std::atomic<int> pendingWidth(0), pendingHeight(0);
+
+    struct FormatInfo {
+        GLenum internal;
+        GLenum format;
+        GLenum type;
+        std::size_t bytesPerPixel;
+    };
+
+    const FormatInfo FORMATS[] = {
+        {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+        {GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4},
+        {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8},
+        {GL_RGBA32F, GL_RGBA, GL_FLOAT, 16},
+        {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2},
+        {GL_RG16F, GL_RG, GL_HALF_FLOAT, 4},
+        {GL_RG16_SNORM, GL_RG, GL_SHORT, 4},
+        {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1},
+        {GL_R16F, GL_RED, GL_HALF_FLOAT, 2},
+        {GL_R32F, GL_RED, GL_FLOAT, 4},
+        {GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, 4},
+        {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4},
+        {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4},
+        {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4}
+    };
+
+    const FormatInfo& formatInfo(GLenum internal) {
+        for (const FormatInfo &info : FORMATS) {
+            if (info.internal == internal) {
+                return info;
+            }
+        }
+        std::cout << "ERROR::RENDER_TARGETS::UNKNOWN_FORMAT " << internal << std::endl;
+        return FORMATS[0];
+    }
+
+    bool isDepthFormat(GLenum internal) {
+        GLenum format = formatInfo(internal).format;
+        return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL;
+    }
+
+    bool matches(const Attachment &a, const RenderTargetDesc &desc) {
+        return a.desc.format == desc.format && a.desc.samples == desc.samples
+            && a.width == desc.resolvedWidth() && a.height == desc.resolvedHeight();
+    }
+
+    // Delete every cached framebuffer that uses texture
+    void dropFramebuffers(GLuint texture) {
+        for (std::size_t i = 0; i < framebuffers.size();) {
+            CachedFramebuffer &fb = framebuffers[i];
+            bool uses = fb.depth == texture;
+            for (int c = 0; c < fb.colorCount; c++) {
+                uses = uses || fb.colors[c] == texture;
+            }
+            if (uses) {
+                glDeleteFramebuffers(1, &fb.id);
+                framebuffers[i] = framebuffers.back();
+                framebuffers.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    void destroy(std::size_t index) {
+        Attachment &a = attachments[index];
+        dropFramebuffers(a.texture);
+        GLState::deleteTexture(a.texture);
+        attachments[index] = attachments.back();
+        attachments.pop_back();
+    }
+
+    Attachment create(const RenderTargetDesc &desc) {
+        Attachment a;
+        a.desc = desc;
+        a.width = desc.resolvedWidth();
+        a.height = desc.resolvedHeight();
+        a.inUse = false;
+        a.lastUsed = frame;
+
+        a.bytes = RenderTargets::bytes(desc);
+
+        glGenTextures(1, &a.texture);
+        if (desc.samples > 1) {
+            GLState::bindTexture(GL_TEXTURE_2D_MULTISAMPLE, a.texture);
+            glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, desc.samples, desc.format, a.width, a.height, GL_TRUE);
+        } else {
+            const FormatInfo &info = formatInfo(desc.format);
+            GLState::bindTexture(GL_TEXTURE_2D, a.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, desc.format, a.width, a.height, 0, info.format, info.type, NULL);
+            GLint filter = isDepthFormat(desc.format) || info.format == GL_RED_INTEGER ? GL_NEAREST : GL_LINEAR;
+            GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+            GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+            GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        return a;
+    }
+}
+
+int RenderTargetDesc::resolvedWidth() const {
+    return width > 0 ? width : std::max(1, (int)std::lround(windowWidth * scale));
+}
+
+int RenderTargetDesc::resolvedHeight() const {
+    return height > 0 ? height : std::max(1, (int)std::lround(windowHeight * scale));
+}
+
+RenderTargetDesc RenderTargets::window(GLenum format, float scale, int samples) {
+    RenderTargetDesc desc = {0, 0, scale, format, samples};
+    return desc;
+}
+
+RenderTargetDesc RenderTargets::fixed(int width, int height, GLenum format, int samples) {
+    RenderTargetDesc desc = {width, height, 1.0f, format, samples};
+    return desc;
+}
+
+void RenderTargets::beginFrame() {
+    frame++;
+
+    // Window size changes apply here, textures of the old size become idle and age out
+    if (windowWidth == 0) {
+        pendingWidth.store(Window::framebufferWidth.load());
+        pendingHeight.store(Window::framebufferHeight.load());
+    }
+    int width = pendingWidth.load();
+    int height = pendingHeight.load();
+    bool resized = width > 0 && height > 0 && (width != windowWidth || height != windowHeight);
+    if (resized) {
+        windowWidth = width;
+        windowHeight = height;
+    }
+
+    for (std::size_t i = 0; i < attachments.size();) {
+        Attachment &a = attachments[i];
+        bool stale = resized && a.desc.width == 0 && !matches(a, a.desc);
+        bool idle = frame - a.lastUsed > (unsigned long)Config::renderTargetEvictFrames;
+        if (!a.inUse && (stale || idle)) {
+            destroy(i);
+        } else {
+            i++;
+        }
+    }
+
+    Stats::set("render_target_mb", memory() / (1024.0 * 1024.0));
+    Stats::set("render_targets", attachments.size());
+}
+
+GLuint RenderTargets::acquire(const RenderTargetDesc &desc) {
+    for (Attachment &a : attachments) {
+        if (!a.inUse && matches(a, desc)) {
+            a.inUse = true;
+            a.lastUsed = frame;
+            return a.texture;
+        }
+    }
+
+    attachments.push_back(create(desc));
+    attachments.back().inUse = true;
+    return attachments.back().texture;
+}
+
+void RenderTargets::release(GLuint texture) {
+    for (Attachment &a : attachments) {
+        if (a.texture == texture) {
+            a.inUse = false;
+            a.lastUsed = frame;
+            return;
+        }
+    }
+}
+
+GLuint RenderTargets::framebuffer(const GLuint *colors, int colorCount, GLuint depth) {
+    colorCount = std::min(colorCount, MAX_COLORS);
+
+    for (const CachedFramebuffer &fb : framebuffers) {
+        if (fb.colorCount == colorCount && fb.depth == depth && std::equal(colors, colors + colorCount, fb.colors)) {
+            return fb.id;
+        }
+    }
+
+    CachedFramebuffer fb;
+    fb.colorCount = colorCount;
+    fb.depth = depth;
+    std::copy(colors, colors + colorCount, fb.colors);
+
+    glGenFramebuffers(1, &fb.id);
+    glBindFramebuffer(GL_FRAMEBUFFER, fb.id);
+
+    GLenum drawBuffers[MAX_COLORS];
+    for (int c = 0; c < colorCount; c++) {
+        const Attachment *a = nullptr;
+        for (const Attachment &candidate : attachments) {
+            if (candidate.texture == colors[c]) {
+                a = &candidate;
+            }
+        }
+        GLenum target = a && a->desc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + c, target, colors[c], 0);
+        drawBuffers[c] = GL_COLOR_ATTACHMENT0 + c;
+    }
+    if (colorCount > 0) {
+        glDrawBuffers(colorCount, drawBuffers);
+    } else {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    if (depth) {
+        GLenum point = GL_DEPTH_ATTACHMENT;
+        GLenum target = GL_TEXTURE_2D;
+        for (const Attachment &a : attachments) {
+            if (a.texture == depth) {
+                point = formatInfo(a.desc.format).format == GL_DEPTH_STENCIL ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                target = a.desc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+            }
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER, point, target, depth, 0);
+    }
+
+    // Validated once, cached framebuffers are known to be complete
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::RENDER_TARGETS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    framebuffers.push_back(fb);
+    return fb.id;
+}
+
+void RenderTargets::resize(int width, int height) {
+    pendingWidth.store(width);
+    pendingHeight.store(height);
+}
+
+std::size_t RenderTargets::bytes(const RenderTargetDesc &desc) {
+    const FormatInfo &info = formatInfo(desc.format);
+    return (std::size_t)desc.resolvedWidth() * desc.resolvedHeight() * info.bytesPerPixel * std::max(1, desc.samples);
+}
+
+std::size_t RenderTargets::memory() {
+    std::size_t total = 0;
+    for (const Attachment &a : attachments) {
+        total += a.bytes;
+    }
+    return total;
+}
+
+void RenderTargets::clear() {
+    while (!attachments.empty()) {
+        destroy(attachments.size() - 1);
+    }
+}
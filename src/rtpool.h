@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+/**
+ * Pool of render target textures and the framebuffers built from them.
+ * Passes acquire attachments by (size, format, samples) and release them
+ * when done, so the textures get recycled between passes and frames.
+ * Textures nobody asked for in a while are evicted. Render thread only,
+ * except resize.
+ */
+
+struct RenderTargetDesc {
+    int width, height;  // Pixels, 0 to follow the window size times scale
+    float scale;
+    GLenum format;      // Sized internal format e.g: GL_RGBA8, GL_DEPTH24_STENCIL8
+    int samples;        // 1 for a plain GL_TEXTURE_2D
+
+    // Size the attachment ends up with right now
+    int resolvedWidth() const;
+    int resolvedHeight() const;
+};
+
+namespace RenderTargets {
+    // Descriptor that follows the window size
+    extern RenderTargetDesc window(GLenum format, float scale = 1.0f, int samples = 1);
+
+    // Descriptor with a fixed size
+    extern RenderTargetDesc fixed(int width, int height, GLenum format, int samples = 1);
+
+    // Advance the frame counter, apply a pending resize and evict idle textures
+    extern void beginFrame();
+
+    // Get a texture matching desc, recycled if possible. Release it when the pass is done
+    extern GLuint acquire(const RenderTargetDesc &desc);
+    extern void release(GLuint texture);
+
+    // Framebuffer with these attachments, created and validated once. depth may be 0
+    extern GLuint framebuffer(const GLuint *colors, int colorCount, GLuint depth);
+
+    // Window size changed, safe to call from any thread. Applied by the next beginFrame
+    extern void resize(int width, int height);
+
+    // Bytes a texture matching desc takes
+    extern std::size_t bytes(const RenderTargetDesc &desc);
+
+    // Bytes of texture memory currently owned by the pool
+    extern std::size_t memory();
+
+    // Delete everything, e.g. before the context goes away
+    extern void clear();
+}
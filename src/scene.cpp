@@ -0,0 +1,119 @@
+#include "./scene.h"
+#include "./config.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+const std::size_t Scene::PARTITION_SIZE = 256;
+
+std::vector<Scene::Instance> Scene::instances;
+std::vector<Scene::Instance> Scene::resident;
+std::vector<Scene::Light> Scene::lights;
+
+namespace {
+    std::atomic<bool> moved(false);
+
+    Scene::Instance makeInstance(const glm::vec3 &position, const glm::vec3 &scale, Scene::Material material) {
+        Scene::Instance instance;
+        instance.position = position;
+        instance.previousPosition = position;
+        instance.scale = scale;
+        instance.material = material;
+        instance.model = glm::mat4(1.0f);
+        instance.previousModel = glm::mat4(1.0f);
+        instance.radius = 0.0f;
+        instance.mesh = 0;
+
+        // Cubes only have full detail
+        instance.lodError[0] = 0.0f;
+        for (int level = 1; level < Lod::LEVELS; level++) {
+            instance.lodError[level] = -1.0f;
+        }
+        instance.lod = 0;
+        return instance;
+    }
+
+    void updateTransform(Scene::Instance &instance) {
+        instance.model = glm::translate(glm::mat4(1.0f), instance.position);
+        instance.model = glm::scale(instance.model, instance.scale);
+        instance.previousModel = glm::translate(glm::mat4(1.0f), instance.previousPosition);
+        instance.previousModel = glm::scale(instance.previousModel, instance.scale);
+
+        // Unit cube, so the half diagonal of the largest axis bounds it
+        float largest = std::max(instance.scale.x, std::max(instance.scale.y, instance.scale.z));
+        instance.radius = 0.8660254f * largest;
+    }
+}
+
+std::size_t Scene::add(const glm::vec3 &position, const glm::vec3 &scale, Material material) {
+    Scene::instances.push_back(makeInstance(position, scale, material));
+    return Scene::instances.size() - 1;
+}
+
+std::size_t Scene::addStatic(const glm::vec3 &position, const glm::vec3 &scale) {
+    if (!Config::gpuCulling) {
+        return add(position, scale, LIT);
+    }
+
+    // Nothing updates it after this
+    Instance instance = makeInstance(position, scale, LIT);
+    updateTransform(instance);
+    Scene::resident.push_back(instance);
+    return RESIDENT | (Scene::resident.size() - 1);
+}
+
+std::size_t Scene::addLight(const glm::vec3 &position, const glm::vec3 &color, float radius) {
+    Light light;
+    light.position = position;
+    light.radius = radius;
+    light.color = color;
+
+    Scene::lights.push_back(light);
+    return Scene::lights.size() - 1;
+}
+
+void Scene::addRandomLights(std::size_t count, const glm::vec3 &min, const glm::vec3 &max, float radius, unsigned int seed) {
+    // Small LCG so the same seed gives the same lights everywhere
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / 16777216.0f;
+    };
+
+    for (std::size_t i = 0; i < count; i++) {
+        glm::vec3 position = glm::mix(min, max, glm::vec3(next(), next(), next()));
+        glm::vec3 color(next(), next(), next());
+        addLight(position, color, radius * (0.5f + 0.5f * next()));
+    }
+}
+
+std::size_t Scene::partitionCount() {
+    return (Scene::instances.size() + PARTITION_SIZE - 1) / PARTITION_SIZE;
+}
+
+void Scene::saveState() {
+    for (Instance &instance : Scene::instances) {
+        instance.previousPosition = instance.position;
+    }
+}
+
+void Scene::updateTransforms(std::size_t partition) {
+    std::size_t begin = partition * PARTITION_SIZE;
+    std::size_t end = std::min(begin + PARTITION_SIZE, Scene::instances.size());
+
+    bool changed = false;
+    for (std::size_t i = begin; i < end; i++) {
+        Instance &instance = Scene::instances[i];
+        glm::mat4 before = instance.model;
+        updateTransform(instance);
+        changed = changed || instance.model != before;
+    }
+    if (changed) {
+        moved.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool Scene::takeMoved() {
+    return moved.exchange(false, std::memory_order_relaxed);
+}
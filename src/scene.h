@@ -0,0 +1,63 @@
+#pragma once
+
+#include "./lod.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Flat list of the objects in the world, split into fixed size partitions
+ * so transform updates and culling can run as one job per partition. With
+ * GPU culling, static lit cubes go to a list of their own instead, which
+ * GpuCull uploads once and the CPU side never updates or culls.
+ */
+
+namespace Scene {
+    // How an instance is shaded
+    enum Material {
+        LIT,    // Textured phong cube
+        LAMP,   // Unlit light cube
+        CHUNK,  // Voxel chunk mesh, lit like the cubes
+        MATERIAL_COUNT
+    };
+
+    struct Instance {
+        glm::vec3 position;
+        glm::vec3 previousPosition; // Position after the step before, for render interpolation
+        glm::vec3 scale;
+        Material material;
+        glm::mat4 model;            // Updated from position and scale by updateTransforms
+        glm::mat4 previousModel;    // Same for previousPosition
+        float radius;       // Bounding sphere radius around position
+        std::uint32_t mesh;         // Index into Voxels::meshes for CHUNK instances, or a Streaming slot
+        float lodError[Lod::LEVELS];    // World units each mesh level is off by, negative for levels it lacks
+        std::uint8_t lod;           // Level it was last drawn at, Lod::IMPOSTOR for a billboard
+    };
+
+    // Point light, falls off to nothing at radius
+    struct Light {
+        glm::vec3 position;
+        float radius;
+        glm::vec3 color;
+    };
+
+    extern const std::size_t PARTITION_SIZE;    // Instances per partition
+    const std::uint32_t RESIDENT = 0x80000000u; // Flag on indices into resident rather than instances
+    extern std::vector<Instance> instances;
+    extern std::vector<Instance> resident;      // Static lit cubes GpuCull draws, transforms set when added
+    extern std::vector<Light> lights;
+
+    extern std::size_t add(const glm::vec3 &position, const glm::vec3 &scale, Material material);
+    // A lit cube that never moves. Goes to resident with GPU culling, returning its index there with
+    // RESIDENT set, and is added like any other without
+    extern std::size_t addStatic(const glm::vec3 &position, const glm::vec3 &scale);
+    extern std::size_t addLight(const glm::vec3 &position, const glm::vec3 &color, float radius);
+    extern void addRandomLights(std::size_t count, const glm::vec3 &min, const glm::vec3 &max, float radius, unsigned int seed);
+    extern std::size_t partitionCount();
+    extern void saveState();    // Remember positions before a simulation step
+    extern void updateTransforms(std::size_t partition);
+    extern bool takeMoved();    // Whether updateTransforms changed a transform since the last call
+}
@@ -3,7 +3,10 @@
 
 #include <glad/glad.h>
 
+#include "./glstate.h"
+
 #include <string>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -78,36 +81,66 @@ public:
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::useProgram(ID); 
     }
-    // utility uniform functions
+    // utility uniform functions, names are string literals so their locations can be cached
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(const char* name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(location(name), (int)value); 
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(const char* name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(location(name), value); 
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(const char* name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(location(name), value); 
+    }
+    void setVec2(const char* name, const glm::vec2 &value) const
+    {
+        glUniform2fv(location(name), 1, &value[0]);
     }
-    void setMat4(const std::string &name, glm::mat4 matrix) const
+    void setMat4(const char* name, const glm::mat4 &matrix) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(matrix));
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(matrix));
     }
-    void setVec3(const std::string &name, const glm::vec3 &value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    void setVec3(const char* name, const glm::vec3 &value) const {
+        glUniform3fv(location(name), 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    void setVec3(const char* name, float x, float y, float z) const {
+        glUniform3f(location(name), x, y, z);
     }
 
 private:
+    // Uniform locations looked up so far, a handful per shader
+    static const int MAX_LOCATIONS = 32;
+    struct Location {
+        const char* name;
+        GLint location;
+    };
+    mutable Location locations[MAX_LOCATIONS];
+    mutable int locationCount = 0;
+
+    GLint location(const char* name) const
+    {
+        // Literals usually compare equal by pointer, the string compare catches duplicates
+        for (int i = 0; i < locationCount; i++) {
+            if (locations[i].name == name || std::strcmp(locations[i].name, name) == 0) {
+                return locations[i].location;
+            }
+        }
+        GLint found = glGetUniformLocation(ID, name);
+        if (locationCount < MAX_LOCATIONS) {
+            locations[locationCount].name = name;
+            locations[locationCount].location = found;
+            locationCount++;
+        }
+        return found;
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aCentreRadius;    // Per cube, written by gpuCull.comp
+layout (location = 4) in vec4 aScale;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec4 ClipPos;
+out float ViewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    // Translation and scale only, so the normal matrix is the inverse scale
+    FragPos = aCentreRadius.xyz + aPos * aScale.xyz;
+    Normal = aNormal / aScale.xyz;
+    TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+    vec4 viewPos = view * vec4(FragPos, 1.0);
+    ViewDepth = -viewPos.z;
+    ClipPos = projection * viewPos;
+    gl_Position = ClipPos;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+flat out vec4 LightPosRadius;
+flat out vec3 LightColor;
+out vec4 ClipPos;
+
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+
+void main() {
+    // Fullscreen triangle from the vertex id, no buffers needed
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    ClipPos = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+    gl_Position = ClipPos;
+
+    // No radius: the scene's main light, lit everywhere and with ambient
+    LightPosRadius = vec4(lightPos, 0.0);
+    LightColor = lightColor;
+}
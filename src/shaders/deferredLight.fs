@@ -0,0 +1,90 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec4 LightPosRadius;    // Radius 0 for the main light
+flat in vec3 LightColor;
+in vec4 ClipPos;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;       // The hardware depth buffer, 1 where nothing was drawn
+uniform vec3 viewPos;
+uniform mat4 inverseProjection;
+uniform mat4 inverseView;
+
+// Main light only: the sun, off when black, and the shadow maps, see shadows.h
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+uniform bool shadows;
+uniform samplerCubeShadow lightShadow;
+uniform float lightShadowFar;
+uniform sampler2DArrayShadow sunShadow;
+uniform mat4 sunMatrices[3];
+uniform float sunTexels[3];
+
+float lightShadowFactor(vec3 position) {
+    vec3 toFragment = position - LightPosRadius.xyz;
+    float reference = length(toFragment) / lightShadowFar;
+    if (!shadows || reference >= 1.0) {
+        return 1.0;
+    }
+    return texture(lightShadow, vec4(toFragment, reference - 0.002));
+}
+
+float sunShadowFactor(vec3 position, vec3 norm) {
+    if (!shadows) {
+        return 1.0;
+    }
+    for (int i = 0; i < 3; i++) {
+        vec3 p = (sunMatrices[i] * vec4(position + norm * sunTexels[i] * 1.5, 1.0)).xyz;
+        if (all(lessThan(abs(p), vec3(0.95, 0.95, 1.0)))) {
+            return texture(sunShadow, vec4(p.xy * 0.5 + 0.5, float(i), p.z * 0.5 + 0.5));
+        }
+    }
+    return 1.0;
+}
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    if (depth >= 1.0) {
+        discard;
+    }
+
+    // Back to view space through the inverse projection, then to world space
+    vec4 ndc = vec4(ClipPos.xy / ClipPos.w, depth * 2.0 - 1.0, 1.0);
+    vec4 view = inverseProjection * ndc;
+    vec3 position = vec3(inverseView * vec4(view.xyz / view.w, 1.0));
+    vec4 albedo = texelFetch(gAlbedo, texel, 0);
+    vec3 norm = decodeNormal(texelFetch(gNormal, texel, 0).xy);
+
+    vec3 toLight = LightPosRadius.xyz - position;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / max(distance, 0.0001);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 viewDir = normalize(viewPos - position);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = albedo.a * pow(max(dot(viewDir, reflectDir), 0.0), 32);
+
+    vec3 result;
+    if (LightPosRadius.w > 0.0) {
+        float falloff = clamp(1.0 - distance / LightPosRadius.w, 0.0, 1.0);
+        result = (diff + spec) * falloff * falloff * LightColor;
+    } else {
+        result = (0.1 + (diff + spec) * lightShadowFactor(position)) * LightColor;
+        if (sunColor != vec3(0.0)) {
+            vec3 sunDir = -sunDirection;
+            float sunDiff = max(dot(norm, sunDir), 0.0);
+            float sunSpec = albedo.a * pow(max(dot(viewDir, reflect(-sunDir, norm)), 0.0), 32);
+            result += (sunDiff + sunSpec) * sunColor * sunShadowFactor(position, norm);
+        }
+    }
+    FragColor = vec4(result * albedo.rgb, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aLight;   // Position and radius, per instance
+layout (location = 2) in vec3 aColor;   // Per instance
+layout (location = 3) in vec3 aNormal;
+
+flat out vec4 LightPosRadius;
+flat out vec3 LightColor;
+out vec4 ClipPos;
+
+uniform mat4 viewProjection;
+uniform vec3 viewPos;
+
+void main() {
+    LightPosRadius = aLight;
+    LightColor = aColor;
+
+    // Lamp cube scaled to enclose the light's sphere
+    vec3 position = aLight.xyz + aPos * 2.0 * aLight.w;
+    ClipPos = viewProjection * vec4(position, 1.0);
+
+    // Only the back faces should shade: faces towards the camera collapse to a point.
+    // The cube's winding isn't consistent enough to leave this to face culling
+    if (dot(aNormal, viewPos - position) > 0.0) {
+        ClipPos = vec4(2.0, 2.0, 2.0, 1.0);
+    }
+    gl_Position = ClipPos;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Same expression as lightingShader.vs, so the lit pass can test against this depth with GL_LEQUAL
+invariant gl_Position;
+
+void main() {
+    vec3 FragPos = vec3(model * vec4(aPos, 1.0));
+    vec4 viewPos = view * vec4(FragPos, 1.0);
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,36 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedo;     // Texture times object color, specular strength in alpha
+layout (location = 1) out vec2 gNormal;     // Octahedral encoded
+
+in vec3 Normal;
+in vec2 TexCoord;
+
+uniform vec3 objectColor;
+uniform sampler2D texture1;
+
+// Billboards linked with impostor.vs, texture1 is then the atlas albedo
+uniform bool impostor;
+uniform sampler2D impostorNormals;
+
+// Unit vector folded onto the octahedron and flattened to two components
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy;
+}
+
+void main() {
+    vec4 albedo = texture(texture1, TexCoord);
+    vec3 norm = normalize(Normal);
+    if (impostor) {
+        if (albedo.a < 0.5) {
+            discard;
+        }
+        norm = normalize(texture(impostorNormals, TexCoord).xyz * 2.0 - 1.0);
+    }
+
+    gAlbedo = vec4(albedo.rgb * objectColor, 0.5);
+    gNormal = encodeNormal(norm);
+}
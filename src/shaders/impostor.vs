@@ -0,0 +1,46 @@
+#version 330 core
+layout (location = 3) in vec4 aCentreRadius;    // Per billboard
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec4 ClipPos;
+out float ViewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform vec2 atlasCells;    // Yaws, pitches
+
+const float PI = 3.14159265;
+
+// Where the atlas cell was captured from, the same as impostorDirection in renderer.cpp
+vec3 cellDirection(vec2 cell) {
+    float yaw = cell.x * 2.0 * PI / atlasCells.x;
+    float pitch = (cell.y + 0.5) * PI / atlasCells.y - 0.5 * PI;
+    return vec3(cos(pitch) * sin(yaw), sin(pitch), cos(pitch) * cos(yaw));
+}
+
+void main() {
+    // The cell captured nearest the direction the camera sees the cube from
+    vec3 toCamera = normalize(viewPos - aCentreRadius.xyz);
+    float yaw = atan(toCamera.x, toCamera.z);
+    float pitch = asin(clamp(toCamera.y, -1.0, 1.0));
+    vec2 cell = vec2(mod(floor(yaw * atlasCells.x / (2.0 * PI) + 0.5), atlasCells.x),
+                     clamp(floor((pitch + 0.5 * PI) * atlasCells.y / PI), 0.0, atlasCells.y - 1.0));
+
+    // Facing that direction like the capture camera did, so the cell maps onto the quad exactly
+    vec3 direction = cellDirection(cell);
+    vec3 right = normalize(cross(-direction, vec3(0.0, 1.0, 0.0)));
+    vec3 up = cross(right, -direction);
+
+    // Triangle strip corners from the vertex id
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    FragPos = aCentreRadius.xyz + (right * corner.x + up * corner.y) * aCentreRadius.w;
+    Normal = direction;
+    TexCoord = (cell + corner * 0.5 + 0.5) / atlasCells;
+    vec4 viewPosition = view * vec4(FragPos, 1.0);
+    ViewDepth = -viewPosition.z;
+    ClipPos = projection * viewPosition;
+    gl_Position = ClipPos;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) out vec4 albedo;      // Texture, coverage in alpha
+layout (location = 1) out vec4 normal;      // World normal scaled into 0 to 1
+
+in vec3 Normal;
+in vec2 TexCoord;
+
+uniform sampler2D texture1;
+
+void main() {
+    albedo = vec4(texture(texture1, TexCoord).rgb, 1.0);
+    normal = vec4(normalize(Normal) * 0.5 + 0.5, 1.0);
+}
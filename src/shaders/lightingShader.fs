@@ -4,6 +4,8 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoord;
+in vec4 ClipPos;
+in float ViewDepth;
 
 uniform vec3 objectColor;
 uniform vec3 lightColor;
@@ -11,13 +13,81 @@ uniform vec3 lightPos;
 uniform vec3 viewPos;
 uniform sampler2D texture1;
 
+// Billboards linked with impostor.vs, texture1 is then the atlas albedo
+uniform bool impostor;
+uniform sampler2D impostorNormals;
+
+// Point lights, see clusters.h
+uniform samplerBuffer clusterLights;    // Two texels per light: position and radius, color
+uniform usamplerBuffer clusterGrid;     // Offset and count in clusterIndices per cluster
+uniform usamplerBuffer clusterIndices;  // Light numbers, grouped by cluster
+uniform vec3 clusterDims;
+uniform vec2 clusterDepth;              // Slice is log(depth) * x + y
+
+// Sun, off when its color is black
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+// Shadow maps, see shadows.h
+uniform bool shadows;
+uniform samplerCubeShadow lightShadow;  // Distance to the main light over lightShadowFar
+uniform float lightShadowFar;
+uniform sampler2DArrayShadow sunShadow; // One cascade per layer
+uniform mat4 sunMatrices[3];
+uniform float sunTexels[3];             // World size of a texel of each cascade
+
+float lightShadowFactor(vec3 position) {
+    vec3 toFragment = position - lightPos;
+    float reference = length(toFragment) / lightShadowFar;
+    if (!shadows || reference >= 1.0) {
+        return 1.0;
+    }
+    return texture(lightShadow, vec4(toFragment, reference - 0.002));
+}
+
+// The first cascade holding the point, pushed out along the normal by a texel and a half against acne
+float sunShadowFactor(vec3 position, vec3 norm) {
+    if (!shadows) {
+        return 1.0;
+    }
+    for (int i = 0; i < 3; i++) {
+        vec3 p = (sunMatrices[i] * vec4(position + norm * sunTexels[i] * 1.5, 1.0)).xyz;
+        if (all(lessThan(abs(p), vec3(0.95, 0.95, 1.0)))) {
+            return texture(sunShadow, vec4(p.xy * 0.5 + 0.5, float(i), p.z * 0.5 + 0.5));
+        }
+    }
+    return 1.0;
+}
+
+// Diffuse and specular from one point light, reaching zero at its radius
+vec3 pointLight(vec4 positionRadius, vec3 color, vec3 norm, vec3 viewDir) {
+    vec3 toLight = positionRadius.xyz - FragPos;
+    float distance = length(toLight);
+    float falloff = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+    falloff *= falloff;
+
+    vec3 lightDir = toLight / max(distance, 0.0001);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    return (diff + 0.5 * spec) * falloff * color;
+}
+
 void main() {
+    vec4 albedo = texture(texture1, TexCoord);
+    vec3 norm = normalize(Normal);
+    if (impostor) {
+        if (albedo.a < 0.5) {
+            discard;
+        }
+        norm = normalize(texture(impostorNormals, TexCoord).xyz * 2.0 - 1.0);
+    }
+
     // Ambient:
     float ambientStrength = 0.1;
     vec3 ambient = ambientStrength * lightColor;
 
     // Diffuse:
-    vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(lightPos - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
@@ -29,6 +99,27 @@ void main() {
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
     vec3 specular = specularStrength * spec * lightColor;
 
-    vec3 result = (ambient + diffuse + specular) * objectColor;
-    FragColor = texture(texture1, TexCoord) * vec4(result, 1.0);
+    vec3 result = ambient + (diffuse + specular) * lightShadowFactor(FragPos);
+
+    // Sun
+    if (sunColor != vec3(0.0)) {
+        vec3 sunDir = -sunDirection;
+        float sunDiff = max(dot(norm, sunDir), 0.0);
+        float sunSpec = pow(max(dot(viewDir, reflect(-sunDir, norm)), 0.0), 32);
+        result += (sunDiff + specularStrength * sunSpec) * sunColor * sunShadowFactor(FragPos, norm);
+    }
+
+    // Point lights touching this fragment's cluster
+    vec2 ndc = ClipPos.xy / ClipPos.w;
+    vec3 cell = vec3((ndc * 0.5 + 0.5) * clusterDims.xy, log(ViewDepth) * clusterDepth.x + clusterDepth.y);
+    ivec3 c = ivec3(clamp(floor(cell), vec3(0.0), clusterDims - 1.0));
+    int cluster = c.x + int(clusterDims.x) * (c.y + int(clusterDims.y) * c.z);
+    uvec2 range = texelFetch(clusterGrid, cluster).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        result += pointLight(texelFetch(clusterLights, light * 2), texelFetch(clusterLights, light * 2 + 1).rgb, norm, viewDir);
+    }
+
+    result *= objectColor;
+    FragColor = vec4(albedo.rgb * result, 1.0);
 }
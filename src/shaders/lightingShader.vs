@@ -6,14 +6,22 @@ layout (location = 2) in vec2 aTexCoord;
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+out vec4 ClipPos;
+out float ViewDepth;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Matches depthOnly.vs exactly for the depth pre-pass
+invariant gl_Position;
+
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    vec4 viewPos = view * vec4(FragPos, 1.0);
+    ViewDepth = -viewPos.z;
+    ClipPos = projection * viewPos;
+    gl_Position = ClipPos;
 }
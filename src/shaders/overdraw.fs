@@ -0,0 +1,7 @@
+#version 330 core
+out float Count;
+
+void main() {
+    // Blended additively, so each pixel ends up with the fragments that reached it
+    Count = 1.0;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D counts;
+
+void main() {
+    // Black for nothing, then blue, green, yellow and red from one to four or more fragments
+    float count = texture(counts, TexCoord).r;
+    vec3 ramp[5] = vec3[](vec3(0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0));
+    FragColor = vec4(ramp[int(clamp(count + 0.5, 0.0, 4.0))], 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+in vec3 FragPos;
+
+uniform vec3 lightPos;
+uniform float far;
+
+void main() {
+    // Distance rather than depth, so one lookup direction works across all six faces
+    gl_FragDepth = length(FragPos - lightPos) / far;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D source;
+uniform vec2 uvScale;
+uniform int sharpen;
+uniform float sharpness;
+
+void main() {
+    // Stay inside the rendered region so bilinear taps don't pick up stale texels
+    vec2 texel = 1.0 / vec2(textureSize(source, 0));
+    vec2 uv = clamp(TexCoord, texel * 0.5, uvScale - texel * 0.5);
+
+    vec4 color = texture(source, uv);
+    if (sharpen == 1) {
+        // Unsharp mask over the four neighbours
+        vec4 blur = texture(source, uv + vec2(texel.x, 0.0))
+                  + texture(source, uv - vec2(texel.x, 0.0))
+                  + texture(source, uv + vec2(0.0, texel.y))
+                  + texture(source, uv - vec2(0.0, texel.y));
+        color = clamp(color + (color - blur * 0.25) * sharpness, 0.0, 1.0);
+    }
+    FragColor = vec4(color.rgb, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+out vec2 TexCoord;
+
+// Part of the source texture that holds the rendered image
+uniform vec2 uvScale;
+
+void main() {
+    // Fullscreen triangle from the vertex id, no buffers needed
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = pos * uvScale;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,324 @@
+#include "./shadows.h"
+#include "./config.h"
+#include "./cube.h"
+#include "./frustum.h"
+#include "./glstate.h"
+#include "./gputimer.h"
+#include "./stats.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+namespace {
+    const int FACES = 6;
+    const int REGIONS = FACES + Shadows::CASCADES;
+
+    // Half the side of each cascade's square, and how far it reaches towards and away from the sun
+    const float CASCADE_EXTENTS[Shadows::CASCADES] = {8.0f, 24.0f, 72.0f};
+    const float CASCADE_DEPTH = 100.0f;
+
+    // Looking down each cube map face, in GL's face order
+    const glm::vec3 FACE_DIRECTIONS[FACES] = {
+        {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+        {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}
+    };
+    const glm::vec3 FACE_UPS[FACES] = {
+        {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+        {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}
+    };
+
+    // A cube face or a cascade, regions 0-5 are the faces
+    struct Region {
+        GLuint framebuffer;
+        glm::mat4 projection, view;
+        Frustum frustum;
+        bool valid;             // Holds what its matrices see, as of the last draw
+        bool drawnWithMotion;   // Last drawn with a caster in flight, so it needs one more draw once it stops
+    };
+
+    // Where a caster was and is, for casters that moved this step
+    struct Motion {
+        glm::vec3 from, to;
+        float radius;
+    };
+
+    Region regions[REGIONS];
+    std::vector<Motion> moving;
+    std::size_t casterCount = 0;
+
+    GLuint cubeTexture, cascadeTexture;
+    int cubeSize = 1, cascadeSize = 1;
+    std::unique_ptr<Shader> cubeShader, cascadeShader;
+    GLuint positionVAO, positionVBO;
+    GpuTimer timer;
+
+    // What the faces and cascades were placed for, a zero sun direction when there is no sun
+    glm::vec3 lightPosition(0.0f);
+    glm::vec3 sunDirection(0.0f);
+    float cascadeTexels[Shadows::CASCADES];
+
+    glm::mat4 interpolatedModel(const DrawCommand &command, float alpha) {
+        if (alpha < 1.0f) {
+            return command.previousModel * (1.0f - alpha) + command.model * alpha;
+        }
+        return command.model;
+    }
+
+    // Unit cubes, so the half diagonal of the longest axis bounds them
+    float boundingRadius(const glm::mat4 &model) {
+        float largest = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        return 0.8660254f * largest;
+    }
+
+    void setup(GLenum target) {
+        GLState::texParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        GLState::texParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLState::texParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        GLState::texParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        GLState::texParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        GLState::texParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        GLState::texParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+
+    void createFramebuffer(Region &region) {
+        glGenFramebuffers(1, &region.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, region.framebuffer);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    // Re-aim the faces at the light
+    void placeFaces(const glm::vec3 &lightPos) {
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.05f, Shadows::CUBE_FAR);
+        for (int f = 0; f < FACES; f++) {
+            Region &region = regions[f];
+            region.projection = projection;
+            region.view = glm::lookAt(lightPos, lightPos + FACE_DIRECTIONS[f], FACE_UPS[f]);
+            region.frustum = Frustum(region.projection * region.view);
+            region.valid = false;
+        }
+    }
+
+    // Centre each cascade on the camera, snapped to a quarter of its size so it only moves now and then
+    void placeCascades(const glm::vec3 &direction, const glm::vec3 &viewPos) {
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 rotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+        glm::vec3 camera = glm::vec3(rotation * glm::vec4(viewPos, 1.0f));
+
+        for (int c = 0; c < Shadows::CASCADES; c++) {
+            Region &region = regions[FACES + c];
+            float extent = CASCADE_EXTENTS[c];
+            float step = extent * 0.25f;
+            glm::vec3 centre = glm::floor(camera / step + glm::vec3(0.5f)) * step;
+
+            glm::mat4 view = glm::translate(glm::mat4(1.0f), -centre) * rotation;
+            if (region.valid && view == region.view) {
+                continue;
+            }
+            region.projection = glm::ortho(-extent, extent, -extent, extent, -CASCADE_DEPTH, CASCADE_DEPTH);
+            region.view = view;
+            region.frustum = Frustum(region.projection * region.view);
+            region.valid = false;
+            cascadeTexels[c] = 2.0f * extent / cascadeSize;
+        }
+    }
+
+    // Clear the region and draw the casters it can see, returns how many that was
+    int draw(Region &region, Shader &shader, int size, const std::vector<DrawCommand> &casters, float alpha) {
+        glBindFramebuffer(GL_FRAMEBUFFER, region.framebuffer);
+        GLState::viewport(0, 0, size, size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        shader.setMat4("projection", region.projection);
+        shader.setMat4("view", region.view);
+        int drawn = 0;
+        for (const DrawCommand &caster : casters) {
+            glm::mat4 model = interpolatedModel(caster, alpha);
+            if (!region.frustum.SphereVisible(glm::vec3(model[3]), boundingRadius(model))) {
+                continue;
+            }
+            shader.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, Cube::vertCount);
+            drawn++;
+        }
+        return drawn;
+    }
+
+    // Whether the region has to be drawn again, and whether a moving caster is in it
+    bool invalidated(Region &region, bool &motion) {
+        motion = false;
+        for (const Motion &m : moving) {
+            if (region.frustum.SphereVisible(m.from, m.radius) || region.frustum.SphereVisible(m.to, m.radius)) {
+                motion = true;
+                break;
+            }
+        }
+        return !region.valid || region.drawnWithMotion || motion;
+    }
+}
+
+void Shadows::init() {
+    // Without shadows the maps are a single texel at the far plane, so every lookup is lit
+    float far = 1.0f;
+    const float *texel = &far;
+    if (Config::shadows) {
+        cubeSize = CUBE_SIZE;
+        cascadeSize = CASCADE_SIZE;
+        texel = nullptr;
+    }
+
+    glGenTextures(1, &cubeTexture);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+    for (int f = 0; f < FACES; f++) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_DEPTH_COMPONENT24, cubeSize, cubeSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, texel);
+    }
+    setup(GL_TEXTURE_CUBE_MAP);
+
+    std::vector<float> layers(CASCADES, 1.0f);
+    glGenTextures(1, &cascadeTexture);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, cascadeTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, cascadeSize, cascadeSize, CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, texel ? layers.data() : nullptr);
+    setup(GL_TEXTURE_2D_ARRAY);
+
+    if (!Config::shadows) {
+        return;
+    }
+
+    // One framebuffer per face and cascade, depth only
+    for (int f = 0; f < FACES; f++) {
+        createFramebuffer(regions[f]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, cubeTexture, 0);
+    }
+    for (int c = 0; c < CASCADES; c++) {
+        createFramebuffer(regions[FACES + c]);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cascadeTexture, 0, c);
+    }
+    for (Region &region : regions) {
+        glBindFramebuffer(GL_FRAMEBUFFER, region.framebuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::SHADOWS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+        region.drawnWithMotion = false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    placeFaces(lightPosition);
+
+    // The cube map holds distance to the light, the cascades plain depth
+    cubeShader.reset(new Shader("../src/shaders/shadowCube.vs", "../src/shaders/shadowCube.fs"));
+    cascadeShader.reset(new Shader("../src/shaders/depthOnly.vs", "../src/shaders/depthOnly.fs"));
+    Cube::createCube(positionVAO, positionVBO, 0);
+}
+
+void Shadows::update(const std::vector<DrawCommand> &casters, const Renderer::Frame &frame) {
+    auto start = std::chrono::steady_clock::now();
+    timer.Begin();
+
+    // A caster added or removed could be anywhere
+    if (casters.size() != casterCount) {
+        casterCount = casters.size();
+        for (Region &region : regions) {
+            region.valid = false;
+        }
+    }
+
+    // Everything that moved this step dirties the regions it left and entered
+    moving.clear();
+    for (const DrawCommand &caster : casters) {
+        if (caster.model != caster.previousModel) {
+            Motion motion;
+            motion.from = glm::vec3(caster.previousModel[3]);
+            motion.to = glm::vec3(caster.model[3]);
+            motion.radius = boundingRadius(caster.model);
+            moving.push_back(motion);
+        }
+    }
+
+    if (frame.lightPos != lightPosition) {
+        lightPosition = frame.lightPos;
+        placeFaces(lightPosition);
+    }
+
+    glm::vec3 direction = frame.sunColor != glm::vec3(0.0f) ? glm::normalize(frame.sunDirection) : glm::vec3(0.0f);
+    if (direction != sunDirection) {
+        sunDirection = direction;
+        for (int c = 0; c < CASCADES; c++) {
+            regions[FACES + c].valid = false;
+        }
+    }
+    if (sunDirection != glm::vec3(0.0f)) {
+        placeCascades(sunDirection, frame.viewPos);
+    }
+
+    GLState::depthFunc(GL_LESS);
+    GLState::depthMask(GL_TRUE);
+    GLState::bindVertexArray(positionVAO);
+
+    int redrawn = 0, drawn = 0;
+    bool motion = false;
+
+    cubeShader->use();
+    cubeShader->setVec3("lightPos", frame.lightPos);
+    cubeShader->setFloat("far", CUBE_FAR);
+    for (int f = 0; f < FACES; f++) {
+        Region &region = regions[f];
+        if (invalidated(region, motion)) {
+            drawn += draw(region, *cubeShader, cubeSize, casters, frame.alpha);
+            region.valid = true;
+            region.drawnWithMotion = motion;
+            redrawn++;
+        }
+    }
+
+    // Depth clamp keeps casters between the sun and the cascade's near plane, offsetting slopes against acne
+    if (sunDirection != glm::vec3(0.0f)) {
+        cascadeShader->use();
+        GLState::enable(GL_DEPTH_CLAMP);
+        GLState::enable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+        for (int c = 0; c < CASCADES; c++) {
+            Region &region = regions[FACES + c];
+            if (invalidated(region, motion)) {
+                drawn += draw(region, *cascadeShader, cascadeSize, casters, frame.alpha);
+                region.valid = true;
+                region.drawnWithMotion = motion;
+                redrawn++;
+            }
+        }
+        GLState::disable(GL_POLYGON_OFFSET_FILL);
+        GLState::disable(GL_DEPTH_CLAMP);
+    }
+
+    if (timer.End()) {
+        Stats::set("shadow_gpu_ms", timer.Milliseconds);
+    }
+    Stats::set("shadow_regions", (double)redrawn);
+    Stats::set("shadow_draws", (double)drawn);
+    Stats::set("shadow_moving", (double)moving.size());
+    Stats::set("shadow_cpu_ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void Shadows::bind(Shader &shader, int firstUnit) {
+    GLState::activeTexture(GL_TEXTURE0 + firstUnit);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+    GLState::activeTexture(GL_TEXTURE0 + firstUnit + 1);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, cascadeTexture);
+
+    shader.setInt("lightShadow", firstUnit);
+    shader.setInt("sunShadow", firstUnit + 1);
+    shader.setBool("shadows", Config::shadows);
+    shader.setFloat("lightShadowFar", CUBE_FAR);
+
+    // Matrices straight to clip space, and how big a texel is for the normal offset
+    static const char *MATRICES[CASCADES] = {"sunMatrices[0]", "sunMatrices[1]", "sunMatrices[2]"};
+    static const char *TEXELS[CASCADES] = {"sunTexels[0]", "sunTexels[1]", "sunTexels[2]"};
+    for (int c = 0; c < CASCADES; c++) {
+        const Region &region = regions[FACES + c];
+        shader.setMat4(MATRICES[c], region.projection * region.view);
+        shader.setFloat(TEXELS[c], cascadeTexels[c]);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "./drawlist.h"
+#include "./renderer.h"
+#include "./shader.h"
+
+#include <vector>
+
+/**
+ * Shadow maps for the main light (a depth cube map holding distance to the
+ * light) and the sun (cascades: squares of growing size around the camera,
+ * each in a layer of a depth array). The maps are kept between frames and a
+ * cube face or cascade is only redrawn when something invalidates it: a
+ * moved light, a cascade re-centred on the camera, or a caster that moved
+ * within it. Most frames draw nothing. Render thread only.
+ */
+
+namespace Shadows {
+    const int CUBE_SIZE = 1024;
+    const int CASCADE_SIZE = 2048;
+    const int CASCADES = 3;
+    const float CUBE_FAR = 50.0f;       // Distance the main light's shadows reach
+
+    // Create the maps, at full size only with --shadows
+    extern void init();
+
+    // Redraw the faces and cascades this frame invalidated. Leaves its own framebuffer bound
+    extern void update(const std::vector<DrawCommand> &casters, const Renderer::Frame &frame);
+
+    // Bind the maps to two texture units from firstUnit on and set the shader's shadow uniforms
+    extern void bind(Shader &shader, int firstUnit);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_SSE 1
+#else
+#include <cmath>
+#endif
+
+/**
+ * Four floats processed together. Maps to SSE when the compiler targets it
+ * and falls back to plain loops otherwise. Comparisons return masks with all
+ * bits of a lane set, to be used with select and mask.
+ */
+
+namespace Simd {
+#ifdef SIMD_SSE
+    struct Float4 {
+        __m128 v;
+    };
+
+    inline Float4 make(__m128 v) { Float4 r; r.v = v; return r; }
+
+    inline Float4 splat(float a) { return make(_mm_set1_ps(a)); }
+    inline Float4 set(float a, float b, float c, float d) { return make(_mm_setr_ps(a, b, c, d)); }
+    inline Float4 load(const float *p) { return make(_mm_loadu_ps(p)); }
+    inline void store(float *p, Float4 a) { _mm_storeu_ps(p, a.v); }
+
+    inline Float4 operator+(Float4 a, Float4 b) { return make(_mm_add_ps(a.v, b.v)); }
+    inline Float4 operator-(Float4 a, Float4 b) { return make(_mm_sub_ps(a.v, b.v)); }
+    inline Float4 operator*(Float4 a, Float4 b) { return make(_mm_mul_ps(a.v, b.v)); }
+    inline Float4 operator/(Float4 a, Float4 b) { return make(_mm_div_ps(a.v, b.v)); }
+    inline Float4 min(Float4 a, Float4 b) { return make(_mm_min_ps(a.v, b.v)); }
+    inline Float4 max(Float4 a, Float4 b) { return make(_mm_max_ps(a.v, b.v)); }
+    inline Float4 sqrt(Float4 a) { return make(_mm_sqrt_ps(a.v)); }
+
+    inline Float4 operator<(Float4 a, Float4 b) { return make(_mm_cmplt_ps(a.v, b.v)); }
+    inline Float4 operator>(Float4 a, Float4 b) { return make(_mm_cmpgt_ps(a.v, b.v)); }
+    inline Float4 operator>=(Float4 a, Float4 b) { return make(_mm_cmpge_ps(a.v, b.v)); }
+    inline Float4 operator&(Float4 a, Float4 b) { return make(_mm_and_ps(a.v, b.v)); }
+    inline Float4 operator|(Float4 a, Float4 b) { return make(_mm_or_ps(a.v, b.v)); }
+
+    // Lanes of a where m is set, of b elsewhere
+    inline Float4 select(Float4 m, Float4 a, Float4 b) { return make(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))); }
+
+    // One bit per lane, lane 0 in bit 0
+    inline int mask(Float4 m) { return _mm_movemask_ps(m.v); }
+#else
+    struct Float4 {
+        float v[4];
+    };
+
+    inline Float4 splat(float a) { Float4 r = {{a, a, a, a}}; return r; }
+    inline Float4 set(float a, float b, float c, float d) { Float4 r = {{a, b, c, d}}; return r; }
+    inline Float4 load(const float *p) { Float4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+    inline void store(float *p, Float4 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+
+    template<typename Op>
+    inline Float4 apply(Float4 a, Float4 b, Op op) {
+        Float4 r;
+        for (int i = 0; i < 4; i++) {
+            r.v[i] = op(a.v[i], b.v[i]);
+        }
+        return r;
+    }
+
+    inline float bits(std::uint32_t u) { float f; std::memcpy(&f, &u, sizeof(f)); return f; }
+    inline std::uint32_t bits(float f) { std::uint32_t u; std::memcpy(&u, &f, sizeof(u)); return u; }
+    inline float lane(bool b) { return bits(b ? 0xffffffffu : 0u); }
+
+    inline Float4 operator+(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+    inline Float4 operator-(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+    inline Float4 operator*(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+    inline Float4 operator/(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+    inline Float4 min(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    inline Float4 max(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    inline Float4 sqrt(Float4 a) { return apply(a, a, [](float x, float) { return std::sqrt(x); }); }
+
+    inline Float4 operator<(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return lane(x < y); }); }
+    inline Float4 operator>(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return lane(x > y); }); }
+    inline Float4 operator>=(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return lane(x >= y); }); }
+    inline Float4 operator&(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return bits(bits(x) & bits(y)); }); }
+    inline Float4 operator|(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return bits(bits(x) | bits(y)); }); }
+
+    inline Float4 select(Float4 m, Float4 a, Float4 b) {
+        Float4 r;
+        for (int i = 0; i < 4; i++) {
+            r.v[i] = bits(m.v[i]) ? a.v[i] : b.v[i];
+        }
+        return r;
+    }
+
+    inline int mask(Float4 m) {
+        int r = 0;
+        for (int i = 0; i < 4; i++) {
+            r |= (bits(m.v[i]) >> 31) << i;
+        }
+        return r;
+    }
+#endif
+}
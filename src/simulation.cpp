@@ -0,0 +1,95 @@
+#include "./simulation.h"
+#include "./jobs.h"
+#include "./scene.h"
+#include "./config.h"
+#include "./occlusion.h"
+#include "./gpucull.h"
+#include "./picking.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+    Frustum frustum;
+    float lodScale = 0.0f;
+    std::unique_ptr<Jobs::Graph> graph;
+}
+
+void Simulation::init() {
+    // Bounding radii are only worked out with the transforms, which otherwise first happens in the graph
+    for (std::size_t p = 0; p < Scene::partitionCount(); p++) {
+        Scene::updateTransforms(p);
+    }
+
+    // Ray queries against the scene as it was built
+    Picking::build();
+
+    // The resident cubes stay on the GPU as they are now, and cast the same shadows throughout
+    if (Config::gpuCulling) {
+        GpuCull::capture();
+    }
+    if (Config::shadows) {
+        DrawList::recordResidentCasters();
+    }
+
+    // Update then cull and record each partition
+    graph.reset(new Jobs::Graph());
+    std::vector<Jobs::Graph::TaskId> updates, records;
+    for (std::size_t p = 0; p < Scene::partitionCount(); p++) {
+        Jobs::Graph::TaskId update = graph->add([p] { Scene::updateTransforms(p); });
+        Jobs::Graph::TaskId record = graph->add([p] { DrawList::record(p, frustum, lodScale, Config::occlusion); });
+        graph->precede(update, record);
+        updates.push_back(update);
+        records.push_back(record);
+
+        // Shadow maps need the casters out of view too
+        if (Config::shadows) {
+            Jobs::Graph::TaskId casters = graph->add([p] { DrawList::recordCasters(p); });
+            graph->precede(update, casters);
+        }
+    }
+
+    // Picking follows what moved, once every transform is in
+    Jobs::Graph::TaskId refit = graph->add([] {
+        if (Scene::takeMoved()) {
+            Picking::refit();
+        }
+    });
+    for (Jobs::Graph::TaskId update : updates) {
+        graph->precede(update, refit);
+    }
+
+    // Occluders need every transform, and every partition's culling needs the whole pyramid
+    if (Config::occlusion) {
+        Occlusion::init();
+        Jobs::Graph::TaskId gather = graph->add([] { Occlusion::gather(); });
+        Jobs::Graph::TaskId pyramid = graph->add([] { Occlusion::buildPyramid(); });
+        for (Jobs::Graph::TaskId update : updates) {
+            graph->precede(update, gather);
+        }
+        for (int band = 0; band < Occlusion::BANDS; band++) {
+            Jobs::Graph::TaskId rasterize = graph->add([band] { Occlusion::rasterize(band); });
+            graph->precede(gather, rasterize);
+            graph->precede(rasterize, pyramid);
+        }
+        for (Jobs::Graph::TaskId record : records) {
+            graph->precede(pyramid, record);
+        }
+    }
+}
+
+const std::vector<DrawCommand>& Simulation::record(const glm::mat4 &viewProjection) {
+    frustum = Frustum(viewProjection);
+
+    // The view only rotates, so the length of the second row is the projection's y scale
+    lodScale = Config::lod ? glm::length(glm::vec3(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1])) : 0.0f;
+    if (Config::occlusion) {
+        Occlusion::begin(viewProjection, frustum);
+    }
+    DrawList::reset();
+    graph->run();
+    if (Config::occlusion) {
+        Occlusion::endFrame();
+    }
+    return DrawList::merge();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "./drawlist.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/**
+ * The per frame simulation work on the main thread: transform updates, then
+ * culling and recording of every scene partition, run as one job graph.
+ */
+
+namespace Simulation {
+    // Build the task graph, call again whenever the number of partitions changes
+    extern void init();
+
+    // Update, cull against viewProjection and return the merged draw list
+    extern const std::vector<DrawCommand>& record(const glm::mat4 &viewProjection);
+}
@@ -0,0 +1,551 @@
+#include "./softraster.h"
+#include "./simd.h"
+#include "./cube.h"
+#include "./jobs.h"
+#include "./rtpool.h"
+#include "./glstate.h"
+#include "./stats.h"
+#include "./framearena.h"
+#include "./texture.h"
+#include "./config.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using Simd::Float4;
+
+namespace {
+    const int TILE_SIZE = 64;
+    const int CHUNKS = 64;              // Fixed so the draw order inside a tile never depends on the thread count
+    const int CUBE_VERTICES = 36;
+    const int ATTRIBUTES = 8;           // World position, normal, uv
+
+    struct Vertex {
+        float clip[4];
+        float attributes[ATTRIBUTES];
+    };
+
+    // A screen space triangle ready for rasterization, wound counter-clockwise
+    struct Triangle {
+        float x[3], y[3], z[3], invW[3];
+        float attributes[3][ATTRIBUTES];
+        float area;
+        int minX, minY, maxX, maxY;     // Pixel bounds, max exclusive
+        Scene::Material material;
+    };
+
+    // Set up triangles and bins are rebuilt every frame
+    FrameArena binArena(1 << 20);
+
+    // Triangles set up from one contiguous range of the input, and the tiles they touch
+    struct Chunk {
+        Chunk() : triangles(FrameArena::Allocator<Triangle>(binArena)), bins(FrameArena::Allocator<ArenaVector<std::uint32_t>>(binArena)) {}
+
+        ArenaVector<Triangle> triangles;
+        ArenaVector<ArenaVector<std::uint32_t>> bins;
+    };
+
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<float> texels;      // RGB in [0, 1]
+    };
+
+    // Cube vertices split per component, so four load straight into a Float4
+    float cubePosition[3][CUBE_VERTICES];
+    float cubeNormal[3][CUBE_VERTICES];
+    float cubeUV[2][CUBE_VERTICES];
+
+    Image texture;
+
+    int fbWidth = 0, fbHeight = 0, fbStride = 0;
+    int tilesX = 0, tilesY = 0;
+    std::vector<std::uint32_t> color;
+    std::vector<float> depth;
+
+    std::vector<Vertex> vertices;
+    Chunk chunks[CHUNKS];
+
+    GLuint presentTexture = 0;
+    int presentWidth = 0, presentHeight = 0;
+
+    const glm::vec3 CLEAR_COLOR(0.2f, 0.3f, 0.3f);
+    const glm::vec3 OBJECT_COLOR(1.0f, 0.5f, 0.31f);
+
+    std::uint32_t pack(float r, float g, float b) {
+        std::uint32_t ri = (std::uint32_t)(std::min(std::max(r, 0.0f), 1.0f) * 255.0f + 0.5f);
+        std::uint32_t gi = (std::uint32_t)(std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f);
+        std::uint32_t bi = (std::uint32_t)(std::min(std::max(b, 0.0f), 1.0f) * 255.0f + 0.5f);
+        return ri | (gi << 8) | (bi << 16) | (255u << 24);
+    }
+
+    void resize(int width, int height) {
+        if (width == fbWidth && height == fbHeight) {
+            return;
+        }
+        fbWidth = width;
+        fbHeight = height;
+        fbStride = (width + 3) & ~3;    // Rows padded so four wide loads never run off the end
+        tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        color.assign((std::size_t)fbStride * height, 0);
+        depth.assign((std::size_t)fbStride * height, 1.0f);
+    }
+
+    // Bilinear lookup with GL_REPEAT wrapping, texel centres at half integers like GL
+    void sample(float u, float v, float out[3]) {
+        if (texture.width == 0) {
+            out[0] = out[1] = out[2] = 1.0f;
+            return;
+        }
+        float x = u * texture.width - 0.5f;
+        float y = v * texture.height - 0.5f;
+        float fx = std::floor(x), fy = std::floor(y);
+        float tx = x - fx, ty = y - fy;
+
+        int x0 = ((int)fx % texture.width + texture.width) % texture.width;
+        int y0 = ((int)fy % texture.height + texture.height) % texture.height;
+        int x1 = (x0 + 1) % texture.width;
+        int y1 = (y0 + 1) % texture.height;
+
+        const float *t00 = &texture.texels[((std::size_t)y0 * texture.width + x0) * 3];
+        const float *t10 = &texture.texels[((std::size_t)y0 * texture.width + x1) * 3];
+        const float *t01 = &texture.texels[((std::size_t)y1 * texture.width + x0) * 3];
+        const float *t11 = &texture.texels[((std::size_t)y1 * texture.width + x1) * 3];
+        for (int c = 0; c < 3; c++) {
+            float top = t00[c] + (t10[c] - t00[c]) * tx;
+            float bottom = t01[c] + (t11[c] - t01[c]) * tx;
+            out[c] = top + (bottom - top) * ty;
+        }
+    }
+
+    // Transform the 36 cube vertices of one command, four at a time
+    void transform(const DrawCommand &command, const Renderer::Frame &frame, Vertex *out) {
+        glm::mat4 model = command.model;
+        if (frame.alpha < 1.0f) {
+            model = command.previousModel * (1.0f - frame.alpha) + command.model * frame.alpha;
+        }
+        glm::mat4 mvp = frame.projection * frame.view * model;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+        for (int i = 0; i < CUBE_VERTICES; i += 4) {
+            Float4 px = Simd::load(&cubePosition[0][i]);
+            Float4 py = Simd::load(&cubePosition[1][i]);
+            Float4 pz = Simd::load(&cubePosition[2][i]);
+            Float4 nx = Simd::load(&cubeNormal[0][i]);
+            Float4 ny = Simd::load(&cubeNormal[1][i]);
+            Float4 nz = Simd::load(&cubeNormal[2][i]);
+
+            // Columns of glm matrices come first
+            float lanes[10][4];
+            for (int r = 0; r < 4; r++) {
+                Float4 clip = px * Simd::splat(mvp[0][r]) + py * Simd::splat(mvp[1][r]) + pz * Simd::splat(mvp[2][r]) + Simd::splat(mvp[3][r]);
+                Simd::store(lanes[r], clip);
+            }
+            for (int r = 0; r < 3; r++) {
+                Float4 world = px * Simd::splat(model[0][r]) + py * Simd::splat(model[1][r]) + pz * Simd::splat(model[2][r]) + Simd::splat(model[3][r]);
+                Float4 normal = nx * Simd::splat(normalMatrix[0][r]) + ny * Simd::splat(normalMatrix[1][r]) + nz * Simd::splat(normalMatrix[2][r]);
+                Simd::store(lanes[4 + r], world);
+                Simd::store(lanes[7 + r], normal);
+            }
+
+            for (int lane = 0; lane < 4; lane++) {
+                Vertex &vertex = out[i + lane];
+                for (int r = 0; r < 4; r++) {
+                    vertex.clip[r] = lanes[r][lane];
+                }
+                for (int a = 0; a < 6; a++) {
+                    vertex.attributes[a] = lanes[4 + a][lane];
+                }
+                vertex.attributes[6] = cubeUV[0][i + lane];
+                vertex.attributes[7] = cubeUV[1][i + lane];
+            }
+        }
+    }
+
+    // Screen space setup, false for triangles that cover no pixel centre
+    bool setup(const Vertex *v[3], Scene::Material material, Triangle &triangle) {
+        for (int i = 0; i < 3; i++) {
+            float invW = 1.0f / v[i]->clip[3];
+            triangle.x[i] = (v[i]->clip[0] * invW * 0.5f + 0.5f) * fbWidth;
+            triangle.y[i] = (v[i]->clip[1] * invW * 0.5f + 0.5f) * fbHeight;
+            triangle.z[i] = v[i]->clip[2] * invW * 0.5f + 0.5f;
+            triangle.invW[i] = invW;
+            std::copy(v[i]->attributes, v[i]->attributes + ATTRIBUTES, triangle.attributes[i]);
+        }
+
+        float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+        if (area == 0.0f || !std::isfinite(area)) {
+            return false;
+        }
+        if (area < 0.0f) {
+            // Face culling is off in the GL path too, just flip to counter-clockwise
+            std::swap(triangle.x[1], triangle.x[2]);
+            std::swap(triangle.y[1], triangle.y[2]);
+            std::swap(triangle.z[1], triangle.z[2]);
+            std::swap(triangle.invW[1], triangle.invW[2]);
+            for (int a = 0; a < ATTRIBUTES; a++) {
+                std::swap(triangle.attributes[1][a], triangle.attributes[2][a]);
+            }
+            area = -area;
+        }
+        triangle.area = area;
+        triangle.material = material;
+
+        // Pixel centres sit at half integers
+        float minX = std::min({triangle.x[0], triangle.x[1], triangle.x[2]});
+        float maxX = std::max({triangle.x[0], triangle.x[1], triangle.x[2]});
+        float minY = std::min({triangle.y[0], triangle.y[1], triangle.y[2]});
+        float maxY = std::max({triangle.y[0], triangle.y[1], triangle.y[2]});
+        triangle.minX = std::max(0, (int)std::floor(minX - 0.5f));
+        triangle.minY = std::max(0, (int)std::floor(minY - 0.5f));
+        triangle.maxX = std::min(fbWidth, (int)std::ceil(maxX + 0.5f));
+        triangle.maxY = std::min(fbHeight, (int)std::ceil(maxY + 0.5f));
+        return triangle.minX < triangle.maxX && triangle.minY < triangle.maxY;
+    }
+
+    Vertex lerp(const Vertex &a, const Vertex &b, float t) {
+        Vertex r;
+        for (int i = 0; i < 4; i++) {
+            r.clip[i] = a.clip[i] + (b.clip[i] - a.clip[i]) * t;
+        }
+        for (int i = 0; i < ATTRIBUTES; i++) {
+            r.attributes[i] = a.attributes[i] + (b.attributes[i] - a.attributes[i]) * t;
+        }
+        return r;
+    }
+
+    // Clip against the near plane (z >= -w) and append what is left to the chunk
+    void clipAndBin(const Vertex &a, const Vertex &b, const Vertex &c, Scene::Material material, Chunk &chunk) {
+        const Vertex *input[3] = {&a, &b, &c};
+        Vertex clipped[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++) {
+            const Vertex &current = *input[i];
+            const Vertex &next = *input[(i + 1) % 3];
+            float dc = current.clip[2] + current.clip[3];
+            float dn = next.clip[2] + next.clip[3];
+            if (dc >= 0.0f) {
+                clipped[count++] = current;
+            }
+            if ((dc >= 0.0f) != (dn >= 0.0f)) {
+                clipped[count++] = lerp(current, next, dc / (dc - dn));
+            }
+        }
+
+        // A fan of one or two triangles
+        for (int i = 1; i + 1 < count; i++) {
+            const Vertex *v[3] = {&clipped[0], &clipped[i], &clipped[i + 1]};
+            Triangle triangle;
+            if (!setup(v, material, triangle)) {
+                continue;
+            }
+
+            std::uint32_t index = (std::uint32_t)chunk.triangles.size();
+            chunk.triangles.push_back(triangle);
+            for (int ty = triangle.minY / TILE_SIZE; ty <= (triangle.maxY - 1) / TILE_SIZE; ty++) {
+                for (int tx = triangle.minX / TILE_SIZE; tx <= (triangle.maxX - 1) / TILE_SIZE; tx++) {
+                    chunk.bins[ty * tilesX + tx].push_back(index);
+                }
+            }
+        }
+    }
+
+    // Phong from lightingShader.fs for four pixels, written where active is set
+    void shade(const Triangle &triangle, const Float4 p[3], int active, int x, int y, const Renderer::Frame &frame) {
+        float rgb[3][4];
+        if (triangle.material == Scene::LAMP) {
+            for (int c = 0; c < 3; c++) {
+                Simd::store(rgb[c], Simd::splat(1.0f));
+            }
+        } else {
+            Float4 a[ATTRIBUTES];
+            for (int i = 0; i < ATTRIBUTES; i++) {
+                a[i] = p[0] * Simd::splat(triangle.attributes[0][i]) + p[1] * Simd::splat(triangle.attributes[1][i]) + p[2] * Simd::splat(triangle.attributes[2][i]);
+            }
+
+            // Normalised normal, light and view directions
+            Float4 one = Simd::splat(1.0f);
+            Float4 nLength = one / Simd::sqrt(a[3] * a[3] + a[4] * a[4] + a[5] * a[5]);
+            Float4 nx = a[3] * nLength, ny = a[4] * nLength, nz = a[5] * nLength;
+            Float4 lx = Simd::splat(frame.lightPos.x) - a[0];
+            Float4 ly = Simd::splat(frame.lightPos.y) - a[1];
+            Float4 lz = Simd::splat(frame.lightPos.z) - a[2];
+            Float4 lLength = one / Simd::sqrt(lx * lx + ly * ly + lz * lz);
+            lx = lx * lLength; ly = ly * lLength; lz = lz * lLength;
+            Float4 vx = Simd::splat(frame.viewPos.x) - a[0];
+            Float4 vy = Simd::splat(frame.viewPos.y) - a[1];
+            Float4 vz = Simd::splat(frame.viewPos.z) - a[2];
+            Float4 vLength = one / Simd::sqrt(vx * vx + vy * vy + vz * vz);
+            vx = vx * vLength; vy = vy * vLength; vz = vz * vLength;
+
+            Float4 zero = Simd::splat(0.0f);
+            Float4 nDotL = nx * lx + ny * ly + nz * lz;
+            Float4 diffuse = Simd::max(nDotL, zero);
+
+            // reflect(-l, n) = 2 * dot(n, l) * n - l
+            Float4 twoNDotL = nDotL + nDotL;
+            Float4 rx = twoNDotL * nx - lx, ry = twoNDotL * ny - ly, rz = twoNDotL * nz - lz;
+            Float4 spec = Simd::max(vx * rx + vy * ry + vz * rz, zero);
+            for (int i = 0; i < 5; i++) {
+                spec = spec * spec;     // pow(spec, 32)
+            }
+            Float4 intensity = Simd::splat(0.1f) + diffuse + Simd::splat(0.5f) * spec;
+
+            float u[4], v[4];
+            Simd::store(u, a[6]);
+            Simd::store(v, a[7]);
+            float tex[3][4] = {};
+            for (int lane = 0; lane < 4; lane++) {
+                if (active & (1 << lane)) {
+                    float texel[3];
+                    sample(u[lane], v[lane], texel);
+                    tex[0][lane] = texel[0];
+                    tex[1][lane] = texel[1];
+                    tex[2][lane] = texel[2];
+                }
+            }
+
+            for (int c = 0; c < 3; c++) {
+                Float4 result = intensity * Simd::splat(frame.lightColor[c] * OBJECT_COLOR[c]) * Simd::load(tex[c]);
+                Simd::store(rgb[c], result);
+            }
+        }
+
+        std::uint32_t *row = &color[(std::size_t)y * fbStride + x];
+        for (int lane = 0; lane < 4; lane++) {
+            if (active & (1 << lane)) {
+                row[lane] = pack(rgb[0][lane], rgb[1][lane], rgb[2][lane]);
+            }
+        }
+    }
+
+    // Rasterize the part of a triangle inside the tile, four pixels per step
+    void rasterize(const Triangle &t, int tileX0, int tileY0, int tileX1, int tileY1, const Renderer::Frame &frame) {
+        int x0 = std::max(t.minX, tileX0) & ~3;
+        int x1 = std::min(t.maxX, tileX1);
+        int y0 = std::max(t.minY, tileY0);
+        int y1 = std::min(t.maxY, tileY1);
+
+        // Edge i is opposite vertex i, E(p) = A (px - ax) + B (py - ay) is positive inside
+        float A[3], B[3], ax[3], ay[3];
+        bool topLeft[3];
+        for (int i = 0; i < 3; i++) {
+            int a = (i + 1) % 3, b = (i + 2) % 3;
+            float dx = t.x[b] - t.x[a];
+            float dy = t.y[b] - t.y[a];
+            A[i] = -dy;
+            B[i] = dx;
+            ax[i] = t.x[a];
+            ay[i] = t.y[a];
+            // Pixels exactly on a shared edge belong to only one of the triangles
+            topLeft[i] = dy < 0.0f || (dy == 0.0f && dx < 0.0f);
+        }
+
+        Float4 invArea = Simd::splat(1.0f / t.area);
+        Float4 zero = Simd::splat(0.0f);
+        Float4 laneOffset = Simd::set(0.5f, 1.5f, 2.5f, 3.5f);
+
+        for (int y = y0; y < y1; y++) {
+            float py = y + 0.5f;
+            for (int x = x0; x < x1; x += 4) {
+                Float4 px = Simd::splat((float)x) + laneOffset;
+                Float4 inside = px < Simd::splat((float)x1);
+                inside = inside & (px >= Simd::splat((float)std::max(t.minX, tileX0)));
+
+                Float4 l[3];
+                for (int i = 0; i < 3; i++) {
+                    Float4 e = Simd::splat(A[i]) * (px - Simd::splat(ax[i])) + Simd::splat(B[i] * (py - ay[i]));
+                    inside = inside & (topLeft[i] ? e >= zero : e > zero);
+                    l[i] = e * invArea;
+                }
+                if (!Simd::mask(inside)) {
+                    continue;
+                }
+
+                // Depth test, GL_LESS against a buffer cleared to 1
+                float *depthRow = &depth[(std::size_t)y * fbStride + x];
+                Float4 z = l[0] * Simd::splat(t.z[0]) + l[1] * Simd::splat(t.z[1]) + l[2] * Simd::splat(t.z[2]);
+                Float4 stored = Simd::load(depthRow);
+                inside = inside & (z < stored);
+                int active = Simd::mask(inside);
+                if (!active) {
+                    continue;
+                }
+                Simd::store(depthRow, Simd::select(inside, z, stored));
+
+                // Perspective correct weights
+                Float4 w0 = l[0] * Simd::splat(t.invW[0]);
+                Float4 w1 = l[1] * Simd::splat(t.invW[1]);
+                Float4 w2 = l[2] * Simd::splat(t.invW[2]);
+                Float4 norm = Simd::splat(1.0f) / (w0 + w1 + w2);
+                Float4 p[3] = {w0 * norm, w1 * norm, w2 * norm};
+
+                shade(t, p, active, x, y, frame);
+            }
+        }
+    }
+
+    void renderTile(int tile, const Renderer::Frame &frame) {
+        int tileX0 = (tile % tilesX) * TILE_SIZE;
+        int tileY0 = (tile / tilesX) * TILE_SIZE;
+        int tileX1 = std::min(tileX0 + TILE_SIZE, fbWidth);
+        int tileY1 = std::min(tileY0 + TILE_SIZE, fbHeight);
+
+        std::uint32_t clear = pack(CLEAR_COLOR.r, CLEAR_COLOR.g, CLEAR_COLOR.b);
+        for (int y = tileY0; y < tileY1; y++) {
+            std::fill(&color[(std::size_t)y * fbStride + tileX0], &color[(std::size_t)y * fbStride + tileX1], clear);
+            std::fill(&depth[(std::size_t)y * fbStride + tileX0], &depth[(std::size_t)y * fbStride + tileX1], 1.0f);
+        }
+
+        // Chunks in input order keep equal depth ties resolved the same way every run
+        for (const Chunk &chunk : chunks) {
+            for (std::uint32_t index : chunk.bins[tile]) {
+                rasterize(chunk.triangles[index], tileX0, tileY0, tileX1, tileY1, frame);
+            }
+        }
+    }
+}
+
+void SoftRaster::init() {
+    // Split the interleaved cube into components: position, uv, normal
+    std::size_t stride = Cube::vertSize / sizeof(float);
+    for (int i = 0; i < CUBE_VERTICES; i++) {
+        const float *vertex = &Cube::vertices[i * stride];
+        for (int c = 0; c < 3; c++) {
+            cubePosition[c][i] = vertex[c];
+            cubeNormal[c][i] = vertex[5 + c];
+        }
+        cubeUV[0][i] = vertex[3];
+        cubeUV[1][i] = vertex[4];
+    }
+
+    // Same texture the GL path samples, kept as floats for filtering
+    int width, height, channels;
+    std::vector<unsigned char> bricks;
+    unsigned char *data = nullptr;
+    if (Config::bench.empty()) {
+        data = stbi_load("../assets/wall.jpg", &width, &height, &channels, 3);
+        if (!data) {
+            throw new std::runtime_error("Failed to load texture");
+        }
+    } else {
+        Texture::bricks(bricks, width, height);
+    }
+    const unsigned char *texels = data ? data : bricks.data();
+    texture.width = width;
+    texture.height = height;
+    texture.texels.resize((std::size_t)width * height * 3);
+    for (std::size_t i = 0; i < texture.texels.size(); i++) {
+        texture.texels[i] = texels[i] / 255.0f;
+    }
+    if (data) {
+        stbi_image_free(data);
+    }
+}
+
+void SoftRaster::draw(const std::vector<DrawCommand> &commands, const Renderer::Frame &frame, int width, int height) {
+    auto start = std::chrono::steady_clock::now();
+    resize(width, height);
+
+    // Vertex stage, sized for the whole scene so more coming into view doesn't grow it
+    vertices.reserve(Scene::instances.size() * CUBE_VERTICES);
+    vertices.resize(commands.size() * CUBE_VERTICES);
+    Jobs::parallelFor(commands.size(), 16, [&commands, &frame](std::size_t i) {
+        transform(commands[i], frame, &vertices[i * CUBE_VERTICES]);
+    });
+
+    // Last frame's bins are done with
+    for (Chunk &chunk : chunks) {
+        ArenaVector<Triangle>(chunk.triangles.get_allocator()).swap(chunk.triangles);
+        ArenaVector<ArenaVector<std::uint32_t>>(chunk.bins.get_allocator()).swap(chunk.bins);
+    }
+    binArena.reset();
+
+    // Clip, set up and bin, one fixed range of triangles per chunk
+    std::size_t triangleCount = commands.size() * CUBE_VERTICES / 3;
+    std::size_t perChunk = (triangleCount + CHUNKS - 1) / CHUNKS;
+    Jobs::parallelFor(CHUNKS, 1, [&commands, &frame, triangleCount, perChunk](std::size_t c) {
+        Chunk &chunk = chunks[c];
+        std::size_t begin = std::min(triangleCount, c * perChunk);
+        std::size_t end = std::min(triangleCount, (c + 1) * perChunk);
+        FrameArena::Allocator<std::uint32_t> allocator(binArena);
+        chunk.bins.assign(tilesX * tilesY, ArenaVector<std::uint32_t>(allocator));
+        chunk.triangles.reserve(end - begin);
+
+        for (std::size_t i = begin; i < end; i++) {
+            const Vertex *v = &vertices[i * 3];
+            const DrawCommand &command = commands[i * 3 / CUBE_VERTICES];
+            if (command.material == Scene::CHUNK) {
+                continue;   // Chunk meshes only exist on the GPU
+            }
+
+            // Faces turned away are hidden behind the rest of the closed cube anyway
+            glm::vec3 position(v[0].attributes[0], v[0].attributes[1], v[0].attributes[2]);
+            glm::vec3 normal(v[0].attributes[3], v[0].attributes[4], v[0].attributes[5]);
+            if (glm::dot(normal, frame.viewPos - position) < 0.0f) {
+                continue;
+            }
+            clipAndBin(v[0], v[1], v[2], command.material, chunk);
+        }
+    });
+
+    // Raster stage, tiles don't overlap so each one is written by a single job
+    Jobs::parallelFor(tilesX * tilesY, 1, [&frame](std::size_t tile) {
+        renderTile((int)tile, frame);
+    });
+
+    std::size_t binned = 0;
+    for (const Chunk &chunk : chunks) {
+        binned += chunk.triangles.size();
+    }
+    Stats::set("soft_triangles", (double)binned);
+    Stats::set("soft_frame_ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+const std::uint32_t* SoftRaster::pixels() {
+    return color.data();
+}
+
+int SoftRaster::width() {
+    return fbWidth;
+}
+
+int SoftRaster::height() {
+    return fbHeight;
+}
+
+int SoftRaster::stride() {
+    return fbStride;
+}
+
+void SoftRaster::present() {
+    if (fbWidth == 0 || fbHeight == 0) {
+        return;
+    }
+
+    if (presentTexture == 0) {
+        glGenTextures(1, &presentTexture);
+    }
+    GLState::bindTexture(GL_TEXTURE_2D, presentTexture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, fbStride);
+    if (presentWidth != fbWidth || presentHeight != fbHeight) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, fbWidth, fbHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
+        presentWidth = fbWidth;
+        presentHeight = fbHeight;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fbWidth, fbHeight, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    // Blit from a framebuffer around the texture
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, RenderTargets::framebuffer(&presentTexture, 1, 0));
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, fbWidth, fbHeight, 0, 0, fbWidth, fbHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
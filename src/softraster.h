@@ -0,0 +1,31 @@
+#pragma once
+
+#include "./renderer.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * CPU rendering backend behind the same draw call as Renderer. Vertices are
+ * transformed four at a time, triangles are binned into screen tiles and the
+ * tiles are rasterized, depth tested and Phong shaded in parallel on the job
+ * system. The result stays in an in-memory framebuffer; present copies it to
+ * the window when there is a GL context to show it with.
+ */
+
+namespace SoftRaster {
+    // Load the cube and a CPU copy of the texture
+    extern void init();
+
+    // Clear and draw the commands into a width by height framebuffer
+    extern void draw(const std::vector<DrawCommand> &commands, const Renderer::Frame &frame, int width, int height);
+
+    // RGBA8 pixels of the last frame, bottom row first, stride() pixels per row
+    extern const std::uint32_t* pixels();
+    extern int width();
+    extern int height();
+    extern int stride();
+
+    // Copy the framebuffer to the window. Needs the context
+    extern void present();
+}
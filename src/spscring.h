@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Capacity has to be a power of two.
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    public:
+        SpscRing() : head(0), tail(0) {}
+
+        // Producer: returns false when the ring is full
+        bool Push(const T &value)
+        {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == Capacity)
+                return false;
+            items[h & (Capacity - 1)] = value;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: returns false when the ring is empty
+        bool Pop(T &value)
+        {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire))
+                return false;
+            value = items[t & (Capacity - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        alignas(64) std::atomic<std::size_t> head;  // Next slot to write, owned by the producer
+        alignas(64) std::atomic<std::size_t> tail;  // Next slot to read, owned by the consumer
+        T items[Capacity];
+};
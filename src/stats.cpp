@@ -0,0 +1,80 @@
+#include "./stats.h"
+#include "./config.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace {
+    const int MAX_STATS = 128;
+
+    struct Entry {
+        const char* name;
+        double value;
+    };
+
+    // Fixed storage so reporting never allocates
+    Entry entries[MAX_STATS];
+    int count = 0;
+    std::mutex mutex;
+    double lastReport = 0.0;
+
+    // Needs the lock held
+    Entry* find(const char* name) {
+        for (int i = 0; i < count; i++) {
+            if (entries[i].name == name || std::strcmp(entries[i].name, name) == 0) {
+                return &entries[i];
+            }
+        }
+        if (count == MAX_STATS) {
+            return nullptr;
+        }
+        entries[count].name = name;
+        entries[count].value = 0.0;
+        return &entries[count++];
+    }
+}
+
+void Stats::set(const char* name, double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry *entry = find(name);
+    if (entry) {
+        entry->value = value;
+    }
+}
+
+void Stats::add(const char* name, double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry *entry = find(name);
+    if (entry) {
+        entry->value += value;
+    }
+}
+
+double Stats::get(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry *entry = find(name);
+    return entry ? entry->value : 0.0;
+}
+
+void Stats::report() {
+    if (!Config::stats) {
+        return;
+    }
+
+    double now = glfwGetTime();
+    if (now - lastReport < 1.0) {
+        return;
+    }
+    lastReport = now;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::printf("STATS");
+    for (int i = 0; i < count; i++) {
+        std::printf(" %s=%.3f", entries[i].name, entries[i].value);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * Named values subsystems report (frame times, memory, counts). Printed once
+ * a second when --stats is on. Names must be string literals.
+ */
+
+namespace Stats {
+    extern void set(const char* name, double value);
+    extern void add(const char* name, double value);
+
+    // Value last set, 0 if never set
+    extern double get(const char* name);
+
+    // Print everything if a second has passed since the last report
+    extern void report();
+}
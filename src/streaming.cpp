@@ -0,0 +1,579 @@
+#include "./streaming.h"
+#include "./voxels.h"
+#include "./scene.h"
+#include "./glstate.h"
+#include "./spscring.h"
+#include "./config.h"
+#include "./stats.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    const int N = Voxels::CHUNK_SIZE;
+    const std::size_t VERTEX_BYTES = 8 * sizeof(float);   // Cube::vertSize, as a constant
+    const std::size_t SLOT_BYTES = Streaming::SLOT_VERTICES * VERTEX_BYTES + Streaming::SLOT_INDICES * sizeof(std::uint32_t);
+    const int LOADS_PER_THREAD = 4;     // Kept short so a turn of the camera reorders the queue quickly
+
+    enum State {
+        FREE,       // Not in use
+        LOADING,    // With a thread or waiting to be collected
+        EMPTY,      // Loaded, nothing to draw
+        UPLOADING,  // Has a slot, waiting for the render thread
+        RESIDENT    // Drawn from its slot
+    };
+
+    struct Record {
+        glm::ivec3 coord;
+        State state;
+        int slot;                   // -1 while it has none
+        std::uint64_t lastWanted;   // Frame it was last within the radius
+    };
+
+    struct Request {
+        glm::ivec3 coord;
+        int staging;
+    };
+
+    // Waiting for the render thread, not before the packet of frame
+    struct Upload {
+        int staging;
+        int slot;
+        std::uint64_t frame;
+    };
+
+    struct Candidate {
+        float priority;
+        glm::ivec3 coord;
+    };
+
+    // Main thread
+    std::atomic<bool> running(false);
+    int radius = 0;
+    unsigned int seed = 0;
+    std::uint64_t frames = 0;
+    std::vector<Record> records;
+    std::vector<int> freeRecords;
+    std::vector<int> table;             // Open addressing from coord to record, -1 for free cells
+    std::vector<int> freeSlots;
+    std::size_t firstInstance = 0;      // Scene instance of slot 0, the others follow
+    std::vector<Candidate> candidates;
+    std::vector<int> freeStaging;
+    int stagingRecord[Streaming::STAGING];
+    std::vector<int> finished;          // Staging meshes taken over from the threads this frame
+    int loading = 0;
+    int uploading = 0;
+    int requested = 0;                  // By the last update
+    double loads = 0.0, evictions = 0.0;
+
+    // Shared with the threads. Staging meshes belong to whoever holds their index
+    Voxels::Mesh staging[Streaming::STAGING];
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<Request> queue;         // Best first
+    std::vector<int> built;
+    bool stopping = false;
+
+    // Shared with the render thread
+    int slotCount = 0;
+    SpscRing<Upload, 32> uploads;
+    SpscRing<int, 32> uploaded;
+
+    // Render thread
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    int poolSlots = 0;
+    std::vector<std::array<std::uint32_t, Lod::LEVELS + 1>> levels;     // Level starts of each slot's indices
+    Upload next;
+    bool haveNext = false;              // Popped but not uploaded yet
+
+    glm::vec3 centreOf(const glm::ivec3 &coord) {
+        return glm::vec3(coord * N) + glm::vec3(N * 0.5f - 0.5f);
+    }
+
+    std::size_t cellOf(const glm::ivec3 &coord) {
+        std::uint32_t h = (std::uint32_t)coord.x * 73856093u ^ (std::uint32_t)coord.y * 19349663u ^ (std::uint32_t)coord.z * 83492791u;
+        return h & (table.size() - 1);
+    }
+
+    int find(const glm::ivec3 &coord) {
+        for (std::size_t cell = cellOf(coord); table[cell] >= 0; cell = (cell + 1) & (table.size() - 1)) {
+            if (records[table[cell]].coord == coord) {
+                return table[cell];
+            }
+        }
+        return -1;
+    }
+
+    // Shift the rest of the run back over the hole, so lookups never need tombstones
+    void unlink(int record) {
+        std::size_t mask = table.size() - 1;
+        std::size_t hole = cellOf(records[record].coord);
+        while (table[hole] != record) {
+            hole = (hole + 1) & mask;
+        }
+        table[hole] = -1;
+
+        for (std::size_t cell = (hole + 1) & mask; table[cell] >= 0; cell = (cell + 1) & mask) {
+            std::size_t home = cellOf(records[table[cell]].coord);
+            bool between = hole <= cell ? (home > hole && home <= cell) : (home > hole || home <= cell);
+            if (!between) {
+                table[hole] = table[cell];
+                table[cell] = -1;
+                hole = cell;
+            }
+        }
+    }
+
+    void hide(int slot) {
+        Scene::Instance &instance = Scene::instances[firstInstance + slot];
+        instance.scale = glm::vec3(0.0f);
+    }
+
+    void show(int slot, const glm::ivec3 &coord, const Voxels::Mesh &mesh) {
+        Scene::Instance &instance = Scene::instances[firstInstance + slot];
+        instance.position = centreOf(coord);
+        instance.previousPosition = instance.position;
+        instance.scale = glm::vec3((float)N);
+        std::copy(mesh.levelError, mesh.levelError + Lod::LEVELS, instance.lodError);
+        instance.lod = 0;
+    }
+
+    void evict(int record) {
+        Record &entry = records[record];
+        if (entry.slot >= 0) {
+            hide(entry.slot);
+            freeSlots.push_back(entry.slot);
+        }
+        unlink(record);
+        entry.state = FREE;
+        freeRecords.push_back(record);
+        evictions++;
+    }
+
+    // Least recently wanted chunk outside the radius that isn't being worked on, -1 if none
+    int leastRecent(bool withSlot) {
+        int best = -1;
+        for (int i = 0; i < (int)records.size(); i++) {
+            const Record &entry = records[i];
+            bool settled = entry.state == EMPTY || entry.state == RESIDENT;
+            if (!settled || entry.lastWanted == frames || (withSlot && entry.slot < 0)) {
+                continue;
+            }
+            if (best < 0 || entry.lastWanted < records[best].lastWanted) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    void releaseStaging(int index) {
+        freeStaging.push_back(index);
+    }
+
+    // Generate the chunk and its neighbours, so faces against them are culled, then mesh and simplify it
+    void buildLoop() {
+        std::vector<Voxels::Chunk> chunks(7);
+        for (;;) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [] { return stopping || !queue.empty(); });
+                if (stopping) {
+                    return;
+                }
+                request = queue.front();
+                queue.erase(queue.begin());
+            }
+
+            const Voxels::Chunk *neighbours[6];
+            for (int f = 0; f < 6; f++) {
+                chunks[f].coord = request.coord;
+                chunks[f].coord[f / 2] += (f & 1) ? 1 : -1;
+                Voxels::generate(chunks[f], seed);
+                neighbours[f] = &chunks[f];
+            }
+            chunks[6].coord = request.coord;
+            Voxels::generate(chunks[6], seed);
+            Voxels::mesh(chunks[6], neighbours, true, staging[request.staging]);
+            Voxels::simplify(chunks[6], neighbours, staging[request.staging]);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            built.push_back(request.staging);
+        }
+    }
+
+    // A thread finished a chunk: empty ones are done, the others need a slot and an upload
+    void collect(int index) {
+        int record = stagingRecord[index];
+        Record &entry = records[record];
+        const Voxels::Mesh &mesh = staging[index];
+        loading--;
+
+        bool fits = mesh.vertices.size() * sizeof(float) <= Streaming::SLOT_VERTICES * VERTEX_BYTES && mesh.indices.size() <= (std::size_t)Streaming::SLOT_INDICES;
+        if (!fits) {
+            std::cout << "ERROR::STREAMING::CHUNK_TOO_LARGE " << entry.coord.x << "," << entry.coord.y << "," << entry.coord.z << std::endl;
+        }
+        if (mesh.indices.empty() || !fits) {
+            entry.state = EMPTY;
+            releaseStaging(index);
+            return;
+        }
+
+        if (freeSlots.empty()) {
+            int victim = leastRecent(true);
+            if (victim < 0) {
+                // Over budget, forget it so it's asked for again once something frees up
+                unlink(record);
+                entry.state = FREE;
+                freeRecords.push_back(record);
+                releaseStaging(index);
+                return;
+            }
+            evict(victim);
+        }
+        entry.slot = freeSlots.back();
+        freeSlots.pop_back();
+        entry.state = UPLOADING;
+        uploading++;
+        uploads.Push(Upload{index, entry.slot, frames});
+    }
+
+    // Queue the missing chunks, best first, while there are staging meshes and slots to spare
+    void request() {
+        int evictable = 0;
+        for (int i = 0; i < (int)records.size(); i++) {
+            const Record &entry = records[i];
+            if (entry.state == RESIDENT && entry.slot >= 0 && entry.lastWanted < frames) {
+                evictable++;
+            }
+        }
+        int spare = (int)freeSlots.size() + evictable - loading;
+        int limit = LOADS_PER_THREAD * (int)threads.size();
+
+        requested = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Candidate &candidate : candidates) {
+            if (freeStaging.empty() || loading >= limit || spare <= 0) {
+                break;
+            }
+
+            if (freeRecords.empty()) {
+                int victim = leastRecent(false);
+                if (victim < 0) {
+                    break;
+                }
+                evict(victim);
+            }
+            int record = freeRecords.back();
+            freeRecords.pop_back();
+            records[record] = Record{candidate.coord, LOADING, -1, frames};
+            std::size_t cell = cellOf(candidate.coord);
+            while (table[cell] >= 0) {
+                cell = (cell + 1) & (table.size() - 1);
+            }
+            table[cell] = record;
+
+            int index = freeStaging.back();
+            freeStaging.pop_back();
+            stagingRecord[index] = record;
+            queue.push_back(Request{candidate.coord, index});
+            loading++;
+            spare--;
+            requested++;
+            loads++;
+        }
+        if (requested > 0) {
+            wake.notify_all();
+        }
+    }
+
+    // Mark the chunks within the radius as wanted and rank the missing ones. Behind the camera counts as twice as far
+    void want(const glm::vec3 &position, const glm::vec3 &front) {
+        glm::ivec3 centre = glm::ivec3(glm::floor((position + glm::vec3(0.5f)) / (float)N));
+        candidates.clear();
+        for (int y = Streaming::LAYER_MIN; y <= Streaming::LAYER_MAX; y++) {
+            for (int z = -radius; z <= radius; z++) {
+                for (int x = -radius; x <= radius; x++) {
+                    if (x * x + z * z > radius * radius) {
+                        continue;
+                    }
+                    glm::ivec3 coord(centre.x + x, y, centre.z + z);
+                    int record = find(coord);
+                    if (record >= 0) {
+                        records[record].lastWanted = frames;
+                        continue;
+                    }
+
+                    glm::vec3 offset = centreOf(coord) - position;
+                    float distance = glm::length(offset);
+                    float facing = distance > 0.0f ? glm::dot(offset / distance, front) : 1.0f;
+                    candidates.push_back(Candidate{distance * (1.5f - 0.5f * facing), coord});
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+            return a.priority < b.priority;
+        });
+    }
+
+    // Slot buffers sized for every slot, filled piecewise as chunks come in
+    void createPool() {
+        Streaming::shutdownContext();
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        GLState::bindVertexArray(vao);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)slotCount * Streaming::SLOT_VERTICES * VERTEX_BYTES, nullptr, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)slotCount * Streaming::SLOT_INDICES * sizeof(std::uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+        // Same attribute locations as the cube's vertex array
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTES, (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTES, (void*)(5 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, VERTEX_BYTES, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        levels.assign(slotCount, std::array<std::uint32_t, Lod::LEVELS + 1>());
+        poolSlots = slotCount;
+    }
+
+    void uploadUpTo(std::uint64_t frame, std::size_t cap) {
+        if (poolSlots != slotCount) {
+            createPool();
+        }
+
+        std::size_t bytes = 0;
+        for (;;) {
+            if (!haveNext && !uploads.Pop(next)) {
+                break;
+            }
+            haveNext = true;
+
+            // The packet still shows what the slot held before
+            if (next.frame > frame) {
+                break;
+            }
+            const Voxels::Mesh &mesh = staging[next.staging];
+            std::size_t vertexBytes = mesh.vertices.size() * sizeof(float);
+            std::size_t indexBytes = mesh.indices.size() * sizeof(std::uint32_t);
+
+            // One at least, however large
+            if (bytes > 0 && bytes + vertexBytes + indexBytes > cap) {
+                break;
+            }
+            GLState::bindVertexArray(vao);
+            GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)next.slot * Streaming::SLOT_VERTICES * VERTEX_BYTES, vertexBytes, mesh.vertices.data());
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)next.slot * Streaming::SLOT_INDICES * sizeof(std::uint32_t), indexBytes, mesh.indices.data());
+            std::copy(mesh.levelStart, mesh.levelStart + Lod::LEVELS + 1, levels[next.slot].begin());
+            bytes += vertexBytes + indexBytes;
+
+            uploaded.Push(next.staging);
+            haveNext = false;
+        }
+        Stats::set("stream_upload_kb", bytes / 1024.0);
+    }
+}
+
+void Streaming::start(int chunkRadius, std::size_t budgetBytes, unsigned int worldSeed) {
+    stop();
+    radius = chunkRadius;
+    seed = worldSeed;
+    frames = 0;
+    loading = 0;
+    uploading = 0;
+    loads = 0.0;
+    evictions = 0.0;
+
+    // Room for everything within the radius, plus as many again and the slots for what was left behind
+    int wanted = 0;
+    for (int z = -radius; z <= radius; z++) {
+        for (int x = -radius; x <= radius; x++) {
+            wanted += x * x + z * z <= radius * radius ? 1 : 0;
+        }
+    }
+    wanted *= LAYER_MAX - LAYER_MIN + 1;
+    slotCount = std::max<int>(1, (int)(budgetBytes / SLOT_BYTES));
+
+    records.assign(2 * wanted + slotCount, Record{glm::ivec3(0), FREE, -1, 0});
+    freeRecords.clear();
+    for (int i = (int)records.size() - 1; i >= 0; i--) {
+        freeRecords.push_back(i);
+    }
+    std::size_t cells = 1;
+    while (cells < 2 * records.size()) {
+        cells *= 2;
+    }
+    table.assign(cells, -1);
+    candidates.clear();
+    candidates.reserve(wanted);
+
+    firstInstance = Scene::instances.size();
+    freeSlots.clear();
+    for (int slot = slotCount - 1; slot >= 0; slot--) {
+        freeSlots.push_back(slot);
+    }
+    for (int slot = 0; slot < slotCount; slot++) {
+        std::size_t instance = Scene::add(glm::vec3(0.0f), glm::vec3(0.0f), Scene::CHUNK);
+        Scene::instances[instance].mesh = STREAMED | (std::uint32_t)slot;
+    }
+
+    // Staging meshes keep their storage, so building into them doesn't allocate
+    freeStaging.clear();
+    for (int i = STAGING - 1; i >= 0; i--) {
+        staging[i].vertices.reserve(SLOT_VERTICES * VERTEX_BYTES / sizeof(float));
+        staging[i].indices.reserve(SLOT_INDICES);
+        freeStaging.push_back(i);
+    }
+    finished.reserve(STAGING);
+    queue.reserve(STAGING);
+    built.reserve(STAGING);
+
+    stopping = false;
+    for (int i = 0; i < std::max(1, Config::streamThreads); i++) {
+        threads.emplace_back(buildLoop);
+    }
+
+    Stats::set("stream_slots", slotCount);
+    Stats::set("stream_memory_mb", (slotCount * SLOT_BYTES + STAGING * SLOT_BYTES) / (1024.0 * 1024.0));
+    running.store(true, std::memory_order_release);
+}
+
+void Streaming::stop() {
+    if (!running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    queue.clear();
+    built.clear();
+
+    // Nothing renders, so what the render thread hadn't got to yet can go
+    Upload upload;
+    while (uploads.Pop(upload)) {
+    }
+    int index;
+    while (uploaded.Pop(index)) {
+    }
+    haveNext = false;
+
+    records.clear();
+    table.clear();
+    slotCount = 0;
+    running.store(false, std::memory_order_release);
+}
+
+bool Streaming::active() {
+    return running.load(std::memory_order_acquire);
+}
+
+void Streaming::update(const glm::vec3 &position, const glm::vec3 &front) {
+    if (!active()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    frames++;
+
+    // Finished meshes, then finished uploads
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.swap(built);
+    }
+    for (int index : finished) {
+        collect(index);
+    }
+    finished.clear();
+
+    int index;
+    while (uploaded.Pop(index)) {
+        Record &entry = records[stagingRecord[index]];
+        entry.state = RESIDENT;
+        show(entry.slot, entry.coord, staging[index]);
+        uploading--;
+        releaseStaging(index);
+    }
+
+    want(position, front);
+    request();
+
+    Stats::set("stream_resident", slotCount - (double)freeSlots.size());
+    Stats::set("stream_loading", loading);
+    Stats::set("stream_loads", loads);
+    Stats::set("stream_evictions", evictions);
+    Stats::set("stream_update_ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+std::uint64_t Streaming::frame() {
+    return frames;
+}
+
+void Streaming::settle(const glm::vec3 &position, const glm::vec3 &front) {
+    if (!active()) {
+        return;
+    }
+    for (;;) {
+        update(position, front);
+        for (int i = 0; i < (int)records.size(); i++) {
+            bool settled = records[i].state == EMPTY || records[i].state == RESIDENT;
+            if (settled && records[i].lastWanted < frames) {
+                evict(i);
+            }
+        }
+        uploadUpTo(frames, SIZE_MAX);
+
+        // All of it is in, or what is left doesn't fit the budget
+        if (loading == 0 && uploading == 0 && requested == 0) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void Streaming::upload(std::uint64_t frame) {
+    if (!active()) {
+        return;
+    }
+    uploadUpTo(frame, (std::size_t)std::max(Config::streamUpload, 1) * 1024);
+}
+
+void Streaming::draw(std::uint32_t slot, int level) {
+    const std::array<std::uint32_t, Lod::LEVELS + 1> &starts = levels[slot];
+    GLState::bindVertexArray(vao);
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)(starts[level + 1] - starts[level]), GL_UNSIGNED_INT, (void*)((slot * SLOT_INDICES + starts[level]) * sizeof(std::uint32_t)), (GLint)(slot * SLOT_VERTICES));
+}
+
+std::uint32_t Streaming::triangles(std::uint32_t slot, int level) {
+    const std::array<std::uint32_t, Lod::LEVELS + 1> &starts = levels[slot];
+    return (starts[level + 1] - starts[level]) / 3;
+}
+
+void Streaming::shutdownContext() {
+    if (vao != 0) {
+        GLState::deleteVertexArray(vao);
+        GLState::deleteBuffer(vbo);
+        GLState::deleteBuffer(ebo);
+        vao = vbo = ebo = 0;
+    }
+    poolSlots = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Voxel world streamed around the camera. Every frame the chunks within a
+ * radius of the camera are wanted; missing ones are queued nearest first,
+ * with chunks in front of the camera ahead of those behind it, and built on
+ * background threads of their own so chunk work never lands in a frame's
+ * jobs. Finished meshes wait in staging buffers until the render thread
+ * copies them into slots of one preallocated vertex and index buffer, a
+ * capped number of bytes per frame. The slots are the memory budget: when
+ * they run out, the least recently wanted chunk outside the radius gives up
+ * its slot. Each slot has a CHUNK scene instance that is parked at zero
+ * scale while the slot holds nothing.
+ *
+ * The main thread drives it with update(), the render thread with upload()
+ * and draw(). Nothing in update() waits on the other threads.
+ */
+
+namespace Streaming {
+    const int SLOT_VERTICES = 12288;    // Vertex capacity of a slot, a terrain chunk with its coarser levels needs under 10000
+    const int SLOT_INDICES = 16384;
+    const int STAGING = 16;             // Meshes being built or waiting for upload at once
+    const int LAYER_MIN = -1;           // Chunk layers streamed, the terrain lives in these
+    const int LAYER_MAX = 0;
+
+    // Set in Scene::Instance::mesh of streamed chunks, the rest of the value is the slot
+    const std::uint32_t STREAMED = 0x80000000u;
+
+    // Main thread. Size the slots from budgetBytes, add their scene instances and start
+    // the threads. Rebuild the simulation's task graph afterwards
+    extern void start(int radius, std::size_t budgetBytes, unsigned int seed);
+
+    // Stop the threads and forget every chunk. Only once nothing renders streamed chunks anymore
+    extern void stop();
+
+    extern bool active();
+
+    // Main thread, once per frame before recording: collect finished chunks and queue more
+    extern void update(const glm::vec3 &position, const glm::vec3 &front);
+
+    // Frames update() has run, packets carry it so uploads wait for the frame that queued them
+    extern std::uint64_t frame();
+
+    // Main thread, bench only: drop every chunk that isn't wanted and load all that are,
+    // uploading on the calling thread, so the result only depends on the camera
+    extern void settle(const glm::vec3 &position, const glm::vec3 &front);
+
+    // Render thread: copy finished meshes queued up to frame into their slots, within the per frame cap
+    extern void upload(std::uint64_t frame);
+
+    // Render thread: draw one level of the mesh in a slot
+    extern void draw(std::uint32_t slot, int level);
+
+    // Render thread: triangles draw() would submit
+    extern std::uint32_t triangles(std::uint32_t slot, int level);
+
+    // Render thread: free the slot buffers
+    extern void shutdownContext();
+}
@@ -1,24 +1,34 @@
 #include "./texture.h"
+#include "./glstate.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <stdexcept>
 
-GLuint Texture::load(const std::string &path, GLint format, GLint wrap, GLint filter) {
-    // Gen and bind texture
-    GLuint id;
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
+namespace {
+    GLuint create(const unsigned char *data, int width, int height, GLint format, GLint wrap, GLint filter) {
+        // Gen and bind texture
+        GLuint id;
+        glGenTextures(1, &id);
+        GLState::bindTexture(GL_TEXTURE_2D, id);
+
+        // Set wrapping
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
 
-    // Set wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        // Set filtering
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        GLState::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 
-    // Set filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        // Load texture into OpenGL
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        return id;
+    }
+}
 
+GLuint Texture::load(const std::string &path, GLint format, GLint wrap, GLint filter) {
     int width, height, nrChannels;
 
     unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
@@ -26,9 +36,7 @@ GLuint Texture::load(const std::string &path, GLint format, GLint wrap, GLint fi
         throw new std::runtime_error("Failed to load texture");
     }
 
-    // Load texture into OpenGL
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    GLuint id = create(data, width, height, format, wrap, filter);
 
     // free data
     stbi_image_free(data);
@@ -36,7 +44,36 @@ GLuint Texture::load(const std::string &path, GLint format, GLint wrap, GLint fi
     return id;
 }
 
+void Texture::bricks(std::vector<unsigned char> &rgb, int &width, int &height) {
+    const int SIZE = 64, BRICK_WIDTH = 32, BRICK_HEIGHT = 16, MORTAR = 2;
+    width = SIZE;
+    height = SIZE;
+    rgb.resize((std::size_t)SIZE * SIZE * 3);
+
+    // Every other row shifted by half a brick, each brick a little lighter or darker than the next
+    for (int y = 0; y < SIZE; y++) {
+        int row = y / BRICK_HEIGHT;
+        for (int x = 0; x < SIZE; x++) {
+            int shifted = x + (row % 2) * BRICK_WIDTH / 2;
+            int column = (shifted / BRICK_WIDTH) % (SIZE / BRICK_WIDTH);
+            bool mortar = y % BRICK_HEIGHT < MORTAR || shifted % BRICK_WIDTH < MORTAR;
+            int shade = ((row * 7 + column * 13) % 5) * 8;
+            unsigned char *texel = &rgb[((std::size_t)y * SIZE + x) * 3];
+            texel[0] = (unsigned char)(mortar ? 190 : 140 + shade);
+            texel[1] = (unsigned char)(mortar ? 185 : 70 + shade / 2);
+            texel[2] = (unsigned char)(mortar ? 175 : 50 + shade / 2);
+        }
+    }
+}
+
+GLuint Texture::loadBricks(GLint wrap, GLint filter) {
+    std::vector<unsigned char> rgb;
+    int width, height;
+    bricks(rgb, width, height);
+    return create(rgb.data(), width, height, GL_RGB, wrap, filter);
+}
+
 void Texture::activate(GLuint id, GLenum texture) {
-    glActiveTexture(texture);
-    glBindTexture(GL_TEXTURE_2D, id);
+    GLState::activeTexture(texture);
+    GLState::bindTexture(GL_TEXTURE_2D, id);
 }
@@ -4,8 +4,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <string>
+#include <vector>
 
 namespace Texture {
     GLuint load(const std::string &path, GLint format, GLint wrap, GLint filter);
+
+    // RGB bricks drawn in code, for runs whose output mustn't depend on the asset files
+    void bricks(std::vector<unsigned char> &rgb, int &width, int &height);
+    GLuint loadBricks(GLint wrap, GLint filter);
     void activate(GLuint id, GLenum texture);
 }
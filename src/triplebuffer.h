@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer. The writer always
+// has a slot to fill and the reader always gets the newest published one,
+// neither ever waits for the other.
+template <typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer() : back(0), middle(1), front(2) {}
+
+        // Writer: slot to fill before calling Publish
+        T& WriteBuffer()
+        {
+            return buffers[back];
+        }
+
+        // Writer: hand the filled slot over and take the stale one back
+        void Publish()
+        {
+            unsigned int previous = middle.exchange(back | DIRTY, std::memory_order_acq_rel);
+            back = previous & INDEX;
+        }
+
+        // Reader: swap in the newest published slot, returns false if nothing new arrived
+        bool Acquire()
+        {
+            if (!(middle.load(std::memory_order_relaxed) & DIRTY))
+                return false;
+            unsigned int previous = middle.exchange(front, std::memory_order_acq_rel);
+            front = previous & INDEX;
+            return true;
+        }
+
+        // Reader: slot returned by the last Acquire
+        const T& ReadBuffer() const
+        {
+            return buffers[front];
+        }
+
+        // Writer: true while the last published slot has not been acquired yet
+        bool Pending() const
+        {
+            return (middle.load(std::memory_order_relaxed) & DIRTY) != 0;
+        }
+
+    private:
+        static const unsigned int INDEX = 3;
+        static const unsigned int DIRTY = 4;
+
+        T buffers[3];
+        unsigned int back;                  // Owned by the writer
+        std::atomic<unsigned int> middle;   // Shared, index plus dirty flag
+        unsigned int front;                 // Owned by the reader
+};
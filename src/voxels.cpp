@@ -0,0 +1,353 @@
+#include "./voxels.h"
+#include "./cube.h"
+#include "./jobs.h"
+#include "./scene.h"
+#include "./stats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+std::vector<Voxels::Chunk> Voxels::chunks;
+std::vector<Voxels::Mesh> Voxels::meshes;
+
+namespace {
+    const int N = Voxels::CHUNK_SIZE;
+    const int FLOATS = 8;   // Position, texture, normal like Cube::vertices
+    const float LEVEL_ERROR[Lod::LEVELS] = {0.0f, 2.0f, 6.0f};    // Blocks each level may move the surface by at most
+
+    std::atomic<std::uint32_t> nextRevision(1);
+
+    // Which block axis and direction each texture coordinate follows on a face
+    struct FaceUv {
+        int axis[2];
+        float sign[2];
+    };
+
+    // Faces are numbered -x, +x, -y, +y, -z, +z: axis f / 2, positive when f is odd.
+    // The mapping is read off Cube::vertices so chunks are textured the way single cubes are
+    std::array<FaceUv, 6> readFaceUvs() {
+        std::array<FaceUv, 6> uvs = {};
+        std::size_t stride = Cube::vertSize / sizeof(float);
+
+        for (int f = 0; f < 6; f++) {
+            int normalAxis = f / 2;
+            float side = (f & 1) ? 1.0f : -1.0f;
+            for (int c = 0; c < 2; c++) {
+                for (int a = 0; a < 3; a++) {
+                    for (float sign : {1.0f, -1.0f}) {
+                        bool matches = a != normalAxis;
+                        for (std::size_t v = 0; matches && v < Cube::vertCount; v++) {
+                            const float *vertex = &Cube::vertices[v * stride];
+                            if (vertex[5 + normalAxis] == side) {
+                                matches = std::abs(vertex[3 + c] - (sign * vertex[a] + 0.5f)) < 0.001f;
+                            }
+                        }
+                        if (matches) {
+                            uvs[f].axis[c] = a;
+                            uvs[f].sign[c] = sign;
+                        }
+                    }
+                }
+            }
+        }
+        return uvs;
+    }
+
+    const std::array<FaceUv, 6>& faceUvs() {
+        static const std::array<FaceUv, 6> FACE_UVS = readFaceUvs();
+        return FACE_UVS;
+    }
+
+    // Block at chunk coordinates that may be one step outside the chunk
+    std::uint8_t blockAt(const Voxels::Chunk &chunk, const Voxels::Chunk *const neighbours[6], int p[3]) {
+        for (int a = 0; a < 3; a++) {
+            if (p[a] < 0 || p[a] >= N) {
+                const Voxels::Chunk *neighbour = neighbours[a * 2 + (p[a] < 0 ? 0 : 1)];
+                if (!neighbour) {
+                    return Voxels::AIR;
+                }
+                int q[3] = {p[0], p[1], p[2]};
+                q[a] = (q[a] + N) % N;
+                return neighbour->at(q[0], q[1], q[2]);
+            }
+        }
+        return chunk.at(p[0], p[1], p[2]);
+    }
+
+    // One rectangle of w by h blocks on face f, at block coordinates slice, i, j along the face's axes
+    void emitQuad(Voxels::Mesh &out, const FaceUv &uv, int f, int slice, int i, int j, int w, int h) {
+        int d = f / 2;
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        bool positive = f & 1;
+
+        std::uint32_t base = (std::uint32_t)(out.vertices.size() / FLOATS);
+        const int corners[4][2] = {{i, j}, {i + w, j}, {i + w, j + h}, {i, j + h}};
+        for (const auto &corner : corners) {
+            float p[3];
+            p[d] = (float)(slice + (positive ? 1 : 0));
+            p[u] = (float)corner[0];
+            p[v] = (float)corner[1];
+
+            float normal[3] = {0.0f, 0.0f, 0.0f};
+            normal[d] = positive ? 1.0f : -1.0f;
+
+            out.vertices.insert(out.vertices.end(), {
+                p[0] / N - 0.5f, p[1] / N - 0.5f, p[2] / N - 0.5f,
+                uv.sign[0] * p[uv.axis[0]], uv.sign[1] * p[uv.axis[1]],
+                normal[0], normal[1], normal[2]
+            });
+        }
+
+        // u cross v is the face axis, so this order is counter clockwise from outside on positive faces
+        if (positive) {
+            out.indices.insert(out.indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+        } else {
+            out.indices.insert(out.indices.end(), {base, base + 2, base + 1, base, base + 3, base + 2});
+        }
+    }
+
+    // One triangle of a simplified level in block units, flat shaded and textured like the block face it mostly faces
+    void emitTriangle(Voxels::Mesh &out, const glm::vec3 *corners) {
+        glm::vec3 normal = glm::normalize(glm::cross(corners[1] - corners[0], corners[2] - corners[0]));
+        glm::vec3 size = glm::abs(normal);
+        int d = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+        const FaceUv &uv = faceUvs()[d * 2 + (normal[d] > 0.0f ? 1 : 0)];
+
+        std::uint32_t base = (std::uint32_t)(out.vertices.size() / FLOATS);
+        for (int i = 0; i < 3; i++) {
+            const glm::vec3 &p = corners[i];
+            out.vertices.insert(out.vertices.end(), {
+                p.x / N - 0.5f, p.y / N - 0.5f, p.z / N - 0.5f,
+                uv.sign[0] * p[uv.axis[0]], uv.sign[1] * p[uv.axis[1]],
+                normal.x, normal.y, normal.z
+            });
+        }
+        out.indices.insert(out.indices.end(), {base, base + 1, base + 2});
+    }
+
+    // What simplify works in, per thread so jobs and streaming threads stop allocating once warmed up
+    struct SimplifyScratch {
+        Voxels::Mesh faces;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> triangles;
+        Lod::Simplifier simplifier;
+    };
+    thread_local SimplifyScratch scratch;
+
+    // Smoothly interpolated random values on an integer lattice, in [0, 1]
+    float valueNoise(float x, float z, unsigned int seed) {
+        auto lattice = [seed](int ix, int iz) {
+            unsigned int h = (unsigned int)ix * 374761393u + (unsigned int)iz * 668265263u + seed * 2246822519u;
+            h = (h ^ (h >> 13)) * 1274126177u;
+            return ((h ^ (h >> 16)) & 0xffffff) / 16777215.0f;
+        };
+
+        int ix = (int)std::floor(x);
+        int iz = (int)std::floor(z);
+        float fx = x - ix, fz = z - iz;
+        fx = fx * fx * (3.0f - 2.0f * fx);
+        fz = fz * fz * (3.0f - 2.0f * fz);
+
+        float a = lattice(ix, iz) + (lattice(ix + 1, iz) - lattice(ix, iz)) * fx;
+        float b = lattice(ix, iz + 1) + (lattice(ix + 1, iz + 1) - lattice(ix, iz + 1)) * fx;
+        return a + (b - a) * fz;
+    }
+}
+
+void Voxels::generate(Chunk &chunk, unsigned int seed) {
+    chunk.blocks.assign(CHUNK_BLOCKS, AIR);
+    glm::ivec3 origin = chunk.coord * N;
+
+    for (int z = 0; z < N; z++) {
+        for (int x = 0; x < N; x++) {
+            // Broad hills with some bumps on top, below y = 0 so the default camera starts above ground
+            float wx = (float)(origin.x + x), wz = (float)(origin.z + z);
+            float height = -28.0f + 20.0f * valueNoise(wx / 24.0f, wz / 24.0f, seed) + 6.0f * valueNoise(wx / 8.0f, wz / 8.0f, seed + 1);
+            int top = (int)std::floor(height);
+
+            for (int y = 0; y < N; y++) {
+                int wy = origin.y + y;
+                if (wy > top) {
+                    break;
+                }
+                std::uint8_t block = wy == top ? GRASS : (wy > top - 4 ? DIRT : STONE);
+                chunk.blocks[x + N * (z + N * y)] = block;
+            }
+        }
+    }
+}
+
+void Voxels::mesh(const Chunk &chunk, const Chunk *const neighbours[6], bool greedy, Mesh &out) {
+    const std::array<FaceUv, 6> &uvs = faceUvs();
+
+    out.vertices.clear();
+    out.indices.clear();
+    out.revision = nextRevision.fetch_add(1, std::memory_order_relaxed);
+
+    // Per slice, whether a face is showing at each cell. Blocks all look the same, so which one doesn't matter
+    bool mask[N * N];
+
+    for (int f = 0; f < 6; f++) {
+        int d = f / 2;
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int step = (f & 1) ? 1 : -1;
+
+        for (int slice = 0; slice < N; slice++) {
+            // Faces of solid blocks that look into air
+            for (int j = 0; j < N; j++) {
+                for (int i = 0; i < N; i++) {
+                    int p[3];
+                    p[d] = slice;
+                    p[u] = i;
+                    p[v] = j;
+                    std::uint8_t block = chunk.at(p[0], p[1], p[2]);
+                    p[d] += step;
+                    mask[i + j * N] = block != AIR && blockAt(chunk, neighbours, p) == AIR;
+                }
+            }
+
+            // Grow each face along u as far as faces show, then along v while the whole row does
+            for (int j = 0; j < N; j++) {
+                for (int i = 0; i < N; ) {
+                    if (!mask[i + j * N]) {
+                        i++;
+                        continue;
+                    }
+
+                    int w = 1, h = 1;
+                    if (greedy) {
+                        while (i + w < N && mask[i + w + j * N]) {
+                            w++;
+                        }
+                        while (j + h < N) {
+                            bool rowMatches = true;
+                            for (int k = 0; k < w && rowMatches; k++) {
+                                rowMatches = mask[i + k + (j + h) * N];
+                            }
+                            if (!rowMatches) {
+                                break;
+                            }
+                            h++;
+                        }
+                    }
+
+                    emitQuad(out, uvs[f], f, slice, i, j, w, h);
+                    for (int y = 0; y < h; y++) {
+                        for (int x = 0; x < w; x++) {
+                            mask[i + x + (j + y) * N] = false;
+                        }
+                    }
+                    i += w;
+                }
+            }
+        }
+    }
+
+    // Only level 0 until simplify adds more
+    out.levelStart[0] = 0;
+    out.levelError[0] = 0.0f;
+    for (int level = 1; level <= Lod::LEVELS; level++) {
+        out.levelStart[level] = (std::uint32_t)out.indices.size();
+    }
+    for (int level = 1; level < Lod::LEVELS; level++) {
+        out.levelError[level] = -1.0f;
+    }
+}
+
+void Voxels::simplify(const Chunk &chunk, const Chunk *const neighbours[6], Mesh &out) {
+    SimplifyScratch &s = scratch;
+    mesh(chunk, neighbours, false, s.faces);
+    s.positions.clear();
+    for (std::size_t v = 0; v < s.faces.vertices.size(); v += FLOATS) {
+        s.positions.push_back((glm::vec3(s.faces.vertices[v], s.faces.vertices[v + 1], s.faces.vertices[v + 2]) + glm::vec3(0.5f)) * (float)N);
+    }
+    s.simplifier.reset(s.positions, s.faces.indices, glm::vec3(0.0f), glm::vec3((float)N));
+
+    // Each level simplifies the one before as far as its error allows, and is dropped if that saves little
+    std::size_t previous = out.levelStart[1] / 3;
+    for (int level = 1; level < Lod::LEVELS; level++) {
+        float error = s.simplifier.reduce(0, LEVEL_ERROR[level]);
+        std::size_t count = s.simplifier.triangleCount();
+        if (count * 4 > previous * 3) {
+            break;
+        }
+
+        s.simplifier.triangles(s.triangles);
+        for (std::size_t t = 0; t < s.triangles.size(); t += 3) {
+            emitTriangle(out, &s.triangles[t]);
+        }
+        for (int next = level + 1; next <= Lod::LEVELS; next++) {
+            out.levelStart[next] = (std::uint32_t)out.indices.size();
+        }
+        out.levelError[level] = error;
+        previous = count;
+    }
+}
+
+void Voxels::build(const glm::ivec3 &min, const glm::ivec3 &max, unsigned int seed) {
+    glm::ivec3 size = max - min;
+    std::size_t first = chunks.size();
+    std::size_t count = (std::size_t)size.x * size.y * size.z;
+    chunks.resize(first + count);
+    meshes.resize(first + count);
+
+    // x fastest, then z, then y, like the blocks
+    auto index = [&](const glm::ivec3 &coord) {
+        glm::ivec3 c = coord - min;
+        return first + c.x + (std::size_t)size.x * (c.z + (std::size_t)size.z * c.y);
+    };
+
+    Jobs::parallelFor(count, 1, [&](std::size_t i) {
+        Chunk &chunk = chunks[first + i];
+        int x = (int)(i % size.x);
+        int z = (int)(i / size.x % size.z);
+        int y = (int)(i / size.x / size.z);
+        chunk.coord = min + glm::ivec3(x, y, z);
+        generate(chunk, seed);
+    });
+
+    // Each job timed on its own, the batch's wall time depends on how many threads shared it
+    std::atomic<std::int64_t> meshNanoseconds(0);
+    Jobs::parallelFor(count, 1, [&](std::size_t i) {
+        auto start = std::chrono::steady_clock::now();
+        const Chunk &chunk = chunks[first + i];
+        const Chunk *neighbours[6];
+        for (int f = 0; f < 6; f++) {
+            glm::ivec3 coord = chunk.coord;
+            coord[f / 2] += (f & 1) ? 1 : -1;
+            bool inside = coord.x >= min.x && coord.y >= min.y && coord.z >= min.z && coord.x < max.x && coord.y < max.y && coord.z < max.z;
+            neighbours[f] = inside ? &chunks[index(coord)] : nullptr;
+        }
+        mesh(chunk, neighbours, true, meshes[first + i]);
+        simplify(chunk, neighbours, meshes[first + i]);
+        meshNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    });
+    double elapsed = meshNanoseconds.load() / 1e6;
+
+    // Scaled to the chunk size around its centre, so culling sees the whole chunk
+    std::size_t triangles = 0;
+    for (std::size_t i = first; i < first + count; i++) {
+        if (meshes[i].indices.empty()) {
+            continue;
+        }
+        glm::vec3 centre = glm::vec3(chunks[i].coord * N) + glm::vec3(N * 0.5f - 0.5f);
+        std::size_t instance = Scene::add(centre, glm::vec3((float)N), Scene::CHUNK);
+        Scene::instances[instance].mesh = (std::uint32_t)i;
+        std::copy(meshes[i].levelError, meshes[i].levelError + Lod::LEVELS, Scene::instances[instance].lodError);
+        triangles += meshes[i].levelStart[1] / 3;
+    }
+
+    Stats::set("voxel_chunks", (double)chunks.size());
+    Stats::set("voxel_triangles", (double)triangles);
+    Stats::set("voxel_mesh_ms", count > 0 ? elapsed / count : 0.0);
+}
+
+void Voxels::clear() {
+    chunks.clear();
+    meshes.clear();
+}
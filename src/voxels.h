@@ -0,0 +1,77 @@
+#pragma once
+
+#include "./lod.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Voxel world made of fixed size chunks of block IDs. Each chunk is meshed
+ * into one indexed triangle list in the cube's vertex layout (position,
+ * texture, normal): faces between two solid blocks are dropped, and with
+ * greedy meshing the remaining coplanar faces are merged into as few
+ * rectangles as possible. Every block is drawn with the same texture, so
+ * faces of different blocks merge too. Texture coordinates follow the cube's
+ * orientation per face in block units, so the wall texture repeats once per
+ * block across merged faces. Coarser levels for distant chunks are
+ * simplified from the faces before merging, which meet at shared corners
+ * where merged rectangles would leave T-junctions, and go after level 0 in
+ * the same buffers. Chunks become scene instances of the CHUNK material
+ * scaled to the chunk size, and the renderer uploads their meshes on first
+ * use.
+ */
+
+namespace Voxels {
+    const int CHUNK_SIZE = 32;
+    const int CHUNK_BLOCKS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+    // Block IDs, only AIR or not matters to the mesh
+    enum Block : std::uint8_t {
+        AIR,
+        STONE,
+        DIRT,
+        GRASS
+    };
+
+    struct Chunk {
+        glm::ivec3 coord;                   // In chunks, the chunk's first block is coord * CHUNK_SIZE
+        std::vector<std::uint8_t> blocks;   // x fastest, then z, then y
+
+        std::uint8_t at(int x, int y, int z) const {
+            return blocks[x + CHUNK_SIZE * (z + CHUNK_SIZE * y)];
+        }
+    };
+
+    struct Mesh {
+        std::vector<float> vertices;        // Cube::vertSize per vertex, positions from -0.5 to 0.5 across the chunk
+        std::vector<std::uint32_t> indices;
+        std::uint32_t levelStart[Lod::LEVELS + 1];  // Level k's indices run from levelStart[k] to levelStart[k + 1]
+        float levelError[Lod::LEVELS];      // In blocks, negative for levels the mesh doesn't have
+        std::uint32_t revision;             // Changes whenever the mesh is rebuilt
+    };
+
+    // Chunks of the world and their meshes, indexed alike
+    extern std::vector<Chunk> chunks;
+    extern std::vector<Mesh> meshes;
+
+    // Fill a chunk with rolling terrain, the same for the same coord and seed
+    extern void generate(Chunk &chunk, unsigned int seed);
+
+    // Build the chunk's mesh. neighbours are the chunks across -x, +x, -y, +y, -z and +z,
+    // null where there is none, which leaves the faces on that border in
+    extern void mesh(const Chunk &chunk, const Chunk *const neighbours[6], bool greedy, Mesh &out);
+
+    // Append the coarser levels to a mesh built by mesh(). Vertices on the chunk's border stay
+    // where they are, so chunks at different levels still meet
+    extern void simplify(const Chunk &chunk, const Chunk *const neighbours[6], Mesh &out);
+
+    // Generate, mesh and simplify the chunks from min up to but not including max, one job per chunk,
+    // and add a CHUNK scene instance for every mesh that isn't empty
+    extern void build(const glm::ivec3 &min, const glm::ivec3 &max, unsigned int seed);
+
+    // Drop every chunk, the scene instances are the caller's
+    extern void clear();
+}
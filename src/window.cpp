@@ -1,5 +1,9 @@
 #include "./window.h"
 #include "./camera.h"
+#include "./rtpool.h"
+#include "./config.h"
+#include "./gl43.h"
+#include <iostream>
 #include <stdexcept>
 
 const unsigned int Window::SCR_WIDTH = 200,
@@ -12,17 +16,27 @@ float Window::lastX = Window::SCR_WIDTH / 2.0f,
 
 bool Window::firstMouse = true;
 
-GLFWwindow* Window::init(const std::string &title) {
+std::atomic<int> Window::framebufferWidth(Window::SCR_WIDTH),
+      Window::framebufferHeight(Window::SCR_HEIGHT);
+
+GLFWwindow* Window::init(const std::string &title, bool visible) {
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+
+    // GPU culling needs 4.3, without it the lit cubes go through the draw list like everything else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, Config::gpuCulling ? 4 : 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
     GLFWwindow* window = glfwCreateWindow(Window::SCR_WIDTH, Window::SCR_HEIGHT, title.c_str(), NULL, NULL);
+    if (window == NULL && Config::gpuCulling) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        window = glfwCreateWindow(Window::SCR_WIDTH, Window::SCR_HEIGHT, title.c_str(), NULL, NULL);
+    }
     if (window == NULL) {
         glfwTerminate();
         throw new std::runtime_error("Failed to create GLFW window");
@@ -33,18 +47,34 @@ GLFWwindow* Window::init(const std::string &title) {
     glfwSetCursorPosCallback(window, Window::mouse_callback);
     glfwSetScrollCallback(window, Window::scroll_callback);
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (visible) {
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         glfwTerminate();
         throw new std::runtime_error("Failed to initialize GLAD");
     }
+    if (Config::gpuCulling && !GL43::load((GL43::LoadProc)glfwGetProcAddress)) {
+        std::cout << "ERROR::WINDOW::GL_4_3_UNAVAILABLE" << std::endl;
+        Config::gpuCulling = false;
+    }
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    Window::framebufferWidth = width;
+    Window::framebufferHeight = height;
 
     return window;
 }
 
 void Window::framebuffer_size_callback(GLFWwindow*, int width, int height) {
-    glViewport(0, 0, width, height);
+    // Runs on the main thread which doesn't own the context, the render thread applies it
+    Window::framebufferWidth = width;
+    Window::framebufferHeight = height;
+
+    // Window sized render targets get reallocated lazily the next time they're used
+    RenderTargets::resize(width, height);
 }
 
 void Window::mouse_callback(GLFWwindow*, double xpos, double ypos) {
@@ -60,29 +90,41 @@ void Window::mouse_callback(GLFWwindow*, double xpos, double ypos) {
     lastX = xpos;
     lastY = ypos;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    // Queued for the next simulation step instead of moving the camera mid-frame
+    Input::push(Input::MOUSE_MOVE, glfwGetTime(), xoffset, yoffset);
 }
 
 void Window::scroll_callback(GLFWwindow*, double, double yoffset) {
-    camera.ProcessMouseScroll(yoffset);
+    Input::push(Input::SCROLL, glfwGetTime(), 0.0f, yoffset);
 }
 
-void Window::processInput(GLFWwindow* window) {
+Input::Summary Window::processInput(GLFWwindow* window, float stepLength) {
+    // Apply everything the callbacks queued since the last step in one go
+    Input::Summary input = Input::drain();
+    if (input.mouseX != 0.0f || input.mouseY != 0.0f) {
+        camera.ProcessMouseMovement(input.mouseX, input.mouseY);
+    }
+    if (input.scroll != 0.0f) {
+        camera.ProcessMouseScroll(input.scroll);
+    }
+
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
     if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-        camera.ProcessKeyboard(FORWARD, deltaTime);
+        camera.ProcessKeyboard(FORWARD, stepLength);
     }
     if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
+        camera.ProcessKeyboard(BACKWARD, stepLength);
     }
     if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-        camera.ProcessKeyboard(LEFT, deltaTime);
+        camera.ProcessKeyboard(LEFT, stepLength);
     }
     if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-        camera.ProcessKeyboard(RIGHT, deltaTime);
+        camera.ProcessKeyboard(RIGHT, stepLength);
     }
+
+    return input;
 }
 
 void Window::updateDeltaTime() {
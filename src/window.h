@@ -1,6 +1,8 @@
 #pragma once
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "./input.h"
+#include <atomic>
 #include <string>
 
 namespace Window {
@@ -11,12 +13,13 @@ namespace Window {
     // Variables
     extern float lastX, lastY, deltaTime, lastFrame;
     extern bool firstMouse;
+    extern std::atomic<int> framebufferWidth, framebufferHeight; // Written on resize, read by the render thread
 
     // Functions
-    GLFWwindow* init(const std::string &title);
+    GLFWwindow* init(const std::string &title, bool visible = true); // Hidden windows are for headless runs
     extern void updateDeltaTime();
     extern void framebuffer_size_callback(GLFWwindow* window, int width, int height);
     extern void mouse_callback(GLFWwindow* window, double xpos, double ypos);
     extern void scroll_callback(GLFWwindow* window, double xoffset, double yoffset); 
-    extern void processInput(GLFWwindow* window);
+    extern Input::Summary processInput(GLFWwindow* window, float stepLength); // Apply keys and queued events for one step
 }
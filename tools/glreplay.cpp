@@ -0,0 +1,162 @@
+// Replays a trace written with --gl-trace in a hidden window and times its frames.
+// With --compare the last replayed frame is read back and checked against an image
+// of the recorded frame, such as the golden one the recording bench run matched
+//
+//     glreplay <trace> [--loops=N] [--compare=<ppm>]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../src/gltrace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Same checks the bench applies to its golden images
+    const int TOLERANCE = 2;
+    const float MAX_MISMATCH = 0.001f;
+
+    // RGB, top row first
+    bool readImage(const std::string &path, int &width, int &height, std::vector<std::uint8_t> &pixels) {
+        std::ifstream file(path, std::ios::binary);
+        std::string magic;
+        int maxValue = 0;
+        if (!(file >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255) {
+            return false;
+        }
+        file.get();
+        pixels.resize((std::size_t)width * height * 3);
+        file.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+        return (bool)file;
+    }
+
+    bool writeImage(const std::string &path, int width, int height, const std::vector<std::uint8_t> &pixels) {
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n" << width << " " << height << "\n255\n";
+        file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        return (bool)file;
+    }
+
+    // Back buffer after the last replayed frame, flipped so the top row comes first
+    std::vector<std::uint8_t> readBackbuffer(int width, int height) {
+        std::vector<std::uint8_t> rows((std::size_t)width * height * 3), pixels(rows.size());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+
+        std::size_t stride = (std::size_t)width * 3;
+        for (int y = 0; y < height; y++) {
+            std::copy(rows.begin() + (height - 1 - y) * stride, rows.begin() + (height - y) * stride, pixels.begin() + y * stride);
+        }
+        return pixels;
+    }
+
+    // Returns whether the replayed frame matches the image at path, writing it next to the trace if not
+    bool compareFrame(const std::string &trace, const std::string &path, int width, int height) {
+        int goldenWidth, goldenHeight;
+        std::vector<std::uint8_t> golden;
+        if (!readImage(path, goldenWidth, goldenHeight, golden)) {
+            std::cout << "ERROR::GLREPLAY::IMAGE_MISSING " << path << std::endl;
+            return false;
+        }
+        if (goldenWidth != width || goldenHeight != height) {
+            std::cout << "ERROR::GLREPLAY::IMAGE_SIZE_MISMATCH " << path << std::endl;
+            return false;
+        }
+
+        std::vector<std::uint8_t> actual = readBackbuffer(width, height);
+        std::size_t mismatched = 0;
+        std::size_t count = (std::size_t)width * height;
+        for (std::size_t i = 0; i < count; i++) {
+            int worst = 0;
+            for (int c = 0; c < 3; c++) {
+                worst = std::max(worst, std::abs((int)actual[i * 3 + c] - (int)golden[i * 3 + c]));
+            }
+            if (worst > TOLERANCE) {
+                mismatched++;
+            }
+        }
+        float mismatch = count > 0 ? (float)mismatched / count : 0.0f;
+        bool pass = mismatch <= MAX_MISMATCH;
+        std::cout << "GLREPLAY::IMAGE " << (pass ? "PASS" : "FAIL") << " mismatch=" << mismatch << std::endl;
+        if (!pass) {
+            writeImage(trace + ".ppm", width, height, actual);
+        }
+        return pass;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string path;
+    std::string compare;
+    int loops = 10;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--loops=", 8) == 0) {
+            loops = std::atoi(argv[i] + 8);
+        } else if (std::strncmp(argv[i], "--compare=", 10) == 0) {
+            compare = argv[i] + 10;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path.empty() || loops <= 0) {
+        std::cout << "usage: glreplay <trace> [--loops=N] [--compare=<ppm>]" << std::endl;
+        return 2;
+    }
+
+    int width, height;
+    if (!GLTrace::readHeader(path, width, height)) {
+        std::cout << "ERROR::GLREPLAY::NOT_A_TRACE " << path << std::endl;
+        return 2;
+    }
+
+    // Same context the engine asks for, sized like the recording
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(width, height, "glreplay", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "ERROR::GLREPLAY::WINDOW_FAILED" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "ERROR::GLREPLAY::GLAD_FAILED" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    GLTrace::ReplayResult result;
+    bool ok = GLTrace::replay(path, loops, result);
+    if (ok) {
+        std::cout << "GLREPLAY::" << path << " " << width << "x" << height
+            << " frames=" << result.frames
+            << " median=" << result.medianMs << "ms"
+            << " p95=" << result.p95Ms << "ms"
+            << " calls/frame=" << result.calls << std::endl;
+        if (!compare.empty()) {
+            ok = compareFrame(path, compare, width, height);
+        }
+    }
+
+    glfwTerminate();
+    return ok ? 0 : 1;
+}